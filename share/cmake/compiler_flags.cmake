@@ -34,6 +34,13 @@ elseif( CMAKE_C_COMPILER_ID STREQUAL "Intel" )
   string( APPEND MY_CMAKE_C_FLAGS   " -std=c99"   )
 endif()
 
+# store quad geometry for mapped / curvilinear connectivities
+option( OCT_MAPPED_GEOMETRY "Store vertices, normals and face centroids of every quad." OFF )
+
+if( OCT_MAPPED_GEOMETRY )
+  string( APPEND MY_CMAKE_C_FLAGS   " -DOCT_MAPPED_GEOMETRY" )
+endif()
+
 
 #################################
 # Compiler Flags (Debug Mode)   #
@@ -0,0 +1,210 @@
+/*
+* This file is part of OctFS. 
+* OctFS is a finite-volume flow solver with adaptive
+* mesh refinement written in C, which is based on 
+* the p4est library.
+*
+* Copyright (C) 2020 Florian Setzwein 
+*
+* OctFS is free software; you can redistribute it and/or 
+* modify it under the terms of the GNU General Public 
+* License as published by the Free Software Foundation; 
+* either version 2 of the License, or (at your option) 
+* any later version.
+*
+* OctFS is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied 
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR 
+* PURPOSE.  See the GNU General Public License for more 
+* details.
+*
+* You should have received a copy of the GNU General 
+* Public License along with OctFS; if not, write to the 
+* Free Software Foundation, Inc., 51 Franklin Street, 
+* Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+#ifndef SOLVER_ADAPT_H
+#define SOLVER_ADAPT_H
+
+#ifndef P4_TO_P8
+#include <p4est_bits.h>
+#include <p4est_extended.h>
+#include <p4est_iterate.h>
+#else
+#include <p8est_bits.h>
+#include <p8est_extended.h>
+#include <p8est_iterate.h>
+#endif
+
+#include "solver/typedefs.h"
+#include "solver/simData.h"
+#include "solver/quadData.h"
+
+/***********************************************************
+* Grid adaptation indicators
+*-----------------------------------------------------------
+* The refinement criteria are evaluated for all local quads
+* in a single pass prior to p4est_refine_ext() and 
+* p4est_coarsen_ext(). 
+* The combined indicator of every quad (see 
+* adaptIndicator()) is stored in the flat array 
+* simData->indicator (indexed by the local quad index)
+* and the resulting decision is stored as AdaptFlag in 
+* the quad data. The refinement and coarsening callbacks
+* globalRefinement() and globalCoarsening() only look up 
+* this flag. 
+* Quads that are created during the adaptation carry the 
+* flag ADAPT_UNSET and are evaluated directly by the 
+* callbacks (e.g. for recursive refinement).
+*
+* In budget mode (solverParam->quadTarget > 0), the 
+* refinement and coarsening thresholds are chosen from the
+* global distribution of the indicators, such that the 
+* number of quads approaches its target.
+* With solverParam->quadMax > 0, the refinement flags of
+* all sources are capped after the indicator pass and 
+* quads created during the adaptation are refined only 
+* within the remaining budget (simData->refineBudget).
+* Only the 2:1 balance may exceed quadMax.
+*
+* With predictive refinement (solverParam->predictRefine), 
+* quads are also refined, if a feature is advected into 
+* them within the next solverParam->refinePeriod steps.
+***********************************************************/
+
+/***********************************************************
+* Number of histogram bins for the global indicator 
+* distribution in budget mode
+***********************************************************/
+#define OCT_BUDGET_BINS 256
+
+/***********************************************************
+* Maximum number of neighbour sweeps for the predictive 
+* refinement ahead of advected features
+***********************************************************/
+#define OCT_PREDICT_MAX_SWEEPS 16
+
+/***********************************************************
+* Hysteresis between refinement and coarsening
+*-----------------------------------------------------------
+* The indicators of adaptIndicator() scale with h^4 for 
+* a given gradient. A family is only coarsened, 
+* if the estimate for the coarse quad 
+*   OCT_COARSEN_ERR_FAC * max(children indicators) 
+* is below solverParam->coarsenRatio times the refinement
+* threshold. With coarsenRatio < 1, a coarsened quad is 
+* not flagged for refinement again by the next 
+* adaptation.
+* Quads that have been created by refinement can not be 
+* coarsened within solverParam->minRefineAge adaptations
+* (QuadData_t->adaptAge).
+***********************************************************/
+#define OCT_COARSEN_ERR_FAC 16.0
+#define OCT_ADAPT_AGE_MAX   (1 << 20)
+
+/***********************************************************
+* Transfer of the state between grid levels
+*-----------------------------------------------------------
+* The state variables (vars[OCT_SOLVER_VARS .. 
+* OCT_MAX_VARS-1]) are restricted to a coarsened quad 
+* by a volume-weighted average, and prolongated to the
+* children of a refined quad with a gradient, that is 
+* limited by a Barth-Jespersen limiter (prolongLim) prior
+* to the adaptation.
+* The limiter bounds the reconstruction within the entire
+* quad by the extrema of the quad and its face neighbours.
+* Hence, the prolongation creates no new extrema for quads
+* refined by the flags, by the 2:1 balance or recursively
+* (grandchildren). Quads, that are refined after being 
+* coarsened within the same adaptation, are prolongated 
+* piecewise constant. Only for mapped geometries, the 
+* correction of the children state to the exact volume 
+* integral may exceed the bounds slightly.
+* Both operators conserve the volume integral of the 
+* state (see interpQuadData()).
+***********************************************************/
+#define OCT_STATE_VARS (OCT_MAX_VARS - OCT_SOLVER_VARS)
+
+/***********************************************************
+* adaptIndicator()
+*-----------------------------------------------------------
+* Combined refinement indicator of a quad for the passive
+* scalar, pressure, vorticity and velocity jump criteria.
+* Quads with an indicator > 1 are refined.
+***********************************************************/
+octDouble adaptIndicator(SolverParam_t    *solverParam,
+                         p4est_quadrant_t *q);
+
+/***********************************************************
+* coarsenByHysteresis()
+*-----------------------------------------------------------
+* Coarsening criterion of a family with the indicator 
+* <famInd> for the refinement threshold <refThresh>
+***********************************************************/
+int coarsenByHysteresis(octDouble famInd, 
+                        octDouble refThresh, 
+                        octDouble coarsenRatio);
+
+/***********************************************************
+* indicatorBin()
+*-----------------------------------------------------------
+* Histogram bin of an indicator for the log10-range 
+* <lRange>. Indicators <= 0 are sorted into bin 0.
+***********************************************************/
+int indicatorBin(octDouble ind, const octDouble *lRange);
+
+/***********************************************************
+* binEdge()
+*-----------------------------------------------------------
+* Lower indicator bound of a histogram bin
+***********************************************************/
+octDouble binEdge(int bin, const octDouble *lRange);
+
+/***********************************************************
+* histRefineThresh()
+*-----------------------------------------------------------
+* Lowest refinement threshold of an indicator histogram,
+* such that no more than <n> quads are above it
+***********************************************************/
+octDouble histRefineThresh(const long      *hist, 
+                           long             n, 
+                           const octDouble *lRange);
+
+/***********************************************************
+* histCoarsenThresh()
+*-----------------------------------------------------------
+* Highest coarsening threshold of an indicator histogram,
+* such that no more than <n> families are below it
+***********************************************************/
+octDouble histCoarsenThresh(const long      *hist, 
+                            long             n, 
+                            const octDouble *lRange);
+
+/***********************************************************
+* computeAdaptFlags()
+*-----------------------------------------------------------
+* Computes the refinement indicator and the refine /
+* coarsen / keep flag for every local quad
+***********************************************************/
+void computeAdaptFlags(SimData_t *simData, long nFlagged[2]);
+
+/***********************************************************
+* limitProlongation()
+*-----------------------------------------------------------
+* Computes the limiters of the state gradients for the 
+* prolongation of all local quads to their children 
+* (QuadData_t->prolongLim)
+***********************************************************/
+void limitProlongation(SimData_t *simData);
+
+/***********************************************************
+* adaptMesh()
+*-----------------------------------------------------------
+* Refines, coarsens and balances the grid according to the
+* flags of computeAdaptFlags(). 
+* Returns the global number of created quads.
+***********************************************************/
+p4est_gloidx_t adaptMesh(SimData_t *simData);
+
+
+#endif /* SOLVER_ADAPT_H */
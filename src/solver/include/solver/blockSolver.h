@@ -0,0 +1,150 @@
+/*
+* This file is part of OctFS. 
+* OctFS is a finite-volume flow solver with adaptive
+* mesh refinement written in C, which is based on 
+* the p4est library.
+*
+* Copyright (C) 2020 Florian Setzwein 
+*
+* OctFS is free software; you can redistribute it and/or 
+* modify it under the terms of the GNU General Public 
+* License as published by the Free Software Foundation; 
+* either version 2 of the License, or (at your option) 
+* any later version.
+*
+* OctFS is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied 
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR 
+* PURPOSE.  See the GNU General Public License for more 
+* details.
+*
+* You should have received a copy of the GNU General 
+* Public License along with OctFS; if not, write to the 
+* Free Software Foundation, Inc., 51 Franklin Street, 
+* Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+#ifndef SOLVER_BLOCKSOLVER_H
+#define SOLVER_BLOCKSOLVER_H
+
+#ifndef P4_TO_P8
+#include <p4est_bits.h>
+#include <p4est_extended.h>
+#include <p4est_iterate.h>
+#else
+#include <p8est_bits.h>
+#include <p8est_extended.h>
+#include <p8est_iterate.h>
+#endif
+
+#include "solver/typedefs.h"
+#include "solver/simData.h"
+#include "solver/quadData.h"
+
+/***********************************************************
+* Block solver for transport equations 
+*-----------------------------------------------------------
+* Several transport equations that share the same operator
+* (e.g. the velocity components of the momentum equation,
+* which are all convected with the same massfluxes) are 
+* solved together by a multiple right hand side BiCGSTAB 
+* solver. 
+* Every component is iterated with its own scalars, but
+*   - the operator is applied to all components in a 
+*     single traversal of the forest,
+*   - the ghost values of all components are exchanged in
+*     one message, that only contains the operand 
+*     (p4est_ghost_exchange_custom()),
+*   - the scalar products of all components are reduced
+*     in a single reduction.
+* The Krylov vectors are stored in a flat array indexed 
+* by the local quad index, such that the solver buffers 
+* of the quad data are not required.
+***********************************************************/
+
+/***********************************************************
+* Maximum number of right hand sides
+***********************************************************/
+#define OCT_BLOCK_MAX_RHS 3
+
+/***********************************************************
+* Krylov vectors of the block solver
+***********************************************************/
+typedef enum
+{
+  BX,   /* Solution                                       */
+  BB,   /* Right hand side b                              */
+  BAX,  /* Product Ax                                     */
+  BR,   /* Residual (b - Ax)                              */
+  BR0,  /* Residual at iteration 0                        */
+  BP,   /* Direction for new solution                     */
+  BV,   /* A*p                                            */
+  BH,   /* x + alpha * p                                  */
+  BS,   /* r - alpha * v                                  */
+  BT,   /* A*s                                            */
+  OCT_BLOCK_BUFS
+} BlockBufIndex;
+
+/***********************************************************
+* Structure containing a block equation system
+***********************************************************/
+typedef struct BlockSystem_t
+{
+  SimData_t      *simData;
+
+  /* Number of right hand sides and their variables */
+  int             nRhs;
+  int             xIds[OCT_BLOCK_MAX_RHS];
+
+  /* Number of local quads */
+  p4est_locidx_t  nLocal;
+
+  /* Krylov vectors [nLocal][OCT_BLOCK_BUFS][nRhs] */
+  octDouble      *buf;
+
+  /* Ghost values of the operand [nGhosts][nRhs] */
+  octDouble      *ghostBuf;
+
+  /* Pointers to the operand of every mirror quad */
+  void          **mirrorBuf;
+
+  /* Flux factor of the temporal scheme */
+  octDouble       fluxFac;
+
+  /* Timestep */
+  octDouble       dt;
+
+  /* Operand and result of the operator application */
+  int             xBuf;
+  int             AxBuf;
+
+} BlockSystem_t;
+
+/***********************************************************
+* linSolve_bicgstabBlock()
+*-----------------------------------------------------------
+* Iterative solver for the block equation system 
+*
+*   A X = B
+*
+* using a biconjugate gradient stabilized method with 
+* multiple right hand sides.
+* The solution of each right hand side is iterated until
+* it has converged, the iteration stops as soon as all
+* solutions have converged.
+***********************************************************/
+void linSolve_bicgstabBlock(BlockSystem_t *sys);
+
+/***********************************************************
+* solveTranEqBlock()
+*-----------------------------------------------------------
+* Function to solve the transport equations for the
+* <nRhs> variables <xIds>, which share the same operator.
+* Implicit schemes use linSolve_bicgstabBlock(), explicit
+* schemes solve every variable with solveTranEq().
+***********************************************************/
+void solveTranEqBlock(SimData_t *simData, 
+                      const int *xIds, 
+                      int        nRhs);
+
+
+#endif /* SOLVER_BLOCKSOLVER_H */
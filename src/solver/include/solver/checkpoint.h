@@ -0,0 +1,103 @@
+/*
+* This file is part of OctFS. 
+* OctFS is a finite-volume flow solver with adaptive
+* mesh refinement written in C, which is based on 
+* the p4est library.
+*
+* Copyright (C) 2020 Florian Setzwein 
+*
+* OctFS is free software; you can redistribute it and/or 
+* modify it under the terms of the GNU General Public 
+* License as published by the Free Software Foundation; 
+* either version 2 of the License, or (at your option) 
+* any later version.
+*
+* OctFS is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied 
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR 
+* PURPOSE.  See the GNU General Public License for more 
+* details.
+*
+* You should have received a copy of the GNU General 
+* Public License along with OctFS; if not, write to the 
+* Free Software Foundation, Inc., 51 Franklin Street, 
+* Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+#ifndef SOLVER_CHECKPOINT_H
+#define SOLVER_CHECKPOINT_H
+
+#ifndef P4_TO_P8
+#include <p4est_bits.h>
+#include <p4est_extended.h>
+#else
+#include <p8est_bits.h>
+#include <p8est_extended.h>
+#endif
+
+#include "solver/typedefs.h"
+#include "solver/simData.h"
+
+/***********************************************************
+* Checkpoint files
+*-----------------------------------------------------------
+* A checkpoint consists of two files:
+*
+*   <prefix>_<step>.chk      p4est forest, connectivity and 
+*                            quad data (p4est_save_ext())
+*   <prefix>_<step>.chk.hdr  ChkHeader_t (written by rank 0)
+*
+* The forest is stored without partition, such that a 
+* simulation can be restarted on any number of processes.
+***********************************************************/
+#define OCT_CHK_MAGIC   "OCTCHK"
+#define OCT_CHK_VERSION 2
+
+/***********************************************************
+* Checkpoint header
+*-----------------------------------------------------------
+* Only plain scalar values are stored, that are restored 
+* or compared on restart. All other parameters are taken
+* from the parameter file.
+***********************************************************/
+typedef struct ChkHeader_t
+{
+  char      magic[8];
+  int32_t   version;
+  int32_t   dim;
+  int32_t   quadDataSize;
+
+  /* Number of completed timesteps */
+  int32_t   step;
+
+  /* Simulation time */
+  double    simTime;
+
+  /* Timestep at the time of the checkpoint */
+  double    timestep;
+
+} ChkHeader_t;
+
+/***********************************************************
+* writeCheckpoint()
+*-----------------------------------------------------------
+* Function to write a checkpoint of the simulation after 
+* <step> completed timesteps
+***********************************************************/
+void writeCheckpoint(SimData_t *simData, int step);
+
+/***********************************************************
+* loadCheckpoint()
+*-----------------------------------------------------------
+* Function to load the forest, the connectivity and the 
+* quad data of a checkpoint file. 
+* The simulation time and the step counter are restored 
+* from the checkpoint header, all other parameters are 
+* taken from the parameter file.
+* Returns the loaded p4est structure and its connectivity
+* in <conn>.
+***********************************************************/
+p4est_t *loadCheckpoint(SimData_t            *simData,
+                        const char           *filename,
+                        p4est_connectivity_t **conn);
+
+#endif /* SOLVER_CHECKPOINT_H */
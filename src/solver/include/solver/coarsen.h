@@ -41,6 +41,16 @@
 #include "solver/typedefs.h"
 #include "solver/util.h"
 
+/***********************************************************
+* coarsening_scalarError()
+*-----------------------------------------------------------
+* Function to calculate the error estimate for the mesh
+* coarsening 
+***********************************************************/
+int coarsening_scalarError(p4est_t *p4est,
+                           p4est_topidx_t which_tree,
+                           p4est_quadrant_t * children[]);
+
 /***********************************************************
 * globalCoarsening()
 *-----------------------------------------------------------
@@ -41,6 +41,84 @@
 #include "solver/typedefs.h"
 #include "solver/simData.h"
 
+/***********************************************************
+* Snapshot file format
+*-----------------------------------------------------------
+* A snapshot is a single binary file (native byte order), 
+* which is written collectively by all processes:
+*
+*   SnapHeader_t                     (written by rank 0)
+*   SnapQuad_t     [nQuads]          (quadrant layout)
+*   double         [nVars][nQuads]   (one array per variable)
+*
+* Quadrants are stored in the global p4est ordering, hence
+* every process writes its data at the offsets given by 
+* p4est->global_first_quadrant.
+***********************************************************/
+#define OCT_SNAP_MAGIC   "OCTSNAP"
+#define OCT_SNAP_VERSION 1
+
+typedef struct SnapHeader_t
+{
+  char      magic[8];
+  int32_t   version;
+  int32_t   dim;
+  int32_t   nVars;
+  int32_t   step;
+  int64_t   nQuads;
+  double    simTime;
+  char      varNames[OCT_MAX_VARS][OCT_VARNAME_LENGTH];
+
+} SnapHeader_t;
+
+typedef struct SnapQuad_t
+{
+  int32_t   tree;
+  int32_t   level;
+  int32_t   xyz[3]; /* Morton coordinates, z=0 in 2D */
+
+} SnapQuad_t;
+
+/***********************************************************
+* Asynchronous snapshot writer
+*-----------------------------------------------------------
+* A snapshot slot holds a staged copy of the solution and 
+* the pending non-blocking MPI-IO requests of its file.
+* The writer cycles through OCT_IO_BUFFERS slots (double
+* buffering), such that the solver can continue while 
+* the previous snapshot is still being written.
+***********************************************************/
+#define OCT_IO_BUFFERS 2
+
+typedef struct SnapSlot_t
+{
+  octBool         active;
+  MPI_File        fh;
+  int             nReq;
+  MPI_Request     req[OCT_MAX_VARS+2];
+  SnapHeader_t    header;
+
+  p4est_locidx_t  numquads;
+  p4est_gloidx_t  nGlob;
+  p4est_gloidx_t  offset;
+  SnapQuad_t     *layout;
+  double         *data;
+
+  /* Staging size (maximum over all processes) */
+  long            bytes;
+
+} SnapSlot_t;
+
+struct AsyncWriter_t
+{
+  SnapSlot_t  slot[OCT_IO_BUFFERS];
+  /* Index of the next slot to use */
+  int         next;
+  /* Staging memory budget per process in bytes */
+  long        budget;
+
+};
+
 
 /***********************************************************
 * Function to concatenate two strings.
@@ -53,31 +131,86 @@
 char *concat_string(const char *str_1, const char *str_2);
 
 /***********************************************************
-* Callback function for interpolating the solution from 
-* quadrant midpoints to corners.
+* gatherSolution()
+*-----------------------------------------------------------
+* Callback function for gathering the output variables 
+* of a quadrant into the cell data arrays.
 *
-* The function p4est_iterate() takes as an argument a 
-* p4est_iter_volume_t callback function, which it executes at 
-* every local quadrant (see p4est_iterate.h).  
 * This function matches the p4est_iter_volume_t prototype.
 *
-* Use the callback function to interpolate the state
-* variable to the corners, and write those corners into an 
-* array so that they can be written out.
+* All output variables are gathered in a single traversal
+* of the mesh.
 *-----------------------------------------------------------
 * Arguments:
 * *info       : the information about this quadrant that 
 *               has been  populated by p4est_iterate()
 * user_data   : the user_data that was given as an argument to
 *               p4est_iterate: in this case, it points to the
-*               array of corner values that we want to write.
-*               The values for the corner of the quadrant
-*               described by a info are written during the
-*               execution of the callback.
+*               array of cell data arrays (one for every 
+*               output variable) that we want to write.
 *
 ***********************************************************/
-static void interpolate_solution(p4est_iter_volume_info_t *info, 
-                                 void *user_data);
+void gatherSolution(p4est_iter_volume_info_t *info, 
+                    void *user_data);
+
+/***********************************************************
+* gatherLayout()
+*-----------------------------------------------------------
+* Callback function for gathering the tree, level and 
+* coordinates of a quadrant into the snapshot layout array.
+*   -> p4est_iter_volume_t callback function
+***********************************************************/
+void gatherLayout(p4est_iter_volume_info_t *info, 
+                  void *user_data);
+
+/***********************************************************
+* writeSolution()
+*-----------------------------------------------------------
+* Function to write the solution of a single timestep 
+* in the output format chosen in the parameter file
+***********************************************************/
+void writeSolution(SimData_t *simData, int step);
+
+/***********************************************************
+* writeSolutionSnapshot()
+*-----------------------------------------------------------
+* Function to write the solution of a single timestep 
+* to a single snapshot file using MPI-IO
+***********************************************************/
+void writeSolutionSnapshot(SimData_t *simData, int step);
+
+/***********************************************************
+* init_asyncWriter()
+*-----------------------------------------------------------
+* Creates an asynchronous snapshot writer with 
+* OCT_IO_BUFFERS staging slots. At most <budget> bytes
+* per process are used for staging.
+***********************************************************/
+AsyncWriter_t *init_asyncWriter(long budget);
+
+/***********************************************************
+* destroy_asyncWriter()
+*-----------------------------------------------------------
+* Completes all pending snapshots and frees the writer
+***********************************************************/
+void destroy_asyncWriter(AsyncWriter_t *writer);
+
+/***********************************************************
+* flushAsyncWriter()
+*-----------------------------------------------------------
+* Completes all pending snapshots of the writer, 
+* starting with the oldest one
+***********************************************************/
+void flushAsyncWriter(AsyncWriter_t *writer);
+
+/***********************************************************
+* writeSolutionAsync()
+*-----------------------------------------------------------
+* Function to write the solution of a single timestep 
+* to a single snapshot file in the background, while 
+* the solver continues with the next timesteps
+***********************************************************/
+void writeSolutionAsync(SimData_t *simData, int step);
 
 /***********************************************************
 * writeSolutionVtk()
@@ -40,6 +40,20 @@
 #include "solver/simData.h"
 #include "solver/quadData.h"
 
+/***********************************************************
+* Ghost layer connectivity that is required by the 
+* convective flux stencil (face neighbours only)
+***********************************************************/
+#define FLUXCONV_STENCIL P4EST_CONNECT_FACE
+
+/***********************************************************
+* Funtion to determine the upwind element. 
+* var_out is the element with the outward facing normal
+* var_in is the element with the inward facing normal.
+***********************************************************/
+#define UPWIND_DIR(mflux, var_out, var_in) \
+  ( (mflux) > 0.0 ? (var_out) : (var_in) )
+
 /***********************************************************
 * addFlux_conv_imp()
 *-----------------------------------------------------------
@@ -52,10 +66,11 @@
 * *info      : Information about this quadrant that has 
 *              been populated by the p4est_iterate()
 * *user_data : user_data that is given to p4est_iterate,
-*              in this case, it points to the ghost_data
-*              array, which contains the SimVars_t data
-*              for all of the ghost cells, that has been 
-*              populated by p4est_ghost_exchange_data
+*              in this case, it points to the kernel 
+*              context (KernelCtx_t) with the variable and
+*              buffer indices, the flux factor and the 
+*              ghost data, that has been populated by 
+*              p4est_ghost_exchange_data
 *
 ***********************************************************/
 void addFlux_conv_imp(p4est_iter_face_info_t *info,
@@ -0,0 +1,99 @@
+/*
+* This file is part of OctFS. 
+* OctFS is a finite-volume flow solver with adaptive
+* mesh refinement written in C, which is based on 
+* the p4est library.
+*
+* Copyright (C) 2020 Florian Setzwein 
+*
+* OctFS is free software; you can redistribute it and/or 
+* modify it under the terms of the GNU General Public 
+* License as published by the Free Software Foundation; 
+* either version 2 of the License, or (at your option) 
+* any later version.
+*
+* OctFS is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied 
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR 
+* PURPOSE.  See the GNU General Public License for more 
+* details.
+*
+* You should have received a copy of the GNU General 
+* Public License along with OctFS; if not, write to the 
+* Free Software Foundation, Inc., 51 Franklin Street, 
+* Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+#ifndef SOLVER_GEOMETRY_H
+#define SOLVER_GEOMETRY_H
+
+#ifndef P4_TO_P8
+#include <p4est_bits.h>
+#include <p4est_extended.h>
+#include <p4est_iterate.h>
+#else
+#include <p8est_bits.h>
+#include <p8est_extended.h>
+#include <p8est_iterate.h>
+#endif
+
+#include "solver/typedefs.h"
+#include "solver/util.h"
+
+/***********************************************************
+* Structure containing the geometry of quads for every 
+* refinement level. 
+* Valid for connectivities, whose trees are axis-aligned 
+* and of equal size (e.g. periodic unit tree or brick).
+***********************************************************/
+typedef struct GeomTable_t
+{
+  // Edge lengths of a quad in every direction
+  octDouble h[P4EST_MAXLEVEL+1][P4EST_DIM];
+  // Area of the faces normal to every direction
+  octDouble area[P4EST_MAXLEVEL+1][P4EST_DIM];
+  // Volume of a quad
+  octDouble volume[P4EST_MAXLEVEL+1];
+
+} GeomTable_t;
+
+/***********************************************************
+* init_geomTable()
+*-----------------------------------------------------------
+* Initializes the per-level geometry table from the 
+* extents of the first tree in the connectivity
+***********************************************************/
+GeomTable_t *init_geomTable(p4est_connectivity_t *conn);
+
+/***********************************************************
+* destroy_geomTable()
+*-----------------------------------------------------------
+* Frees all memory of a GeomTable structure
+***********************************************************/
+void destroy_geomTable(GeomTable_t *geomTable);
+
+/***********************************************************
+* geom_centroid()
+*-----------------------------------------------------------
+* Computes the centroid of a quad from its coordinates
+***********************************************************/
+void geom_centroid(p4est_t          *p4est,
+                   p4est_topidx_t    which_tree,
+                   p4est_quadrant_t *q,
+                   octDouble         xc[P4EST_DIM]);
+
+/***********************************************************
+* geom_faceNormal()
+*-----------------------------------------------------------
+* Returns the outward facing normal of face <face> of 
+* quad <q>, scaled by the face area.
+* The normal is computed from the refinement level of the
+* quad, unless OCT_MAPPED_GEOMETRY is defined. In this case
+* the normals stored in <quadData> are used.
+***********************************************************/
+void geom_faceNormal(SimData_t        *simData,
+                     p4est_quadrant_t *q,
+                     QuadData_t       *quadData,
+                     int               face,
+                     octDouble         normal[P4EST_DIM]);
+
+#endif /* SOLVER_GEOMETRY_H */
@@ -42,6 +42,12 @@
 #include "solver/simData.h"
 #include "solver/quadData.h"
 
+/***********************************************************
+* Ghost layer connectivity that is required by the 
+* Green-Gauss gradient stencil (face neighbours only)
+***********************************************************/
+#define GRADIENTS_STENCIL P4EST_CONNECT_FACE
+
 /***********************************************************
 * resetDerivatives()
 *-----------------------------------------------------------
@@ -49,6 +49,32 @@ typedef void (*computeAx) (SimData_t *simData,
                            int        xId,
                            int        sbufIdx);
 
+/***********************************************************
+* Arguments of a linear solver field operation
+*-----------------------------------------------------------
+* Passed as user_data to the callbacks linSolve_*_cb(), 
+* scalar results are accumulated in <sum>
+***********************************************************/
+typedef struct LinSolveOp_t
+{
+  int       aId;
+  int       bId;
+  int       cId;
+  octDouble w_a;
+  octDouble w_b;
+  octDouble sum;
+
+} LinSolveOp_t;
+
+/***********************************************************
+* linSolve_printResidual()
+*-----------------------------------------------------------
+* Function to print the calculated residual on the current
+* process
+***********************************************************/
+void linSolve_printResidual(int xId, int k, 
+                            octDouble r0, octDouble r);
+
 /***********************************************************
 * linSolve_exchangeScalarBuffer()
 *-----------------------------------------------------------
@@ -56,7 +82,7 @@ typedef void (*computeAx) (SimData_t *simData,
 * variable over all MPI processes 
 ***********************************************************/
 void linSolve_exchangeScalarBuffer(SimData_t      *simData, 
-                                   int             sbufId,
+                                   octDouble      *sbuf,
                                    sc_MPI_Datatype varType,
                                    sc_MPI_Op       mpiType);
 
@@ -69,10 +95,10 @@ void linSolve_exchangeScalarBuffer(SimData_t      *simData,
 *
 *   c = a_i * b_i
 *
-* and store the in a scalar variable c.
+* and return the global result c.
 ***********************************************************/
-void linSolve_scalarProd(SimData_t *simData, 
-                         int aId, int bId, int cId);
+octDouble linSolve_scalarProd(SimData_t *simData, 
+                              int aId, int bId);
 
 /***********************************************************
 * linSolve_fieldProd()
@@ -95,11 +121,11 @@ void linSolve_fieldProd(SimData_t *simData,
 *
 *   c = w_a * a_i + w_b * b_i
 *
-* and store the in a scalar variable c.
+* and return the local result c.
 ***********************************************************/
-void linSolve_scalarSum(SimData_t *simData, 
-                        int aId, int bId, int cId,
-                        octDouble w_a, octDouble w_b);
+octDouble linSolve_scalarSum(SimData_t *simData, 
+                             int aId, int bId,
+                             octDouble w_a, octDouble w_b);
 
 /***********************************************************
 * linSolve_fieldSum()
@@ -206,10 +232,11 @@ void linSolve_bicgstab(SimData_t *simData,
 *-----------------------------------------------------------
 * Solve the equation system 
 *   A x = b
-* using an explicit method.
+* using an explicit method with timestep <dt>.
 ***********************************************************/
 void solve_explicit_sequential(SimData_t *simData, 
-                               int        xId);
+                               int        xId,
+                               octDouble  dt);
 
 /***********************************************************
 * solve_implicit_sequential()
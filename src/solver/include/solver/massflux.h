@@ -40,6 +40,12 @@
 #include "solver/simData.h"
 #include "solver/quadData.h"
 
+/***********************************************************
+* Ghost layer connectivity that is required by the 
+* mass flux stencil (face neighbours only)
+***********************************************************/
+#define MASSFLUX_STENCIL P4EST_CONNECT_FACE
+
 /***********************************************************
 * resetMasflux()
 *-----------------------------------------------------------
@@ -65,6 +71,20 @@ void resetMassflux(p4est_iter_volume_info_t *info,
 void computeMassflux(p4est_iter_face_info_t *info,
                      void                   *user_data);
 
+/***********************************************************
+* computeCourantRate()
+*-----------------------------------------------------------
+* Function to compute the CFL number of a quad for a unit 
+* timestep from its mass fluxes and volume. The maximum 
+* over all local quads is accumulated in the kernel 
+* context (KernelCtx_t.courantRate), the maximum for 
+* local time stepping in KernelCtx_t.courantRateSub.
+*
+*   -> p4est_iter_volume_t callback function
+***********************************************************/
+void computeCourantRate(p4est_iter_volume_info_t *info,
+                        void                     *user_data);
+
 /***********************************************************
 * initMassfluxes()
 *-----------------------------------------------------------
@@ -109,6 +109,27 @@ int octParam_readParamfile(SimData_t  *simData,
 int octParam_initParameters(SimData_t *simData,
                             octParam  *paramFile);
 
+/*************************************************************
+* octParam_readInstructions()
+*-------------------------------------------------------------
+* Function to read all parameters of an instruction array
+* <inst> from the parameter file. The array has 
+* OCT_MAX_PARAMETERS entries, unused entries have an empty 
+* instruction string.
+* Returns TRUE if a mandatory parameter is missing.
+*************************************************************/
+int octParam_readInstructions(octParam     *paramFile,
+                              octParamInst *inst);
+
+/*************************************************************
+* octParam_tempScheme()
+*-------------------------------------------------------------
+* Function to convert the name of a temporal discretization 
+* scheme into its TempScheme identifier (or AUTOMATIC_SCHEME).
+* Returns -1 for unknown schemes.
+*************************************************************/
+int octParam_tempScheme(bstring name);
+
 /*************************************************************
 * Function to create a new parameter file reader structure
 *************************************************************/
@@ -178,4 +199,16 @@ int octParam_extractArray(struct bstrList *txtlist,
                          const char *fltr, int type,
                          void *value);
 
+/*************************************************************
+* Function reads up to <nvals> comma separated double values
+* behind the specifier <fltr> in a single line.
+*
+* Returns the number of values, that have been read.
+* Returns -1 if the specifier is not found in the line.
+*************************************************************/
+int octParam_readValues(bstring     line,
+                        const char *fltr,
+                        octDouble  *v,
+                        int         nvals);
+
 #endif
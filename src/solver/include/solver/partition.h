@@ -0,0 +1,105 @@
+/*
+* This file is part of OctFS. 
+* OctFS is a finite-volume flow solver with adaptive
+* mesh refinement written in C, which is based on 
+* the p4est library.
+*
+* Copyright (C) 2020 Florian Setzwein 
+*
+* OctFS is free software; you can redistribute it and/or 
+* modify it under the terms of the GNU General Public 
+* License as published by the Free Software Foundation; 
+* either version 2 of the License, or (at your option) 
+* any later version.
+*
+* OctFS is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied 
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR 
+* PURPOSE.  See the GNU General Public License for more 
+* details.
+*
+* You should have received a copy of the GNU General 
+* Public License along with OctFS; if not, write to the 
+* Free Software Foundation, Inc., 51 Franklin Street, 
+* Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+#ifndef SOLVER_PARTITION_H
+#define SOLVER_PARTITION_H
+
+#ifndef P4_TO_P8
+#include <p4est_bits.h>
+#include <p4est_extended.h>
+#include <p4est_iterate.h>
+#else
+#include <p8est_bits.h>
+#include <p8est_extended.h>
+#include <p8est_iterate.h>
+#endif
+
+#include "solver/typedefs.h"
+#include "solver/simData.h"
+#include "solver/quadData.h"
+
+/***********************************************************
+* Structure containing the persistent quad data that is 
+* sent to other processes during repartitioning.
+* Geometry, gradients and solver buffers are rebuilt 
+* locally after the transfer.
+*
+* All other fields of QuadData_t are reset by 
+* init_quadFlowData() on the receiving process. A field 
+* that is added to QuadData_t and that must survive a 
+* repartitioning has to be added here and to 
+* packPartData() / unpackPartData(). 
+* Persistent fields of QuadData_t:
+*   - mflux
+*   - vars[OCT_SOLVER_VARS .. OCT_MAX_VARS-1]
+*   - adaptAge
+***********************************************************/
+typedef struct PartData_t
+{
+  // Masfluxes
+  octDouble mflux[2*P4EST_DIM];
+  // State variables (without solver buffers)
+  octDouble vars[OCT_MAX_VARS-OCT_SOLVER_VARS];
+  // Number of adaptations since refinement
+  int       adaptAge;
+
+} PartData_t;
+
+/***********************************************************
+* packPartData()
+*-----------------------------------------------------------
+* Copies the persistent data of a quadrant into the 
+* partition send buffer
+*   -> p4est_iter_volume_t callback function
+***********************************************************/
+void packPartData(p4est_iter_volume_info_t *info,
+                  void *user_data);
+
+/***********************************************************
+* unpackPartData()
+*-----------------------------------------------------------
+* Rebuilds the geometry of a quadrant and copies its 
+* persistent data from the partition receive buffer
+*   -> p4est_iter_volume_t callback function
+***********************************************************/
+void unpackPartData(p4est_iter_volume_info_t *info,
+                    void *user_data);
+
+/***********************************************************
+* partitionGrid()
+*-----------------------------------------------------------
+* Repartitions the grid among all processes. 
+* The new partition is computed for a copy of the forest 
+* without quadrant data. If no quadrant is moved, the 
+* forest is kept as it is. Otherwise, only the persistent 
+* quad data (PartData_t) is sent, the copy replaces the 
+* forest (simData->p4est) and geometry, gradients and the
+* ghost layer are recomputed afterwards.
+*
+* Returns the global number of shipped quadrants.
+***********************************************************/
+p4est_gloidx_t partitionGrid(SimData_t *simData);
+
+#endif /* SOLVER_PARTITION_H */
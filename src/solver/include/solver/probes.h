@@ -0,0 +1,168 @@
+/*
+* This file is part of OctFS. 
+* OctFS is a finite-volume flow solver with adaptive
+* mesh refinement written in C, which is based on 
+* the p4est library.
+*
+* Copyright (C) 2020 Florian Setzwein 
+*
+* OctFS is free software; you can redistribute it and/or 
+* modify it under the terms of the GNU General Public 
+* License as published by the Free Software Foundation; 
+* either version 2 of the License, or (at your option) 
+* any later version.
+*
+* OctFS is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied 
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR 
+* PURPOSE.  See the GNU General Public License for more 
+* details.
+*
+* You should have received a copy of the GNU General 
+* Public License along with OctFS; if not, write to the 
+* Free Software Foundation, Inc., 51 Franklin Street, 
+* Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+#ifndef SOLVER_PROBES_H
+#define SOLVER_PROBES_H
+
+#include <stdio.h>
+
+#ifndef P4_TO_P8
+#include <p4est_bits.h>
+#include <p4est_extended.h>
+#include <p4est_search.h>
+#else
+#include <p8est_bits.h>
+#include <p8est_extended.h>
+#include <p8est_search.h>
+#endif
+
+#include "solver/typedefs.h"
+#include "solver/simData.h"
+#include "solver/paramfile.h"
+
+#define OCT_MAX_PROBES 32
+
+/***********************************************************
+* Probe types
+*-----------------------------------------------------------
+* Probes are defined in the parameter file (one line per
+* probe, coordinates are always given in 3D):
+*
+*   Probe point: x, y, z
+*   Probe line:  x0, y0, z0, x1, y1, z1, n
+*   Probe plane: x0, y0, z0, ux, uy, uz, vx, vy, vz, nu, nv
+*
+* Lines and planes are resolved into n (nu*nv) equally 
+* spaced sample points.
+***********************************************************/
+typedef enum
+{
+  PROBE_POINT,
+  PROBE_LINE,
+  PROBE_PLANE
+} ProbeType;
+
+/***********************************************************
+* A single sample point and the local quadrant, 
+* in which it is located
+***********************************************************/
+typedef struct ProbePoint_t
+{
+  octDouble       xyz[3];
+
+  /* Tree and process-local index of the quadrant that 
+   * contains the point (-1 if not on this process) */
+  p4est_topidx_t  tree;
+  p4est_locidx_t  quadIdx;
+
+} ProbePoint_t;
+
+/***********************************************************
+* A probe writes the values of all its sample points 
+* into a time-series file
+***********************************************************/
+typedef struct Probe_t
+{
+  ProbeType  type;
+  /* Index of first sample point and number of points */
+  int        first;
+  int        nPoints;
+  /* Time-series file (only opened on rank 0) */
+  FILE      *fptr;
+
+} Probe_t;
+
+/***********************************************************
+* Structure containing all probes of a simulation
+***********************************************************/
+struct ProbeSet_t
+{
+  int          nProbes;
+  Probe_t      probes[OCT_MAX_PROBES];
+
+  /* All sample points of all probes (ProbePoint_t) */
+  sc_array_t  *points;
+
+  /* Mesh revision (simData->meshRevision), for which the
+   * points have been located */
+  long         revision;
+
+  /* Number of timesteps between samples */
+  int          period;
+
+  /* Sample buffers: sampled values and number of hits 
+   * per point (summed over all processes) */
+  octDouble   *sampleBuf;
+  octDouble   *sumBuf;
+
+};
+
+/***********************************************************
+* init_probes()
+*-----------------------------------------------------------
+* Reads all probe definitions from the parameter file.
+* Returns NULL if no probes are defined.
+***********************************************************/
+ProbeSet_t *init_probes(octParam *paramFile);
+
+/***********************************************************
+* destroy_probes()
+*-----------------------------------------------------------
+* Closes all probe files and frees the probe set
+***********************************************************/
+void destroy_probes(ProbeSet_t *probeSet);
+
+/***********************************************************
+* searchProbePoint()
+*-----------------------------------------------------------
+* Checks if a sample point lies within a quadrant and 
+* stores the quadrant, if it is a local leaf.
+*   -> p4est_search_local_t callback function
+***********************************************************/
+int searchProbePoint(p4est_t          *p4est,
+                     p4est_topidx_t    which_tree,
+                     p4est_quadrant_t *q,
+                     p4est_locidx_t    local_num,
+                     void             *point);
+
+/***********************************************************
+* locateProbes()
+*-----------------------------------------------------------
+* Locates the quadrants of all sample points.
+* This is only done, if the mesh has changed since the 
+* last call.
+***********************************************************/
+void locateProbes(SimData_t *simData);
+
+/***********************************************************
+* sampleProbes()
+*-----------------------------------------------------------
+* Interpolates the flow variables at all sample points,
+* reduces them to the first process and appends them to 
+* the probe files
+***********************************************************/
+void sampleProbes(SimData_t *simData, int step);
+
+#endif /* SOLVER_PROBES_H */
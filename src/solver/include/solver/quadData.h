@@ -44,26 +44,30 @@
 /***********************************************************
 * Structure containing properties for every quad
 *   > Accessed through q->p.user_data
+*   > Only the persistent fields listed in PartData_t 
+*     (see partition.h) are kept on repartitioning
 ***********************************************************/
 typedef struct QuadData_t
 {
   /*--------------------------------------------------------
   | Quad geometry data
   --------------------------------------------------------*/
+  // Octahedron centroid 
+  octDouble centroid[P4EST_DIM];
+  // Octahedron volume 
+  octDouble volume;
+#ifdef OCT_MAPPED_GEOMETRY
   // Vertices 
 #ifdef P4_TO_P8
   octDouble xyz[8][3];
 #else
   octDouble xyz[4][2];
 #endif
-  // Octahedron centroid 
-  octDouble centroid[P4EST_DIM];
-  // Octahedron volume 
-  octDouble volume;
   // Octahedron face normals 
   octDouble normals[2*P4EST_DIM][P4EST_DIM];
   // Octahedron face centroids 
   octDouble face_centroids[2*P4EST_DIM][P4EST_DIM];
+#endif
 
   /*--------------------------------------------------------
   | Quad flow data
@@ -74,6 +78,23 @@ typedef struct QuadData_t
   octDouble vars[OCT_MAX_VARS];
   // State variable gradients 
   octDouble grad_vars[OCT_MAX_VARS][P4EST_DIM];
+  // State at the beginning of a Runge-Kutta step
+  octDouble rk_vn;
+
+  /*--------------------------------------------------------
+  | Grid adaptation data
+  --------------------------------------------------------*/
+  // Refine / coarsen / keep flag (AdaptFlag)
+  int adaptFlag;
+  // Number of adaptations since the quad has been 
+  // created by refinement
+  int adaptAge;
+  // Remaining advection distance of a feature 
+  // (predictive refinement)
+  octDouble adaptReach;
+  // Limiters of the state gradients for the prolongation
+  // to children (see limitProlongation())
+  octDouble prolongLim[OCT_MAX_VARS-OCT_SOLVER_VARS];
 
 } QuadData_t;
 
@@ -127,10 +148,19 @@ void init_quadGeomData2d(p4est_t          *p4est,
 * before the outgoing data is destroyed.
 * This function matches the p4est_replace_t prototype.
 *
-* In this example, we linearly interpolate the state 
-* variable of a quadrant that is refined to its children
-* and we average the children midpoints that are being 
-* coarsened to the paren
+* The state of a quadrant that is refined is linearly 
+* interpolated to its children with the gradient limited
+* by prolongLim (see limitProlongation()), and the state of 
+* children that are being coarsened is averaged with 
+* their volumes as weights. Both operators conserve the
+* volume integral of the state exactly.
+* The geometry of the incoming quads is derived from the
+* outgoing quads (see refineQuadGeom(), coarsenQuadGeom()),
+* such that no vertices are recomputed from the tree 
+* coordinates. The linear solver buffers of refined quads 
+* are not cleared, since they are written by the solvers
+* before they are read. Gradients of the solver buffers
+* are only computed by the solvers themselves.
 *-----------------------------------------------------------
 * Arguments:
 * *p4est        : the forest
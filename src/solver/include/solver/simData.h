@@ -38,6 +38,7 @@
 #include <p8est_iterate.h>
 #endif
 
+#include "aux/bstrlib.h"
 #include "solver/typedefs.h"
 #include "solver/util.h"
 
@@ -55,14 +56,52 @@ typedef struct SimParam_t
 
   /* Simulation timestep */
   octDouble timestep;
+  /* Adaptive timestep control based on the CFL number */
+  octBool   adaptTimestep;
+  /* Target CFL number (implicit / explicit schemes) */
+  octDouble cflTarget;
+  octDouble cflTargetExplicit;
+  /* Bounds of the adaptive timestep */
+  octDouble timestepMin;
+  octDouble timestepMax;
+  /* Maximum of |mflux| / (2 * volume) over all quads,
+   * i.e. the maximum CFL number for a unit timestep */
+  octDouble courantRate;
+  /* Maximum CFL number for a unit global timestep with 
+   * local time stepping (quads of level l advance with
+   * dt / 2^(l - lvlMin)) */
+  octDouble courantRateSub;
+  /* Time that must not be overstepped by the next step 
+   * (next output time or end of simulation) */
+  octDouble timeLanding;
+  /* Local time stepping by refinement level */
+  octBool   subcycling;
+  /* Solve the velocity components in a momentum predictor */
+  octBool   solveMomentum;
+  /* Global minimum / maximum refinement level */
+  int       lvlMin;
+  int       lvlMax;
   /* Total simulation time to compute*/
   octDouble simTimeTot;
   /* Actual simulation time */
   octDouble simTime;
+  /* Number of completed timesteps */
+  int       step;
   /* Temporal discretization scheme */
   int       tempScheme;
+  /* Automatic choice between explicit / implicit scheme */
+  octBool   autoScheme;
+  int       autoSchemeExplicit;
+  int       autoSchemeImplicit;
+  /* Number of explicit substeps per timestep */
+  int       nExplicitSteps;
+  /* Running averages of the Krylov iterations per solve and
+   * of the wall time per flux evaluation / Krylov iteration */
+  octDouble avgKrylovIter;
+  octDouble timeFluxEval;
+  octDouble timeKrylovIter;
   /* Temporal flux factor */
-  octDouble tempFluxFac[3];
+  octDouble tempFluxFac[OCT_TEMP_SCHEMES];
 
   /* Fluid viscosity */
   octDouble viscosity;
@@ -81,21 +120,37 @@ typedef struct SimParam_t
   /* User-defined coarsening function */
   octCoarseFun usrCoarseFun;
 
-  /*--------------------------------------------------------
-  | Temporary values
-  --------------------------------------------------------*/
-  int       tmp_xId;       /* Variables index             */
-  int       tmp_AxId;      /* Solver buffer index         */
+} SimParam_t;
 
-  octDouble tmp_fluxFac;   /* Factor for fluxes           */
+/***********************************************************
+* Kernel context
+*-----------------------------------------------------------
+* Arguments of the solver kernels (p4est_iterate() 
+* callbacks), that are passed as user_data. 
+* Every call sets up its own context on the stack, hence
+* the kernels share no mutable state and may be executed 
+* concurrently by several threads. 
+* Kernels only read the parameter structures, values that
+* change within a call (e.g. the timestep of an explicit
+* substep) and results (e.g. the CFL rate) are kept in 
+* the context.
+***********************************************************/
+typedef struct KernelCtx_t
+{
+  QuadData_t *ghostData;   /* Ghost data of the forest    */
 
-  int       tmp_sbufVec0;
-  int       tmp_sbufVec1;
-  int       tmp_sbufProd;
+  int       xId;           /* Variables index             */
+  int       AxId;          /* Solver buffer index         */
 
-  octDouble sbuf[PARAM_BUF_VARS];
+  octDouble fluxFac;       /* Factor for fluxes           */
+  octDouble dt;            /* Timestep of the kernel      */
 
-} SimParam_t;
+  octDouble rkFac;         /* Weight of u^n in RK stage   */
+
+  octDouble courantRate;   /* Max. CFL rate (unit dt)     */
+  octDouble courantRateSub;/* Max. CFL rate (subcycled)   */
+
+} KernelCtx_t;
 
 /***********************************************************
 * Structure containing solver parameters 
@@ -109,6 +164,21 @@ typedef struct SolverParam_t
   char     *io_exportDir;
   // Prefix for export files
   char     *io_exportPrefix;
+  // Format of solution files
+  int       io_format;
+  // Write snapshots asynchronously
+  octBool   io_async;
+  // Staging memory budget for asynchronous output [MB]
+  octDouble io_bufferSize;
+  // Checkpoint file to restart from (empty: no restart)
+  bstring   io_restartFile;
+
+  // Abaqus mesh file for the connectivity (empty: brick)
+  bstring   meshFile;
+  // Number of trees of the brick connectivity per axis
+  octInt    nTrees[3];
+  // Periodicity of the brick connectivity per axis
+  octBool   periodic[3];
 
   // Number of quadrants per MPU
   octInt    nQuadMPU;
@@ -129,6 +199,23 @@ typedef struct SolverParam_t
   octDouble refErr_scalar;
   // Global refinement error for pressure  
   octDouble refErr_pressure;
+  // Global refinement error for vorticity
+  octDouble refErr_vorticity;
+  // Global refinement error for velocity jumps
+  octDouble refErr_velocity;
+
+  // Target global number of quads (0: off)
+  octInt    quadTarget;
+  // Maximum global number of quads (0: unlimited)
+  octInt    quadMax;
+  // Refine ahead of advected features
+  octBool   predictRefine;
+  // Ratio of coarsening to refinement threshold 
+  // (0: use coarsening_scalarError())
+  octDouble coarsenRatio;
+  // Number of adaptations before a refined quad may be 
+  // coarsened
+  octInt    minRefineAge;
 
   // Number of timesteps between refinement periods
   int refinePeriod;
@@ -138,6 +225,12 @@ typedef struct SolverParam_t
 
   // Number of timesteps between writing the solution
   int writePeriod;
+  // Simulation time between writing the solution 
+  // (replaces writePeriod if > 0)
+  octDouble writeInterval;
+
+  // Number of timesteps between checkpoints (0: off)
+  int checkpointPeriod;
 
 } SolverParam_t;
 
@@ -149,6 +242,13 @@ typedef struct MPIParam_t
   /* MPI Communicator */
   sc_MPI_Comm     mpiComm;
 
+  /* Thread support level provided by the MPI library */
+  int             threadLevel;
+
+  /* MPI has been initialized by init_mpiParam() and is 
+   * finalized by destroy_mpiParam() */
+  octBool         ownMPI;
+
 } MPIParam_t;
 
 /***********************************************************
@@ -172,10 +272,53 @@ typedef struct SimData_t
   /* p4est mesh connectivity */
   p4est_connectivity_t    *conn;
 
+  /* Asynchronous snapshot writer (NULL if disabled) */
+  AsyncWriter_t           *writer;
+
+  /* Probes and sampling lines/planes (NULL if none) */
+  ProbeSet_t              *probes;
+
+  /* Static refinement zones (NULL if none) */
+  ZoneSet_t               *zones;
+
+  /* Per-level quad and face lists for local time stepping
+   * (NULL if not yet built, see update_subcycleLists()) */
+  SubcycleLists_t         *subcycle;
+
+  /* Per-level quad geometry */
+  GeomTable_t             *geomTable;
+
   /* p4est ghost data structure */
   p4est_ghost_t           *ghost;
   QuadData_t              *ghostData;
 
+  /* Ghost layer connectivity required by all registered
+   * stencils (see registerStencil()) */
+  p4est_connect_type_t     ghostConnect;
+
+  /* Number of local quadrants that have been created by
+   * the last grid adaptation (counted in interpQuadData) */
+  p4est_locidx_t           nAdaptedQuads;
+
+  /* Refinement indicator of every local quad, indexed by
+   * the local quad index (see computeAdaptFlags()) */
+  sc_array_t              *indicator;
+
+  /* Refinement threshold of the last indicator pass, used
+   * for quads that are created during the adaptation */
+  octDouble                refThresh;
+
+  /* Number of quads, that may still be refined on this 
+   * process by the direct evaluation in globalRefinement()
+   * without exceeding solverParam->quadMax 
+   * (negative: unlimited) */
+  p4est_locidx_t           refineBudget;
+
+  /* Counter of mesh changes (adaptation, repartitioning,
+   * restart). Unlike p4est->revision, it is not reset 
+   * when the forest is replaced by a copy. */
+  long                     meshRevision;
+
 } SimData_t;
 
 /***********************************************************
@@ -189,6 +332,17 @@ SimData_t *init_simData(int          argc,
                         octRefineFun usrRefineFun,
                         octCoarseFun usrCoarseFun);
 
+/***********************************************************
+* init_kernelCtx()
+*-----------------------------------------------------------
+* Initializes a kernel context for variable <xId> and 
+* solver buffer <AxId>
+***********************************************************/
+void init_kernelCtx(KernelCtx_t *ctx,
+                    SimData_t   *simData,
+                    int          xId,
+                    int          AxId);
+
 /***********************************************************
 * init_simParam()
 *-----------------------------------------------------------
@@ -241,6 +395,44 @@ void destroy_solverParam(SolverParam_t *solverParam);
 ***********************************************************/
 void destroy_mpiParam(MPIParam_t *mpiParam);
 
+/***********************************************************
+* registerStencil()
+*-----------------------------------------------------------
+* Registers the neighbour connectivity of a stencil that 
+* is evaluated with p4est_iterate() on the ghost layer.
+* The ghost layer is built with the widest connectivity 
+* of all registered stencils.
+***********************************************************/
+void registerStencil(SimData_t           *simData,
+                     p4est_connect_type_t stencilType);
+
+/***********************************************************
+* init_ghostData()
+*-----------------------------------------------------------
+* Creates the p4est ghost layer and the ghost data buffer
+* and fills the buffer with the data of the neighbouring
+* processes
+***********************************************************/
+void init_ghostData(SimData_t *simData);
+
+/***********************************************************
+* destroy_ghostData()
+*-----------------------------------------------------------
+* Frees the p4est ghost layer and the ghost data buffer
+***********************************************************/
+void destroy_ghostData(SimData_t *simData);
+
+/***********************************************************
+* exchangeMeshChanges()
+*-----------------------------------------------------------
+* Function to determine the global number of quadrants, 
+* that have been created by the last grid adaptation
+* (0 if no quadrant has been changed on any process).
+* Resets the local counter of adapted quadrants and 
+* increments the mesh revision, if the mesh has changed.
+***********************************************************/
+p4est_gloidx_t exchangeMeshChanges(SimData_t *simData);
+
 /***********************************************************
 * estimateMeshAttributes()
 *-----------------------------------------------------------
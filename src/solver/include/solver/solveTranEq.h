@@ -51,9 +51,10 @@ void resetSolverBuffers(p4est_iter_volume_info_t *info,
 * This function sums up the right hand side of the equation
 * system
 *   Ax = b 
-* that underlies a discretized transport equation.
+* that underlies a discretized transport equation for 
+* the timestep <dt>.
 ***********************************************************/
-void compute_b_tranEq(SimData_t *simData, int xId);
+void compute_b_tranEq(SimData_t *simData, int xId, octDouble dt);
 
 /***********************************************************
 * compute_Ax_tranEq()
@@ -67,6 +68,17 @@ void compute_Ax_tranEq(SimData_t *simData,
                        int        xId, 
                        int        sbufIdx);
 
+/***********************************************************
+* solve_explicit_ssprk()
+*-----------------------------------------------------------
+* Function to advance a transport equation for variable 
+* <xId> by the timestep <dt> with a strong stability 
+* preserving Runge-Kutta scheme (SSP-RK2 / SSP-RK3) in 
+* Shu-Osher form. 
+* The state u^n is kept in QuadData_t.rk_vn.
+***********************************************************/
+void solve_explicit_ssprk(SimData_t *simData, int xId, octDouble dt);
+
 /***********************************************************
 * solveTranEq()
 *-----------------------------------------------------------
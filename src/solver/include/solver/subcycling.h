@@ -0,0 +1,185 @@
+/*
+* This file is part of OctFS. 
+* OctFS is a finite-volume flow solver with adaptive
+* mesh refinement written in C, which is based on 
+* the p4est library.
+*
+* Copyright (C) 2020 Florian Setzwein 
+*
+* OctFS is free software; you can redistribute it and/or 
+* modify it under the terms of the GNU General Public 
+* License as published by the Free Software Foundation; 
+* either version 2 of the License, or (at your option) 
+* any later version.
+*
+* OctFS is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied 
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR 
+* PURPOSE.  See the GNU General Public License for more 
+* details.
+*
+* You should have received a copy of the GNU General 
+* Public License along with OctFS; if not, write to the 
+* Free Software Foundation, Inc., 51 Franklin Street, 
+* Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+#ifndef SOLVER_SUBCYCLING_H
+#define SOLVER_SUBCYCLING_H
+
+#ifndef P4_TO_P8
+#include <p4est_bits.h>
+#include <p4est_extended.h>
+#include <p4est_iterate.h>
+#else
+#include <p8est_bits.h>
+#include <p8est_extended.h>
+#include <p8est_iterate.h>
+#endif
+
+#include "solver/typedefs.h"
+#include "solver/simData.h"
+#include "solver/quadData.h"
+
+/***********************************************************
+* Local time stepping (subcycling) by refinement level
+*-----------------------------------------------------------
+* The coarsest level advances with the global timestep dt,
+* every finer level l with dt / 2^(l - lvlMin). 
+* One global step consists of 2^(lvlMax - lvlMin) substeps 
+* of the finest level. A quad of level l is updated 
+* every 2^(lvlMax - l) substeps.
+*
+* Face fluxes are evaluated with the timestep of the finer 
+* side and accumulated into a flux register (solver buffer 
+* SB) on both sides. A coarse quad applies all fluxes of 
+* its fine neighbours at the end of its own step, such that 
+* mass is conserved at hanging faces.
+*
+* A substep only visits the faces and quads of its active
+* levels (see SubcycleLists_t). Ghost values are exchanged 
+* once per call and afterwards only for the transported 
+* variable, whenever a level with mirror quads was updated.
+*
+* Local time stepping is used by all explicit schemes:
+* The explicit Euler scheme performs a single subcycled 
+* step, every stage of the SSP-RK schemes is a subcycled
+* forward Euler step over the global timestep, which is 
+* combined with the state u^n (see solve_explicit_ssprk()).
+* Implicit schemes advance all quads with the global 
+* timestep.
+***********************************************************/
+
+/***********************************************************
+* TRUE, if the temporal scheme <scheme> uses local time 
+* stepping
+***********************************************************/
+#define IS_SUBCYCLED(simParam, scheme) \
+  ( (simParam)->subcycling == TRUE && IS_EXPLICIT_SCHEME(scheme) )
+
+/***********************************************************
+* Number of substeps between two updates of a quad 
+* with refinement level <lvl>
+***********************************************************/
+#define SUBCYCLE_PERIOD(simParam, lvl) \
+  ( 1 << ((simParam)->lvlMax - (lvl)) )
+
+/***********************************************************
+* findLevelRange()
+*-----------------------------------------------------------
+* Function to find the minimum and maximum refinement 
+* level of all local quads.
+*
+*   -> p4est_iter_volume_t callback function
+***********************************************************/
+void findLevelRange(p4est_iter_volume_info_t *info,
+                    void                     *user_data);
+
+/***********************************************************
+* exchangeLevelRange()
+*-----------------------------------------------------------
+* Function to determine the global minimum and maximum 
+* refinement level (simParam->lvlMin, simParam->lvlMax)
+***********************************************************/
+void exchangeLevelRange(SimData_t *simData);
+
+/***********************************************************
+* Subcycling face 
+*-----------------------------------------------------------
+* A face (or subface of a hanging face) between the quads
+* <a> and <b>. Side <a> is the finer side, whose massflux
+* mflux[iface] and timestep are used for the face flux.
+* Indices refer to the local quads or, if the respective
+* ghost flag is set, to the ghost layer.
+***********************************************************/
+typedef struct SubcycleFace_t
+{
+  p4est_locidx_t a;
+  p4est_locidx_t b;
+  int8_t         aGhost;
+  int8_t         bGhost;
+  int8_t         iface;
+
+} SubcycleFace_t;
+
+/***********************************************************
+* Subcycling lists 
+*-----------------------------------------------------------
+* Local quads and faces grouped by refinement level, such
+* that a substep only visits the levels that are active.
+* The lists are built once per mesh change 
+* (simData->meshRevision).
+***********************************************************/
+struct SubcycleLists_t
+{
+  /* Mesh revision, for which the lists were built */
+  long            meshRevision;
+
+  /* Data of all local quads, by local quad index */
+  p4est_locidx_t  nQuads;
+  QuadData_t    **quadData;
+
+  /* Local quad indices (p4est_locidx_t) by level */
+  sc_array_t     *quads[P4EST_QMAXLEVEL + 1];
+
+  /* Faces (SubcycleFace_t) by level of their side <a> */
+  sc_array_t     *faces[P4EST_QMAXLEVEL + 1];
+
+  /* TRUE, if any process has mirror quads of a level */
+  int             mirrorLevel[P4EST_QMAXLEVEL + 1];
+
+  /* Buffers for the exchange of a single variable */
+  p4est_locidx_t  nGhosts;
+  octDouble      *ghostBuf;
+  void          **mirrorBuf;
+};
+
+/***********************************************************
+* update_subcycleLists()
+*-----------------------------------------------------------
+* Function to (re-)build the subcycling lists and the 
+* global level range (see exchangeLevelRange()), if the 
+* mesh has changed since they were built.
+* Requires a valid ghost layer.
+***********************************************************/
+void update_subcycleLists(SimData_t *simData);
+
+/***********************************************************
+* destroy_subcycleLists()
+*-----------------------------------------------------------
+* Destroys the subcycling lists
+***********************************************************/
+void destroy_subcycleLists(SubcycleLists_t *lists);
+
+/***********************************************************
+* solve_explicit_subcycled()
+*-----------------------------------------------------------
+* Function to advance a transport equation for variable 
+* <xId> by one global timestep <dt> with the explicit 
+* Euler scheme and local time stepping.
+* The ghost values of <xId> are not exchanged after the
+* last substep.
+***********************************************************/
+void solve_explicit_subcycled(SimData_t *simData, int xId, 
+                              octDouble dt);
+
+#endif /* SOLVER_SUBCYCLING_H */
@@ -37,8 +37,19 @@
 #endif
 
 #include "solver/typedefs.h"
+#include "solver/simData.h"
 #include "solver/util.h"
 
+/***********************************************************
+* Running average of solver costs (see chooseTempScheme())
+***********************************************************/
+#define COST_AVG_FAC 0.3
+
+#define UPDATE_RUNNING_AVG(avg, val)                     \
+  ( (avg) = ((avg) > 0.0)                                \
+          ? (1.0-COST_AVG_FAC) * (avg) + COST_AVG_FAC * (val) \
+          : (val) )
+
 /***********************************************************
 * addTimeDerivative()
 *-----------------------------------------------------------
@@ -49,5 +60,62 @@
 void addTimeDerivative(p4est_iter_volume_info_t *info,
                        void *user_data);
 
+/***********************************************************
+* storeStageState()
+*-----------------------------------------------------------
+* Function to store the state u^n of the current variable
+* at the beginning of a Runge-Kutta step.
+* 
+*   -> p4est_iter_volume_t callback function
+***********************************************************/
+void storeStageState(p4est_iter_volume_info_t *info,
+                     void *user_data);
+
+/***********************************************************
+* combineStageState()
+*-----------------------------------------------------------
+* Function to combine the result of a forward Euler stage 
+* with the state u^n (Shu-Osher form):
+*   u = a * u^n + (1 - a) * u
+* where a is given by the kernel context (ctx->rkFac).
+* 
+*   -> p4est_iter_volume_t callback function
+***********************************************************/
+void combineStageState(p4est_iter_volume_info_t *info,
+                       void *user_data);
+
+/***********************************************************
+* exchangeCourantRate()
+*-----------------------------------------------------------
+* Function to reduce the maximum CFL rates of all quads 
+* (simParam->courantRate, simParam->courantRateSub) 
+* together with the measured solver costs over all 
+* processes in a single reduction.
+***********************************************************/
+void exchangeCourantRate(SimData_t *simData);
+
+/***********************************************************
+* chooseTempScheme()
+*-----------------------------------------------------------
+* Function to choose the cheaper of the explicit and the
+* implicit scheme for the next timestep (automatic mode)
+* by their costs per unit of simulated time.
+* Must be called before adaptTimestep().
+* Requires the global CFL rates of exchangeCourantRate().
+***********************************************************/
+void chooseTempScheme(SimData_t *simData);
+
+/***********************************************************
+* adaptTimestep()
+*-----------------------------------------------------------
+* Function to set the timestep, such that the maximum CFL 
+* number of all quads matches the target CFL number of 
+* the chosen temporal scheme. 
+* The timestep is bounded by the minimum/maximum timestep 
+* and reduced to land exactly on simParam->timeLanding.
+* Requires the global CFL rates of exchangeCourantRate().
+***********************************************************/
+void adaptTimestep(SimData_t *simData);
+
 
 #endif /* SOLVER_TIMEINTEGRAL_H */
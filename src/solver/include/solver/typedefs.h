@@ -43,6 +43,16 @@
 #define octInt    int
 #define octBool   int
 
+/***********************************************************
+* Quad geometry
+*-----------------------------------------------------------
+* By default, the geometry of a quad is computed from its
+* refinement level, which requires axis-aligned trees.
+* Define OCT_MAPPED_GEOMETRY to store vertices, face normals
+* and face centroids for every quad instead (e.g. for 
+* mapped or curvilinear connectivities).
+***********************************************************/
+
 /***********************************************************
 * Solver variables
 ***********************************************************/
@@ -53,6 +63,8 @@
 #define QUAD_BUF_VARS    10 /* No. of lin. solver buffs.*/
 #define PARAM_BUF_VARS   10 /* No. of lin. solver buffs.*/
 
+#define OCT_TIME_EPS 1.0E-10 /* Rel. tolerance of times  */
+
 /***********************************************************
 * Solver indices
 *-----------------------------------------------------------
@@ -81,8 +93,8 @@ typedef enum
 } VarIndex;
 
 /***********************************************************
-* Indices for buffer variables of linear solver that are
-* stored in the simParam struct
+* Indices for the scalar buffer variables of the linear
+* solver (see linSolve_bicgstab())
 ***********************************************************/
 typedef enum
 {
@@ -102,9 +114,41 @@ typedef enum
 { 
   EULER_EXPLICIT,
   EULER_IMPLICIT,
-  CRANK_NICOLSON
+  CRANK_NICOLSON,
+  SSP_RK2,
+  SSP_RK3
 } TempScheme;
 
+#define OCT_TEMP_SCHEMES 5
+
+/* Automatic choice between an explicit and implicit scheme 
+ * (only used to parse the parameter file) */
+#define AUTOMATIC_SCHEME OCT_TEMP_SCHEMES
+
+#define IS_EXPLICIT_SCHEME(s) \
+  ( (s) == EULER_EXPLICIT || (s) == SSP_RK2 || (s) == SSP_RK3 )
+
+/***********************************************************
+* Grid adaptation flags (see adapt.h)
+***********************************************************/
+typedef enum
+{
+  ADAPT_UNSET,   /* Not evaluated yet                        */
+  ADAPT_KEEP,    /* Keep quad                                */
+  ADAPT_REFINE,  /* Refine quad                              */
+  ADAPT_COARSEN, /* Coarsen family of quads                  */
+  ADAPT_HOLD     /* Keep quad, must not be coarsened         */
+} AdaptFlag;
+
+/***********************************************************
+* Output formats
+***********************************************************/
+typedef enum
+{
+  OUTPUT_VTK,      /* p4est vtk files (one piece per process) */
+  OUTPUT_SNAPSHOT  /* Single binary file written by MPI-IO    */
+} OutputFormat;
+
 /***********************************************************
 * Typedefs for simData.h
 ***********************************************************/
@@ -112,12 +156,38 @@ typedef struct SimParam_t       SimParam_t;
 typedef struct SolverParam_t    SolverParam_t;
 typedef struct MPIParam_t       MPIParam_t;
 typedef struct SimData_t        SimData_t;
+typedef struct KernelCtx_t      KernelCtx_t;
 
 /***********************************************************
 * Typedefs for quadData.h
 ***********************************************************/
 typedef struct QuadData_t       QuadData_t;
 
+/***********************************************************
+* Typedefs for geometry.h
+***********************************************************/
+typedef struct GeomTable_t      GeomTable_t;
+
+/***********************************************************
+* Typedefs for dataIO.h
+***********************************************************/
+typedef struct AsyncWriter_t    AsyncWriter_t;
+
+/***********************************************************
+* Typedefs for probes.h
+***********************************************************/
+typedef struct ProbeSet_t       ProbeSet_t;
+
+/***********************************************************
+* Typedefs for zones.h
+***********************************************************/
+typedef struct ZoneSet_t        ZoneSet_t;
+
+/***********************************************************
+* Typedefs for subcycling.h
+***********************************************************/
+typedef struct SubcycleLists_t  SubcycleLists_t;
+
 /***********************************************************
 * Initialization function pointer for user 
 ***********************************************************/
@@ -0,0 +1,148 @@
+/*
+* This file is part of OctFS. 
+* OctFS is a finite-volume flow solver with adaptive
+* mesh refinement written in C, which is based on 
+* the p4est library.
+*
+* Copyright (C) 2020 Florian Setzwein 
+*
+* OctFS is free software; you can redistribute it and/or 
+* modify it under the terms of the GNU General Public 
+* License as published by the Free Software Foundation; 
+* either version 2 of the License, or (at your option) 
+* any later version.
+*
+* OctFS is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied 
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR 
+* PURPOSE.  See the GNU General Public License for more 
+* details.
+*
+* You should have received a copy of the GNU General 
+* Public License along with OctFS; if not, write to the 
+* Free Software Foundation, Inc., 51 Franklin Street, 
+* Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+#ifndef SOLVER_ZONES_H
+#define SOLVER_ZONES_H
+
+#ifndef P4_TO_P8
+#include <p4est_bits.h>
+#include <p4est_extended.h>
+#include <p4est_search.h>
+#else
+#include <p8est_bits.h>
+#include <p8est_extended.h>
+#include <p8est_search.h>
+#endif
+
+#include "solver/typedefs.h"
+#include "solver/simData.h"
+#include "solver/paramfile.h"
+
+#define OCT_MAX_ZONES 32
+
+/***********************************************************
+* Refinement zone types
+*-----------------------------------------------------------
+* Static refinement zones are defined in the parameter file
+* (one line per zone, coordinates are always given in 3D):
+*
+*   Refinement box:      x0, y0, z0, x1, y1, z1, level
+*   Refinement sphere:   xc, yc, zc, r, level
+*   Refinement cylinder: x0, y0, z0, x1, y1, z1, r, level
+*
+* The cylinder axis runs from (x0,y0,z0) to (x1,y1,z1).
+* All quads that intersect a zone are refined to at least
+* the level of the zone and are not coarsened below it.
+* In 2D, the z-coordinates are ignored.
+***********************************************************/
+typedef enum
+{
+  ZONE_BOX,
+  ZONE_SPHERE,
+  ZONE_CYLINDER
+} ZoneType;
+
+/***********************************************************
+* A single refinement zone
+***********************************************************/
+typedef struct RefineZone_t
+{
+  ZoneType   type;
+  /* Geometry values as given in the parameter file */
+  octDouble  v[7];
+  /* Target refinement level */
+  int        level;
+
+} RefineZone_t;
+
+/***********************************************************
+* Structure containing all refinement zones of a simulation
+***********************************************************/
+struct ZoneSet_t
+{
+  int           nZones;
+  RefineZone_t  zones[OCT_MAX_ZONES];
+
+};
+
+/***********************************************************
+* init_zones()
+*-----------------------------------------------------------
+* Reads all refinement zones from the parameter file.
+* Returns NULL if no zones are defined.
+***********************************************************/
+ZoneSet_t *init_zones(octParam *paramFile);
+
+/***********************************************************
+* destroy_zones()
+*-----------------------------------------------------------
+* Frees the zone set
+***********************************************************/
+void destroy_zones(ZoneSet_t *zoneSet);
+
+/***********************************************************
+* zoneIntersects()
+*-----------------------------------------------------------
+* Checks if a refinement zone intersects the bounding box 
+* [lo, hi] of a quadrant (conservative for cylinders)
+***********************************************************/
+int zoneIntersects(const RefineZone_t *zone,
+                   const octDouble    *lo,
+                   const octDouble    *hi);
+
+/***********************************************************
+* zoneRefineLevel()
+*-----------------------------------------------------------
+* Returns the highest level of all zones that intersect
+* a quadrant and whose level is not below the level of 
+* the quadrant (-1 if there is no such zone)
+***********************************************************/
+int zoneRefineLevel(p4est_t          *p4est,
+                    p4est_topidx_t    which_tree,
+                    p4est_quadrant_t *q);
+
+/***********************************************************
+* searchZones()
+*-----------------------------------------------------------
+* Flags local leaves inside refinement zones.
+* Branches outside of all zones are pruned.
+*   -> p4est_search_local_t callback function
+***********************************************************/
+int searchZones(p4est_t          *p4est,
+                p4est_topidx_t    which_tree,
+                p4est_quadrant_t *q,
+                p4est_locidx_t    local_num,
+                void             *point);
+
+/***********************************************************
+* markZones()
+*-----------------------------------------------------------
+* Sets the adaptation flags of all local quads inside 
+* refinement zones 
+***********************************************************/
+void markZones(SimData_t *simData);
+
+
+#endif /* SOLVER_ZONES_H */
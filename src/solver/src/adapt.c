@@ -0,0 +1,1423 @@
+/*
+* This file is part of OctFS. 
+* OctFS is a finite-volume flow solver with adaptive
+* mesh refinement written in C, which is based on 
+* the p4est library.
+*
+* Copyright (C) 2020 Florian Setzwein 
+*
+* OctFS is free software; you can redistribute it and/or 
+* modify it under the terms of the GNU General Public 
+* License as published by the Free Software Foundation; 
+* either version 2 of the License, or (at your option) 
+* any later version.
+*
+* OctFS is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied 
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR 
+* PURPOSE.  See the GNU General Public License for more 
+* details.
+*
+* You should have received a copy of the GNU General 
+* Public License along with OctFS; if not, write to the 
+* Free Software Foundation, Inc., 51 Franklin Street, 
+* Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+#include <math.h>
+
+#include "solver/typedefs.h"
+#include "solver/util.h"
+#include "solver/adapt.h"
+#include "solver/refine.h"
+#include "solver/coarsen.h"
+#include "solver/quadData.h"
+#include "solver/simData.h"
+#include "solver/zones.h"
+#include "solver/geometry.h"
+
+
+/***********************************************************
+* pow4()
+***********************************************************/
+static inline octDouble pow4(octDouble x)
+{
+  const octDouble x2 = x * x;
+  return x2 * x2;
+
+} /* pow4() */
+
+/***********************************************************
+* adaptIndicator()
+*-----------------------------------------------------------
+* Combined refinement indicator of a quad. 
+*
+* Every criterion is normalized with the fourth power of 
+* its threshold from the parameter file, such that the
+* quad is refined for an indicator > 1:
+*   - passive scalar: err2 / vol of calcSqrErr() for IS
+*                     (threshold refErr_scalar)
+*   - pressure:       err2 / vol of calcSqrErr() for IP
+*                     (threshold refErr_pressure)
+*   - vorticity:      (|omega| * h)^4
+*                     (threshold refErr_vorticity)
+*   - velocity jump:  (|grad(u)| * h)^4, the velocity 
+*                     difference across the quad estimated
+*                     from the Frobenius norm of the 
+*                     velocity gradient
+*                     (threshold refErr_velocity)
+* where h is the edge length of the quad. 
+* All criteria scale with h^4 for a given gradient.
+* Criteria with a threshold <= 0 are not evaluated, the
+* combined indicator is the maximum of all criteria.
+***********************************************************/
+octDouble adaptIndicator(SolverParam_t    *solverParam,
+                         p4est_quadrant_t *q)
+{
+  QuadData_t *quadData = (QuadData_t *) q->p.user_data;
+
+  const octDouble vol = quadData->volume;
+  const octDouble h   = pow(vol, 1.0 / P4EST_DIM);
+
+  const octDouble errS = solverParam->refErr_scalar;
+  const octDouble errP = solverParam->refErr_pressure;
+  const octDouble errW = solverParam->refErr_vorticity;
+  const octDouble errU = solverParam->refErr_velocity;
+
+  octDouble ind = 0.0;
+
+  /*--------------------------------------------------------
+  | Passive scalar and pressure
+  --------------------------------------------------------*/
+  if (errS > 0.0)
+    ind = MAX(ind, calcSqrErr(q, IS) / (vol * pow4(errS)));
+
+  if (errP > 0.0)
+    ind = MAX(ind, calcSqrErr(q, IP) / (vol * pow4(errP)));
+
+  /*--------------------------------------------------------
+  | Vorticity
+  --------------------------------------------------------*/
+  octDouble (*grad)[P4EST_DIM] = quadData->grad_vars;
+
+  if (errW > 0.0)
+  {
+#ifdef P4_TO_P8
+    const octDouble wx = grad[IVZ][1] - grad[IVY][2];
+    const octDouble wy = grad[IVX][2] - grad[IVZ][0];
+    const octDouble wz = grad[IVY][0] - grad[IVX][1];
+    const octDouble w2 = wx*wx + wy*wy + wz*wz;
+#else
+    const octDouble wz = grad[IVY][0] - grad[IVX][1];
+    const octDouble w2 = wz*wz;
+#endif
+
+    ind = MAX(ind, pow4(h / errW) * w2 * w2);
+  }
+
+  /*--------------------------------------------------------
+  | Velocity jump
+  --------------------------------------------------------*/
+  if (errU > 0.0)
+  {
+    octDouble g2 = 0.0;
+    int i, j;
+
+    for (i = 0; i < P4EST_DIM; i++)
+      for (j = 0; j < P4EST_DIM; j++)
+        g2 += grad[IVX+i][j] * grad[IVX+i][j];
+
+    ind = MAX(ind, pow4(h / errU) * g2 * g2);
+  }
+
+  return ind;
+
+} /* adaptIndicator() */
+
+/***********************************************************
+* familyIndicator()
+*-----------------------------------------------------------
+* Indicator of a family of quads, that are stored 
+* consecutively in the indicator array
+***********************************************************/
+static inline octDouble familyIndicator(const octDouble *ind)
+{
+  int i;
+  octDouble famInd = ind[0];
+
+  for (i = 1; i < P4EST_CHILDREN; i++)
+    famInd = MAX(famInd, ind[i]);
+
+  return famInd;
+
+} /* familyIndicator() */
+
+/***********************************************************
+* coarsenByHysteresis()
+*-----------------------------------------------------------
+* Coarsening criterion of a family with the indicator 
+* <famInd>: The estimate for the coarse quad 
+* (OCT_COARSEN_ERR_FAC * famInd) must be below 
+* <coarsenRatio> times the refinement threshold.
+***********************************************************/
+int coarsenByHysteresis(octDouble famInd, 
+                        octDouble refThresh, 
+                        octDouble coarsenRatio)
+{
+  return ( OCT_COARSEN_ERR_FAC * famInd 
+         < coarsenRatio * refThresh );
+
+} /* coarsenByHysteresis() */
+
+/***********************************************************
+* indicatorBin()
+*-----------------------------------------------------------
+* Histogram bin of an indicator:
+* Indicators <= 0 are sorted into bin 0, positive 
+* indicators into the bins 1 .. OCT_BUDGET_BINS-1, which 
+* are spaced logarithmically in [10^lRange[0], 10^lRange[1]]
+***********************************************************/
+int indicatorBin(octDouble ind, const octDouble *lRange)
+{
+  if (ind <= 0.0)
+    return 0;
+
+  const int nBins = OCT_BUDGET_BINS - 1;
+
+  octDouble dl  = lRange[1] - lRange[0];
+  int       bin = 1;
+
+  if (dl > 0.0)
+    bin = 1 + (int) floor( (log10(ind) - lRange[0]) / dl 
+                           * nBins );
+
+  return MAX(1, MIN(bin, nBins));
+
+} /* indicatorBin() */
+
+/***********************************************************
+* binEdge()
+*-----------------------------------------------------------
+* Lower indicator bound of a histogram bin
+* (bin = OCT_BUDGET_BINS: upper bound of the last bin)
+***********************************************************/
+octDouble binEdge(int bin, const octDouble *lRange)
+{
+  if (bin <= 0)
+    return 0.0;
+
+  const int nBins = OCT_BUDGET_BINS - 1;
+
+  octDouble dl = lRange[1] - lRange[0];
+
+  return pow(10.0, lRange[0] + dl * (bin - 1) / nBins);
+
+} /* binEdge() */
+
+/***********************************************************
+* histRefineThresh()
+*-----------------------------------------------------------
+* Lowest refinement threshold of an indicator histogram 
+* <hist>, such that no more than <n> quads have an 
+* indicator above the threshold.
+* Quads with an indicator <= 0 are never above the 
+* threshold.
+***********************************************************/
+octDouble histRefineThresh(const long      *hist, 
+                           long             n, 
+                           const octDouble *lRange)
+{
+  long cum = 0;
+  int  b;
+
+  for (b = OCT_BUDGET_BINS-1; b >= 0; b--)
+  {
+    if (cum + hist[b] > n)
+      break;
+    cum += hist[b];
+  }
+
+  return (b <= 0) ? 0.0 : binEdge(b+1, lRange);
+
+} /* histRefineThresh() */
+
+/***********************************************************
+* histCoarsenThresh()
+*-----------------------------------------------------------
+* Highest coarsening threshold of an indicator histogram 
+* <hist>, such that no more than <n> families have an 
+* indicator below the threshold.
+* Families with an indicator <= 0 are only below the 
+* threshold, if all of them fit into <n>.
+***********************************************************/
+octDouble histCoarsenThresh(const long      *hist, 
+                            long             n, 
+                            const octDouble *lRange)
+{
+  long cum = 0;
+  int  b;
+
+  for (b = 0; b < OCT_BUDGET_BINS; b++)
+  {
+    if (cum + hist[b] > n)
+      break;
+    cum += hist[b];
+  }
+
+  return (b < OCT_BUDGET_BINS) ? binEdge(b, lRange) : DBL_MAX;
+
+} /* histCoarsenThresh() */
+
+/***********************************************************
+* budgetThresholds()
+*-----------------------------------------------------------
+* Function to determine the indicator thresholds for 
+* refinement and coarsening from the quad budget 
+* (solverParam->quadTarget, solverParam->quadMax).
+*
+* The indicators of all refinable quads and of all 
+* families are sorted into global histograms with 
+* logarithmically spaced bins (one reduction for the 
+* indicator range, one for the histograms).
+* Indicators <= 0 have their own bin (see indicatorBin()).
+* The thresholds are chosen from the histograms, such that
+*   - at most (quadMax - N) / (2^d - 1) quads are refined
+*   - quads with an indicator above the error threshold 
+*     are refined and the top (quadTarget - N) / (2^d - 1) 
+*     quads are refined, if the grid is below its target
+*   - the (N - quadTarget) / (2^d - 1) families with the 
+*     lowest indicators are coarsened, if the grid is 
+*     above its target
+* where N is the current global number of quads.
+* Quads, that are flagged afterwards by other sources, are
+* capped by capRefinement().
+***********************************************************/
+static void budgetThresholds(SimData_t *simData,
+                             octDouble  refErr,
+                             octDouble *refThresh,
+                             octDouble *coarseThresh)
+{
+  p4est_t       *p4est       = simData->p4est;
+  SolverParam_t *solverParam = simData->solverParam;
+
+  const octDouble *indicator = (octDouble *) 
+                               simData->indicator->array;
+
+  long nQuads = (long) p4est->global_num_quadrants;
+  long nChild = P4EST_CHILDREN - 1;
+  long target = solverParam->quadTarget;
+  long nMax   = solverParam->quadMax;
+
+  long nRefTarget   = MAX(0, target - nQuads) / nChild;
+  long nCoarsTarget = MAX(0, nQuads - target) / nChild;
+  long nRefMax      = nQuads;
+
+  if (nMax > 0)
+    nRefMax = MAX(0, nMax - nQuads) / nChild;
+
+  int maxRefLvl = solverParam->maxRefLvl;
+
+  p4est_topidx_t which_tree;
+  p4est_locidx_t i;
+  int            b;
+
+  /*--------------------------------------------------------
+  | Global range of log10(indicator)
+  | -> Minimum is stored negated -> single reduction
+  --------------------------------------------------------*/
+  octDouble lRange_loc[2]  = { -DBL_MAX, -DBL_MAX };
+  octDouble lRange[2]      = { 0.0, 0.0 };
+
+  for (i = 0; i < p4est->local_num_quadrants; i++)
+  {
+    if (indicator[i] <= 0.0)
+      continue;
+
+    const octDouble l = log10(indicator[i]);
+
+    lRange_loc[0] = MAX(lRange_loc[0], -l);
+    lRange_loc[1] = MAX(lRange_loc[1],  l);
+  }
+
+  sc_MPI_Allreduce(lRange_loc,
+                   lRange,
+                   2,
+                   sc_MPI_DOUBLE,
+                   sc_MPI_MAX,
+                   simData->mpiParam->mpiComm);
+
+  lRange[0] = -lRange[0];
+
+  *refThresh    = refErr;
+  *coarseThresh = -1.0;
+
+  if (lRange[1] < lRange[0])
+    return;
+
+  /*--------------------------------------------------------
+  | Histograms of refinable quads and of families
+  --------------------------------------------------------*/
+  long hist_loc[2*OCT_BUDGET_BINS];
+  long hist[2*OCT_BUDGET_BINS];
+
+  for (b = 0; b < 2*OCT_BUDGET_BINS; b++)
+    hist_loc[b] = 0;
+
+  for (which_tree  = p4est->first_local_tree; 
+       which_tree <= p4est->last_local_tree; 
+       which_tree++)
+  {
+    p4est_tree_t     *tree  = p4est_tree_array_index(p4est->trees, 
+                                                     which_tree);
+    p4est_quadrant_t *quads = (p4est_quadrant_t *) 
+                              tree->quadrants.array;
+    p4est_locidx_t    nTree = (p4est_locidx_t) 
+                              tree->quadrants.elem_count;
+
+    const octDouble *treeInd = &indicator[tree->quadrants_offset];
+
+    for (i = 0; i < nTree; i++)
+    {
+      if (quads[i].level < maxRefLvl)
+        hist_loc[indicatorBin(treeInd[i], lRange)] += 1;
+    }
+
+    i = 0;
+
+    while (i + P4EST_CHILDREN <= nTree)
+    {
+      if (!p4est_quadrant_is_familyv(&quads[i]))
+      {
+        i++;
+        continue;
+      }
+
+      b = indicatorBin(familyIndicator(&treeInd[i]), lRange);
+      hist_loc[OCT_BUDGET_BINS + b] += 1;
+
+      i += P4EST_CHILDREN;
+    }
+  }
+
+  sc_MPI_Allreduce(hist_loc,
+                   hist,
+                   2*OCT_BUDGET_BINS,
+                   sc_MPI_LONG,
+                   sc_MPI_SUM,
+                   simData->mpiParam->mpiComm);
+
+  /*--------------------------------------------------------
+  | Refinement: Lowest threshold, such that no more than 
+  | nRefTarget / nRefMax quads are refined
+  --------------------------------------------------------*/
+  octDouble threshTarget = histRefineThresh(hist, nRefTarget, 
+                                            lRange);
+  octDouble threshMax    = histRefineThresh(hist, nRefMax, 
+                                            lRange);
+
+  *refThresh = MAX( MIN(refErr, threshTarget), threshMax );
+
+  /*--------------------------------------------------------
+  | Coarsening: Highest threshold, such that no more than
+  | nCoarsTarget families are coarsened
+  --------------------------------------------------------*/
+  if (nCoarsTarget > 0)
+    *coarseThresh = histCoarsenThresh(&hist[OCT_BUDGET_BINS], 
+                                      nCoarsTarget, lRange);
+
+  octPrint("QUAD BUDGET: %ld QUADS (TARGET %ld, MAX %ld) "
+           "| REFINE > %9.3e | COARSEN < %9.3e", 
+           nQuads, target, nMax, *refThresh, *coarseThresh);
+
+} /* budgetThresholds() */
+
+/***********************************************************
+* propagateReach()
+*-----------------------------------------------------------
+* Passes the advection distance of a feature from quad 
+* <src> across its face <face> into the quad <dst>, if 
+* the face is an outflow face of <src>
+***********************************************************/
+static inline void propagateReach(QuadData_t *src, int face,
+                                  QuadData_t *dst, int dstIsGhost)
+{
+  if (dstIsGhost || src->adaptReach <= 0.0)
+    return;
+
+  if (src->mflux[face] <= 0.0)
+    return;
+
+  const octDouble h = pow(dst->volume, 1.0 / P4EST_DIM);
+
+  dst->adaptReach = MAX( dst->adaptReach, 
+                         MAX(0.0, src->adaptReach - h) );
+
+} /* propagateReach() */
+
+/***********************************************************
+* advectReach()
+*-----------------------------------------------------------
+* Function to advect the feature distance of every quad 
+* across its outflow faces into its neighbours
+*
+*   -> p4est_iter_face_t callback function
+***********************************************************/
+static void advectReach(p4est_iter_face_info_t *info,
+                        void                   *user_data)
+{
+  QuadData_t *ghostData = (QuadData_t *) user_data;
+
+  sc_array_t *sides = &(info->sides);
+
+  if (sides->elem_count < 2)
+    return;
+
+  p4est_iter_face_side_t *side[2];
+  side[0] = p4est_iter_fside_array_index_int(sides, 0);
+  side[1] = p4est_iter_fside_array_index_int(sides, 1);
+
+  /*-------------------------------------------------------
+  | Gather the quads on both sides of the face
+  | Hanging face: There are 2^(d-1) (P4EST_HALF) subfaces
+  |------------------------------------------------------*/
+  QuadData_t *qData[2][P4EST_HALF];
+  int         isGhost[2][P4EST_HALF];
+  int         nSide[2];
+  int         s, i, j;
+
+  for (s = 0; s < 2; s++)
+  {
+    if (side[s]->is_hanging)
+    {
+      nSide[s] = P4EST_HALF;
+
+      for (i = 0; i < P4EST_HALF; i++)
+      {
+        isGhost[s][i] = side[s]->is.hanging.is_ghost[i];
+
+        if (isGhost[s][i])
+          qData[s][i] = &ghostData[side[s]->is.hanging.quadid[i]];
+        else
+          qData[s][i] = (QuadData_t *) 
+                        side[s]->is.hanging.quad[i]->p.user_data;
+      }
+    }
+    else
+    {
+      nSide[s]      = 1;
+      isGhost[s][0] = side[s]->is.full.is_ghost;
+
+      if (isGhost[s][0])
+        qData[s][0] = &ghostData[side[s]->is.full.quadid];
+      else
+        qData[s][0] = (QuadData_t *) 
+                      side[s]->is.full.quad->p.user_data;
+    }
+  }
+
+  /*-------------------------------------------------------
+  | Pass feature distance in both directions
+  |------------------------------------------------------*/
+  for (i = 0; i < nSide[0]; i++)
+  {
+    for (j = 0; j < nSide[1]; j++)
+    {
+      propagateReach(qData[0][i], side[0]->face, 
+                     qData[1][j], isGhost[1][j]);
+      propagateReach(qData[1][j], side[1]->face, 
+                     qData[0][i], isGhost[0][i]);
+    }
+  }
+
+} /* advectReach() */
+
+/***********************************************************
+* predictRefinement()
+*-----------------------------------------------------------
+* Function to flag quads for refinement, which will be 
+* reached by a feature until the next grid adaptation.
+*
+* Every quad with an indicator above the refinement 
+* threshold (or flagged for refinement) is a feature quad
+* and obtains the advection distance
+*   adaptReach = |u| * refinePeriod * dt 
+* This distance is passed across the outflow faces 
+* (mflux > 0) to the neighbouring quads, reduced by their
+* size. Every quad that has been reached is flagged for 
+* refinement. 
+* The number of sweeps follows from the largest ratio of 
+* advection distance to quad size of all features and is 
+* limited by OCT_PREDICT_MAX_SWEEPS.
+***********************************************************/
+static void predictRefinement(SimData_t *simData, 
+                              octDouble  refThresh)
+{
+  p4est_t       *p4est       = simData->p4est;
+  SimParam_t    *simParam    = simData->simParam;
+  SolverParam_t *solverParam = simData->solverParam;
+
+  const octDouble *indicator = (octDouble *) 
+                               simData->indicator->array;
+
+  octDouble tReach = solverParam->refinePeriod * simParam->timestep;
+
+  int maxRefLvl = solverParam->maxRefLvl;
+
+  p4est_topidx_t which_tree;
+  size_t         i;
+
+  /*--------------------------------------------------------
+  | Initial advection distance of feature quads
+  --------------------------------------------------------*/
+  octDouble nCells_loc = 0.0;
+  octDouble nCells     = 0.0;
+
+  for (which_tree  = p4est->first_local_tree; 
+       which_tree <= p4est->last_local_tree; 
+       which_tree++)
+  {
+    p4est_tree_t     *tree  = p4est_tree_array_index(p4est->trees, 
+                                                     which_tree);
+    p4est_quadrant_t *quads = (p4est_quadrant_t *) 
+                              tree->quadrants.array;
+    size_t            nQuads = tree->quadrants.elem_count;
+
+    const octDouble *treeInd = &indicator[tree->quadrants_offset];
+
+    for (i = 0; i < nQuads; i++)
+    {
+      QuadData_t *quadData = (QuadData_t *) quads[i].p.user_data;
+
+      quadData->adaptReach = -1.0;
+
+      if (  treeInd[i] <= refThresh 
+         && quadData->adaptFlag != ADAPT_REFINE )
+        continue;
+
+      octDouble *vars = quadData->vars;
+#ifdef P4_TO_P8
+      octDouble u2 = vars[IVX]*vars[IVX] + vars[IVY]*vars[IVY]
+                   + vars[IVZ]*vars[IVZ];
+#else
+      octDouble u2 = vars[IVX]*vars[IVX] + vars[IVY]*vars[IVY];
+#endif
+      octDouble h  = pow(quadData->volume, 1.0 / P4EST_DIM);
+
+      quadData->adaptReach = sqrt(u2) * tReach;
+
+      nCells_loc = MAX(nCells_loc, quadData->adaptReach / h);
+    }
+  }
+
+  sc_MPI_Allreduce(&nCells_loc,
+                   &nCells,
+                   1,
+                   sc_MPI_DOUBLE,
+                   sc_MPI_MAX,
+                   simData->mpiParam->mpiComm);
+
+  int nSweeps = MIN( (int) ceil(nCells), OCT_PREDICT_MAX_SWEEPS );
+  int k;
+
+  /*--------------------------------------------------------
+  | Advect feature distances 
+  --------------------------------------------------------*/
+  if (!simData->ghost)
+    init_ghostData(simData);
+
+  for (k = 0; k < nSweeps; k++)
+  {
+    p4est_ghost_exchange_data(p4est, 
+                              simData->ghost, 
+                              simData->ghostData);
+
+    p4est_iterate(p4est, 
+                  simData->ghost, 
+                  (void *) simData->ghostData,
+                  NULL,          // cell callback
+                  advectReach,   // face callback
+#ifdef P4_TO_P8
+                  NULL,          // edge callback
+#endif
+                  NULL);         // corner callback
+  }
+
+  /*--------------------------------------------------------
+  | Flag reached quads for refinement
+  --------------------------------------------------------*/
+  for (which_tree  = p4est->first_local_tree; 
+       which_tree <= p4est->last_local_tree; 
+       which_tree++)
+  {
+    p4est_tree_t     *tree  = p4est_tree_array_index(p4est->trees, 
+                                                     which_tree);
+    p4est_quadrant_t *quads = (p4est_quadrant_t *) 
+                              tree->quadrants.array;
+    size_t            nQuads = tree->quadrants.elem_count;
+
+    for (i = 0; i < nQuads; i++)
+    {
+      QuadData_t *quadData = (QuadData_t *) quads[i].p.user_data;
+
+      if (  quadData->adaptReach >= 0.0
+         && quads[i].level < maxRefLvl )
+        quadData->adaptFlag = ADAPT_REFINE;
+    }
+  }
+
+} /* predictRefinement() */
+
+/***********************************************************
+* capRefinement()
+*-----------------------------------------------------------
+* Enforces the maximum number of quads 
+* (solverParam->quadMax) after all sources of refinement
+* flags have been evaluated. 
+*
+* If more than (quadMax - N) / (2^d - 1) quads are flagged
+* for refinement, the flags of the quads with the lowest 
+* indicators are changed to ADAPT_HOLD, such that the 
+* remaining flags fit into the budget. The threshold is 
+* chosen from a global histogram of the indicators of the
+* flagged quads (see histRefineThresh()).
+*
+* The remaining budget is distributed evenly to all 
+* processes (simData->refineBudget) for quads, that 
+* are evaluated directly during the adaptation.
+* The subsequent 2:1 balance may still add quads.
+***********************************************************/
+static void capRefinement(SimData_t *simData)
+{
+  p4est_t       *p4est       = simData->p4est;
+  SolverParam_t *solverParam = simData->solverParam;
+
+  const octDouble *indicator = (octDouble *) 
+                               simData->indicator->array;
+
+  long nQuads  = (long) p4est->global_num_quadrants;
+  long nRefMax = MAX(0, solverParam->quadMax - nQuads) 
+               / (P4EST_CHILDREN - 1);
+
+  p4est_topidx_t which_tree;
+  p4est_locidx_t i;
+  int            b;
+
+  long nRef_loc = 0;
+  long nRef     = 0;
+
+  /*--------------------------------------------------------
+  | Global number of flagged quads and range of their
+  | log10(indicator)
+  | -> Minimum is stored negated -> single reduction
+  --------------------------------------------------------*/
+  octDouble lRange_loc[2] = { -DBL_MAX, -DBL_MAX };
+  octDouble lRange[2]     = { 0.0, 0.0 };
+
+  for (which_tree  = p4est->first_local_tree; 
+       which_tree <= p4est->last_local_tree; 
+       which_tree++)
+  {
+    p4est_tree_t     *tree  = p4est_tree_array_index(p4est->trees, 
+                                                     which_tree);
+    p4est_quadrant_t *quads = (p4est_quadrant_t *) 
+                              tree->quadrants.array;
+    p4est_locidx_t    nTree = (p4est_locidx_t) 
+                              tree->quadrants.elem_count;
+
+    const octDouble *treeInd = &indicator[tree->quadrants_offset];
+
+    for (i = 0; i < nTree; i++)
+    {
+      QuadData_t *quadData = (QuadData_t *) quads[i].p.user_data;
+
+      if (quadData->adaptFlag != ADAPT_REFINE)
+        continue;
+
+      nRef_loc += 1;
+
+      if (treeInd[i] <= 0.0)
+        continue;
+
+      const octDouble l = log10(treeInd[i]);
+
+      lRange_loc[0] = MAX(lRange_loc[0], -l);
+      lRange_loc[1] = MAX(lRange_loc[1],  l);
+    }
+  }
+
+  sc_MPI_Allreduce(lRange_loc,
+                   lRange,
+                   2,
+                   sc_MPI_DOUBLE,
+                   sc_MPI_MAX,
+                   simData->mpiParam->mpiComm);
+
+  sc_MPI_Allreduce(&nRef_loc,
+                   &nRef,
+                   1,
+                   sc_MPI_LONG,
+                   sc_MPI_SUM,
+                   simData->mpiParam->mpiComm);
+
+  lRange[0] = -lRange[0];
+
+  /*--------------------------------------------------------
+  | Histogram of flagged quads and threshold, if the 
+  | budget is exceeded
+  --------------------------------------------------------*/
+  if (nRef > nRefMax)
+  {
+    long hist_loc[OCT_BUDGET_BINS];
+    long hist[OCT_BUDGET_BINS];
+
+    for (b = 0; b < OCT_BUDGET_BINS; b++)
+      hist_loc[b] = 0;
+
+    for (which_tree  = p4est->first_local_tree; 
+         which_tree <= p4est->last_local_tree; 
+         which_tree++)
+    {
+      p4est_tree_t     *tree  = p4est_tree_array_index(p4est->trees, 
+                                                       which_tree);
+      p4est_quadrant_t *quads = (p4est_quadrant_t *) 
+                                tree->quadrants.array;
+      p4est_locidx_t    nTree = (p4est_locidx_t) 
+                                tree->quadrants.elem_count;
+
+      const octDouble *treeInd = &indicator[tree->quadrants_offset];
+
+      for (i = 0; i < nTree; i++)
+      {
+        QuadData_t *quadData = (QuadData_t *) quads[i].p.user_data;
+
+        if (quadData->adaptFlag == ADAPT_REFINE)
+          hist_loc[indicatorBin(treeInd[i], lRange)] += 1;
+      }
+    }
+
+    sc_MPI_Allreduce(hist_loc,
+                     hist,
+                     OCT_BUDGET_BINS,
+                     sc_MPI_LONG,
+                     sc_MPI_SUM,
+                     simData->mpiParam->mpiComm);
+
+    octDouble thresh = histRefineThresh(hist, nRefMax, lRange);
+
+    simData->refThresh = MAX(simData->refThresh, thresh);
+
+    /*------------------------------------------------------
+    | Remove flags below the threshold
+    ------------------------------------------------------*/
+    nRef_loc = 0;
+
+    for (which_tree  = p4est->first_local_tree; 
+         which_tree <= p4est->last_local_tree; 
+         which_tree++)
+    {
+      p4est_tree_t     *tree  = p4est_tree_array_index(p4est->trees, 
+                                                       which_tree);
+      p4est_quadrant_t *quads = (p4est_quadrant_t *) 
+                                tree->quadrants.array;
+      p4est_locidx_t    nTree = (p4est_locidx_t) 
+                                tree->quadrants.elem_count;
+
+      const octDouble *treeInd = &indicator[tree->quadrants_offset];
+
+      for (i = 0; i < nTree; i++)
+      {
+        QuadData_t *quadData = (QuadData_t *) quads[i].p.user_data;
+
+        if (quadData->adaptFlag != ADAPT_REFINE)
+          continue;
+
+        if (treeInd[i] <= thresh)
+          quadData->adaptFlag = ADAPT_HOLD;
+        else
+          nRef_loc += 1;
+      }
+    }
+
+    sc_MPI_Allreduce(&nRef_loc,
+                     &nRef,
+                     1,
+                     sc_MPI_LONG,
+                     sc_MPI_SUM,
+                     simData->mpiParam->mpiComm);
+
+    octPrint("QUAD BUDGET: REFINEMENT CAPPED TO %ld QUADS "
+             "| REFINE > %9.3e", nRef, thresh);
+  }
+
+  /*--------------------------------------------------------
+  | Remaining budget for quads, that are created during 
+  | the adaptation
+  --------------------------------------------------------*/
+  simData->refineBudget = (p4est_locidx_t) 
+    ( MAX(0, nRefMax - nRef) / p4est->mpisize );
+
+} /* capRefinement() */
+
+/***********************************************************
+* computeAdaptFlags()
+*-----------------------------------------------------------
+* Computes the refinement indicator and the refine /
+* coarsen / keep flag for every local quad.
+*
+* The local quads are traversed directly through the 
+* quadrant arrays of the local trees:
+*   1) The combined indicator adaptIndicator() is computed
+*      for all local quads 
+*   2) In budget mode, the thresholds for refinement and
+*      coarsening are chosen from the global distribution 
+*      of the indicators (see budgetThresholds())
+*   3) Quads are flagged for refinement, if the indicator
+*      exceeds the refinement threshold (1.0 or the budget
+*      threshold) or if the user-defined refinement 
+*      function requests it
+*   4) Optionally, quads downstream of flagged quads are
+*      flagged for refinement (see predictRefinement())
+*      Quads inside of static refinement zones are flagged
+*      for refinement or protected from coarsening 
+*      (see markZones())
+*   5) If a maximum number of quads is set, the refinement
+*      flags of all sources are capped (see 
+*      capRefinement())
+*   6) Complete families of quads, that are not flagged 
+*      for refinement and that have not been refined 
+*      within the last minRefineAge adaptations, are 
+*      flagged for coarsening, if 
+*        - the error estimate of the coarse quad is below
+*          coarsenRatio times the refinement threshold
+*          (or coarsening_scalarError() requests it for 
+*          coarsenRatio = 0)
+*        - the user-defined coarsening function requests it
+*        - their indicator is below the budget coarsening 
+*          threshold
+*
+* The local number of quads flagged for refinement and of
+* families flagged for coarsening is returned in 
+* <nFlagged>.
+***********************************************************/
+void computeAdaptFlags(SimData_t *simData, long nFlagged[2])
+{
+  p4est_t       *p4est       = simData->p4est;
+  SimParam_t    *simParam    = simData->simParam;
+  SolverParam_t *solverParam = simData->solverParam;
+
+  octDouble refThresh    = 1.0;
+  octDouble coarseThresh = -1.0;
+
+  int       maxRefLvl    = solverParam->maxRefLvl;
+  int       minAge       = solverParam->minRefineAge;
+  octDouble coarsenRatio = solverParam->coarsenRatio;
+
+  p4est_topidx_t    which_tree;
+  p4est_quadrant_t *children[P4EST_CHILDREN];
+
+  nFlagged[0] = 0;
+  nFlagged[1] = 0;
+
+  /*--------------------------------------------------------
+  | Flat array of indicators for all local quads
+  --------------------------------------------------------*/
+  if (simData->indicator == NULL)
+    simData->indicator = sc_array_new(sizeof(octDouble));
+
+  sc_array_resize(simData->indicator, 
+                  (size_t) p4est->local_num_quadrants);
+
+  octDouble *indicator = (octDouble *) simData->indicator->array;
+
+  for (which_tree  = p4est->first_local_tree; 
+       which_tree <= p4est->last_local_tree; 
+       which_tree++)
+  {
+    p4est_tree_t     *tree  = p4est_tree_array_index(p4est->trees, 
+                                                     which_tree);
+    p4est_quadrant_t *quads = (p4est_quadrant_t *) 
+                              tree->quadrants.array;
+    size_t            nQuads = tree->quadrants.elem_count;
+
+    octDouble *treeInd = &indicator[tree->quadrants_offset];
+
+    size_t i;
+
+    for (i = 0; i < nQuads; i++)
+    {
+      QuadData_t *quadData = (QuadData_t *) quads[i].p.user_data;
+
+      treeInd[i] = adaptIndicator(solverParam, &quads[i]);
+
+      quadData->adaptAge = MIN(quadData->adaptAge + 1, 
+                               OCT_ADAPT_AGE_MAX);
+    }
+  }
+
+  /*--------------------------------------------------------
+  | Thresholds from quad budget
+  --------------------------------------------------------*/
+  if (solverParam->quadTarget > 0)
+    budgetThresholds(simData, refThresh, 
+                     &refThresh, &coarseThresh);
+
+  simData->refThresh    = refThresh;
+  simData->refineBudget = -1;
+
+  /*--------------------------------------------------------
+  | Refinement flags
+  --------------------------------------------------------*/
+  for (which_tree  = p4est->first_local_tree; 
+       which_tree <= p4est->last_local_tree; 
+       which_tree++)
+  {
+    p4est_tree_t     *tree  = p4est_tree_array_index(p4est->trees, 
+                                                     which_tree);
+    p4est_quadrant_t *quads = (p4est_quadrant_t *) 
+                              tree->quadrants.array;
+    size_t            nQuads = tree->quadrants.elem_count;
+
+    octDouble *treeInd = &indicator[tree->quadrants_offset];
+
+    size_t i;
+
+    for (i = 0; i < nQuads; i++)
+    {
+      QuadData_t *quadData = (QuadData_t *) quads[i].p.user_data;
+
+      int refine = (treeInd[i] > refThresh);
+
+      if (simParam->usrRefineFun != NULL)
+        refine |= simParam->usrRefineFun(p4est, which_tree, 
+                                         &quads[i]);
+
+      if (refine && quads[i].level < maxRefLvl)
+        quadData->adaptFlag = ADAPT_REFINE;
+      else
+        quadData->adaptFlag = ADAPT_KEEP;
+    }
+  }
+
+  /*--------------------------------------------------------
+  | Refine ahead of features, that are advected into 
+  | coarser regions until the next adaptation 
+  --------------------------------------------------------*/
+  if (solverParam->predictRefine == TRUE)
+    predictRefinement(simData, refThresh);
+
+  /*--------------------------------------------------------
+  | Static refinement zones
+  --------------------------------------------------------*/
+  markZones(simData);
+
+  /*--------------------------------------------------------
+  | Maximum number of quads
+  --------------------------------------------------------*/
+  if (solverParam->quadMax > 0)
+    capRefinement(simData);
+
+  /*--------------------------------------------------------
+  | Coarsening flags for complete families 
+  | -> Refinement flags are counted in the same sweep
+  --------------------------------------------------------*/
+  for (which_tree  = p4est->first_local_tree; 
+       which_tree <= p4est->last_local_tree; 
+       which_tree++)
+  {
+    p4est_tree_t     *tree  = p4est_tree_array_index(p4est->trees, 
+                                                     which_tree);
+    p4est_quadrant_t *quads = (p4est_quadrant_t *) 
+                              tree->quadrants.array;
+    size_t            nQuads = tree->quadrants.elem_count;
+
+    octDouble *treeInd = &indicator[tree->quadrants_offset];
+
+    size_t i = 0; 
+    size_t j;
+
+    for (j = 0; j < nQuads; j++)
+    {
+      QuadData_t *quadData = (QuadData_t *) quads[j].p.user_data;
+      nFlagged[0] += (quadData->adaptFlag == ADAPT_REFINE);
+    }
+
+    while (i + P4EST_CHILDREN <= nQuads)
+    {
+      if (!p4est_quadrant_is_familyv(&quads[i]))
+      {
+        i++;
+        continue;
+      }
+
+      int coarsen = 1;
+
+      for (j = 0; j < P4EST_CHILDREN; j++)
+      {
+        QuadData_t *quadData = (QuadData_t *) 
+                               quads[i+j].p.user_data;
+
+        children[j] = &quads[i+j];
+        coarsen    &= (quadData->adaptFlag == ADAPT_KEEP);
+        coarsen    &= (quadData->adaptAge  >= minAge);
+      }
+
+      if (coarsen)
+      {
+        const octDouble famInd = familyIndicator(&treeInd[i]);
+
+        if (coarsenRatio > 0.0)
+          coarsen = coarsenByHysteresis(famInd, refThresh, 
+                                        coarsenRatio);
+        else
+          coarsen = coarsening_scalarError(p4est, which_tree, 
+                                           children);
+
+        coarsen |= (famInd < coarseThresh);
+
+        if (simParam->usrCoarseFun != NULL)
+          coarsen |= simParam->usrCoarseFun(p4est, which_tree, 
+                                            children);
+      }
+
+      if (coarsen)
+      {
+        nFlagged[1] += 1;
+
+        for (j = 0; j < P4EST_CHILDREN; j++)
+        {
+          QuadData_t *quadData = (QuadData_t *) 
+                                 quads[i+j].p.user_data;
+          quadData->adaptFlag = ADAPT_COARSEN;
+        }
+      }
+
+      i += P4EST_CHILDREN;
+    }
+  }
+
+} /* computeAdaptFlags() */
+
+/***********************************************************
+* Neighbourhood bounds of the state variables of a quad
+* for the limited prolongation
+***********************************************************/
+typedef struct LimitBounds_t
+{
+  octDouble vMin[OCT_STATE_VARS];
+  octDouble vMax[OCT_STATE_VARS];
+} LimitBounds_t;
+
+typedef struct LimitContext_t
+{
+  QuadData_t    *ghostData;
+  LimitBounds_t *bounds;
+} LimitContext_t;
+
+/***********************************************************
+* updateBounds()
+*-----------------------------------------------------------
+* Extends the bounds of the local quad <dst> by the state 
+* of its neighbour <src>
+***********************************************************/
+static inline void updateBounds(LimitBounds_t *dst, 
+                                QuadData_t    *src)
+{
+  int j;
+
+  for (j = 0; j < OCT_STATE_VARS; j++)
+  {
+    const octDouble v = src->vars[OCT_SOLVER_VARS + j];
+
+    dst->vMin[j] = MIN(dst->vMin[j], v);
+    dst->vMax[j] = MAX(dst->vMax[j], v);
+  }
+
+} /* updateBounds() */
+
+/***********************************************************
+* gatherBounds()
+*-----------------------------------------------------------
+* Function to gather the minimum and maximum state of the
+* face neighbours of every local quad
+*
+*   -> p4est_iter_face_t callback function
+***********************************************************/
+static void gatherBounds(p4est_iter_face_info_t *info,
+                         void                   *user_data)
+{
+  LimitContext_t *ctx = (LimitContext_t *) user_data;
+
+  sc_array_t *sides = &(info->sides);
+
+  if (sides->elem_count != 2)
+    return;
+
+  p4est_iter_face_side_t *side[2];
+  side[0] = p4est_iter_fside_array_index_int(sides, 0);
+  side[1] = p4est_iter_fside_array_index_int(sides, 1);
+
+  /*-------------------------------------------------------
+  | Gather the quads on both sides of the face
+  |------------------------------------------------------*/
+  QuadData_t    *qData[2][P4EST_HALF];
+  LimitBounds_t *qBnds[2][P4EST_HALF];
+  int            nSide[2];
+  int            s, i, j;
+
+  for (s = 0; s < 2; s++)
+  {
+    p4est_tree_t *tree = p4est_tree_array_index(info->p4est->trees,
+                                                side[s]->treeid);
+    nSide[s] = side[s]->is_hanging ? P4EST_HALF : 1;
+
+    for (i = 0; i < nSide[s]; i++)
+    {
+      int8_t            isGhost;
+      p4est_locidx_t    quadid;
+      p4est_quadrant_t *quad;
+
+      if (side[s]->is_hanging)
+      {
+        isGhost = side[s]->is.hanging.is_ghost[i];
+        quadid  = side[s]->is.hanging.quadid[i];
+        quad    = side[s]->is.hanging.quad[i];
+      }
+      else
+      {
+        isGhost = side[s]->is.full.is_ghost;
+        quadid  = side[s]->is.full.quadid;
+        quad    = side[s]->is.full.quad;
+      }
+
+      if (isGhost)
+      {
+        qData[s][i] = &ctx->ghostData[quadid];
+        qBnds[s][i] = NULL;
+      }
+      else
+      {
+        qData[s][i] = (QuadData_t *) quad->p.user_data;
+        qBnds[s][i] = &ctx->bounds[tree->quadrants_offset + quadid];
+      }
+    }
+  }
+
+  /*-------------------------------------------------------
+  | Extend bounds of the local quads
+  |------------------------------------------------------*/
+  for (i = 0; i < nSide[0]; i++)
+  {
+    for (j = 0; j < nSide[1]; j++)
+    {
+      if (qBnds[0][i] != NULL)
+        updateBounds(qBnds[0][i], qData[1][j]);
+      if (qBnds[1][j] != NULL)
+        updateBounds(qBnds[1][j], qData[0][i]);
+    }
+  }
+
+} /* gatherBounds() */
+
+/***********************************************************
+* limitProlongation()
+*-----------------------------------------------------------
+* Computes the limiters of the state gradients, which are 
+* used in interpQuadData() to prolongate the state of a 
+* refined quad to its children 
+* (QuadData_t->prolongLim, the gradients are not changed).
+*
+* The limiter of every local quad is computed, since any 
+* quad may be refined by the 2:1 balance. It follows the
+* Barth-Jespersen limiter
+*   phi = min(1, (vMax - v) / dv, (v - vMin) / dv)
+* where dv = sum_k |grad_k| * h_k / 2 is the largest 
+* deviation from the quad state within the quad (at its 
+* vertices) and vMin / vMax are the extrema of the quad 
+* and its face neighbours. 
+* The limited reconstruction is therefore bounded in the
+* entire quad, which also covers the grandchildren of a 
+* recursive refinement (see interpQuadData()).
+***********************************************************/
+void limitProlongation(SimData_t *simData)
+{
+  p4est_t *p4est = simData->p4est;
+
+  p4est_topidx_t which_tree;
+  size_t         i;
+  int            j, k;
+
+  LimitBounds_t *bounds = P4EST_ALLOC(LimitBounds_t, 
+                                      p4est->local_num_quadrants);
+
+  /*--------------------------------------------------------
+  | Initialize bounds with the state of the quads
+  --------------------------------------------------------*/
+  for (which_tree  = p4est->first_local_tree; 
+       which_tree <= p4est->last_local_tree; 
+       which_tree++)
+  {
+    p4est_tree_t     *tree  = p4est_tree_array_index(p4est->trees, 
+                                                     which_tree);
+    p4est_quadrant_t *quads = (p4est_quadrant_t *) 
+                              tree->quadrants.array;
+    size_t            nQuads = tree->quadrants.elem_count;
+
+    for (i = 0; i < nQuads; i++)
+    {
+      QuadData_t    *quadData = (QuadData_t *) quads[i].p.user_data;
+      LimitBounds_t *bnds     = &bounds[tree->quadrants_offset + i];
+
+      for (j = 0; j < OCT_STATE_VARS; j++)
+      {
+        bnds->vMin[j] = quadData->vars[OCT_SOLVER_VARS + j];
+        bnds->vMax[j] = quadData->vars[OCT_SOLVER_VARS + j];
+      }
+    }
+  }
+
+  /*--------------------------------------------------------
+  | Gather neighbour extrema
+  --------------------------------------------------------*/
+  if (!simData->ghost)
+    init_ghostData(simData);
+
+  p4est_ghost_exchange_data(p4est, 
+                            simData->ghost, 
+                            simData->ghostData);
+
+  LimitContext_t ctx = { simData->ghostData, bounds };
+
+  p4est_iterate(p4est, 
+                simData->ghost, 
+                (void *) &ctx,
+                NULL,          // cell callback
+                gatherBounds,  // face callback
+#ifdef P4_TO_P8
+                NULL,          // edge callback
+#endif
+                NULL);         // corner callback
+
+  /*--------------------------------------------------------
+  | Limiters of all local quads
+  --------------------------------------------------------*/
+  for (which_tree  = p4est->first_local_tree; 
+       which_tree <= p4est->last_local_tree; 
+       which_tree++)
+  {
+    p4est_tree_t     *tree  = p4est_tree_array_index(p4est->trees, 
+                                                     which_tree);
+    p4est_quadrant_t *quads = (p4est_quadrant_t *) 
+                              tree->quadrants.array;
+    size_t            nQuads = tree->quadrants.elem_count;
+
+    for (i = 0; i < nQuads; i++)
+    {
+      QuadData_t    *quadData = (QuadData_t *) quads[i].p.user_data;
+      LimitBounds_t *bnds     = &bounds[tree->quadrants_offset + i];
+
+      octDouble h[P4EST_DIM];
+
+#ifdef OCT_MAPPED_GEOMETRY
+      for (k = 0; k < P4EST_DIM; k++)
+        h[k] = pow(quadData->volume, 1.0 / P4EST_DIM);
+#else
+      for (k = 0; k < P4EST_DIM; k++)
+        h[k] = simData->geomTable->h[quads[i].level][k];
+#endif
+
+      for (j = 0; j < OCT_STATE_VARS; j++)
+      {
+        const octDouble *grad = quadData->grad_vars[OCT_SOLVER_VARS + j];
+        const octDouble  v    = quadData->vars[OCT_SOLVER_VARS + j];
+        octDouble        dv   = 0.0;
+        octDouble        phi  = 1.0;
+
+        for (k = 0; k < P4EST_DIM; k++)
+          dv += 0.5 * h[k] * fabs(grad[k]);
+
+        if (dv > 0.0)
+        {
+          phi = MIN(phi, (bnds->vMax[j] - v) / dv);
+          phi = MIN(phi, (v - bnds->vMin[j]) / dv);
+          phi = MAX(phi, 0.0);
+        }
+
+        quadData->prolongLim[j] = phi;
+      }
+    }
+  }
+
+  P4EST_FREE(bounds);
+
+} /* limitProlongation() */
+
+/***********************************************************
+* adaptMesh()
+*-----------------------------------------------------------
+* Adapts the grid according to the flags of the indicator 
+* pass computeAdaptFlags().
+*
+* The number of flagged quads is exchanged in a single
+* reduction, such that the traversals of the forest by 
+* p4est_refine_ext(), p4est_coarsen_ext() and 
+* p4est_balance_ext() are only performed, if required:
+*   - refinement only, if any quad is flagged for refinement
+*   - coarsening only, if any family is flagged for 
+*     coarsening 
+*   - 2:1 balance only, if the grid has been refined or 
+*     coarsened
+* 
+* Returns the global number of quads, that have been 
+* created by the adaptation (0 if the grid is unchanged).
+***********************************************************/
+p4est_gloidx_t adaptMesh(SimData_t *simData)
+{
+  p4est_t       *p4est       = simData->p4est;
+  SolverParam_t *solverParam = simData->solverParam;
+
+  long nFlagged_loc[2] = { 0, 0 };
+  long nFlagged[2]     = { 0, 0 };
+
+  computeAdaptFlags(simData, nFlagged_loc);
+
+  sc_MPI_Allreduce(nFlagged_loc,
+                   nFlagged,
+                   2,
+                   sc_MPI_LONG,
+                   sc_MPI_SUM,
+                   simData->mpiParam->mpiComm);
+
+  if (nFlagged[0] == 0 && nFlagged[1] == 0)
+    return 0;
+
+  simData->nAdaptedQuads = 0;
+
+  /*--------------------------------------------------------
+  | Limiters for all quads -> also required, if only the 
+  | balance refines quads after coarsening
+  --------------------------------------------------------*/
+  limitProlongation(simData);
+
+  if (nFlagged[0] > 0)
+    p4est_refine_ext(p4est,
+                     solverParam->recursive,
+                     solverParam->maxRefLvl,
+                     globalRefinement,
+                     NULL,
+                     interpQuadData);
+
+  if (nFlagged[1] > 0)
+    p4est_coarsen_ext(p4est, 
+                      solverParam->recursive, 
+                      0,
+                      globalCoarsening, 
+                      NULL,
+                      interpQuadData);
+
+  p4est_balance_ext(p4est, 
+                    P4EST_CONNECT_FACE, 
+                    NULL,
+                    interpQuadData);
+
+  return exchangeMeshChanges(simData);
+
+} /* adaptMesh() */
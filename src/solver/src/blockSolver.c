@@ -0,0 +1,793 @@
+/*
+* This file is part of OctFS. 
+* OctFS is a finite-volume flow solver with adaptive
+* mesh refinement written in C, which is based on 
+* the p4est library.
+*
+* Copyright (C) 2020 Florian Setzwein 
+*
+* OctFS is free software; you can redistribute it and/or 
+* modify it under the terms of the GNU General Public 
+* License as published by the Free Software Foundation; 
+* either version 2 of the License, or (at your option) 
+* any later version.
+*
+* OctFS is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied 
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR 
+* PURPOSE.  See the GNU General Public License for more 
+* details.
+*
+* You should have received a copy of the GNU General 
+* Public License along with OctFS; if not, write to the 
+* Free Software Foundation, Inc., 51 Franklin Street, 
+* Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+#include <math.h>
+
+#include "solver/typedefs.h"
+#include "solver/util.h"
+#include "solver/simData.h"
+#include "solver/quadData.h"
+#include "solver/fluxConvection.h"
+#include "solver/timeIntegral.h"
+#include "solver/linearSolver.h"
+#include "solver/solveTranEq.h"
+#include "solver/blockSolver.h"
+#include "aux/dbg.h"
+
+#ifndef P4_TO_P8
+#include <p4est_bits.h>
+#include <p4est_extended.h>
+#include <p4est_iterate.h>
+#include <p4est_ghost.h>
+#else
+#include <p8est_bits.h>
+#include <p8est_extended.h>
+#include <p8est_iterate.h>
+#include <p8est_ghost.h>
+#endif
+
+/***********************************************************
+* Access to the components of Krylov vector <b> of the 
+* local quad <q>
+***********************************************************/
+#define BLOCK_BUF(sys, q, b) \
+  ( &(sys)->buf[ ((size_t) (q) * OCT_BLOCK_BUFS + (b)) * (sys)->nRhs ] )
+
+/***********************************************************
+* init_blockSystem()
+*-----------------------------------------------------------
+* Initializes a block equation system for the variables
+* <xIds>. The solution vector is initialized with the 
+* current state of the variables, all other Krylov
+* vectors are set to zero.
+***********************************************************/
+static void init_blockSystem(BlockSystem_t *sys,
+                             SimData_t     *simData,
+                             const int     *xIds,
+                             int            nRhs)
+{
+  p4est_t       *p4est = simData->p4est;
+  p4est_ghost_t *ghost = simData->ghost;
+
+  const size_t nGhosts  = ghost->ghosts.elem_count;
+  const size_t nMirrors = ghost->mirrors.elem_count;
+
+  int c;
+
+  sys->simData = simData;
+  sys->nRhs    = nRhs;
+  sys->nLocal  = p4est->local_num_quadrants;
+
+  for (c = 0; c < nRhs; c++)
+    sys->xIds[c] = xIds[c];
+
+  sys->buf       = P4EST_ALLOC_ZERO(octDouble, 
+                     (size_t) sys->nLocal * OCT_BLOCK_BUFS * nRhs);
+  sys->ghostBuf  = P4EST_ALLOC(octDouble, MAX(nGhosts, 1) * nRhs);
+  sys->mirrorBuf = P4EST_ALLOC(void *, MAX(nMirrors, 1));
+
+  sys->fluxFac   = simData->simParam->tempFluxFac[
+                     simData->simParam->tempScheme];
+  sys->dt        = simData->simParam->timestep;
+
+  sys->xBuf      = BX;
+  sys->AxBuf     = BAX;
+
+} /* init_blockSystem() */
+
+/***********************************************************
+* destroy_blockSystem()
+*-----------------------------------------------------------
+* Frees all memory of a block equation system
+***********************************************************/
+static void destroy_blockSystem(BlockSystem_t *sys)
+{
+  P4EST_FREE(sys->buf);
+  P4EST_FREE(sys->ghostBuf);
+  P4EST_FREE(sys->mirrorBuf);
+
+} /* destroy_blockSystem() */
+
+/***********************************************************
+* blockGather()
+*-----------------------------------------------------------
+* Copies the variable <varIdx> of all local quads into 
+* component <c> of Krylov vector <b>
+***********************************************************/
+static void blockGather(BlockSystem_t *sys, 
+                        int varIdx, int b, int c)
+{
+  p4est_t *p4est = sys->simData->p4est;
+
+  p4est_topidx_t which_tree;
+  size_t         i;
+
+  for (which_tree  = p4est->first_local_tree; 
+       which_tree <= p4est->last_local_tree; 
+       which_tree++)
+  {
+    p4est_tree_t     *tree  = p4est_tree_array_index(p4est->trees, 
+                                                     which_tree);
+    p4est_quadrant_t *quads = (p4est_quadrant_t *) 
+                              tree->quadrants.array;
+    size_t            nQuads = tree->quadrants.elem_count;
+
+    for (i = 0; i < nQuads; i++)
+    {
+      QuadData_t *quadData = (QuadData_t *) quads[i].p.user_data;
+
+      BLOCK_BUF(sys, tree->quadrants_offset + i, b)[c] 
+        = quadData->vars[varIdx];
+    }
+  }
+
+} /* blockGather() */
+
+/***********************************************************
+* blockScatter()
+*-----------------------------------------------------------
+* Copies component <c> of Krylov vector <b> into the 
+* variable <varIdx> of all local quads
+***********************************************************/
+static void blockScatter(BlockSystem_t *sys, 
+                         int b, int c, int varIdx)
+{
+  p4est_t *p4est = sys->simData->p4est;
+
+  p4est_topidx_t which_tree;
+  size_t         i;
+
+  for (which_tree  = p4est->first_local_tree; 
+       which_tree <= p4est->last_local_tree; 
+       which_tree++)
+  {
+    p4est_tree_t     *tree  = p4est_tree_array_index(p4est->trees, 
+                                                     which_tree);
+    p4est_quadrant_t *quads = (p4est_quadrant_t *) 
+                              tree->quadrants.array;
+    size_t            nQuads = tree->quadrants.elem_count;
+
+    for (i = 0; i < nQuads; i++)
+    {
+      QuadData_t *quadData = (QuadData_t *) quads[i].p.user_data;
+
+      quadData->vars[varIdx] 
+        = BLOCK_BUF(sys, tree->quadrants_offset + i, b)[c];
+    }
+  }
+
+} /* blockScatter() */
+
+/***********************************************************
+* blockSum()
+*-----------------------------------------------------------
+* Block solver function to add two Krylov vectors a and b
+* according to
+*
+*   c_i = w_a * a_i + w_b * b_i
+*
+* for all active components, with one pair of weights 
+* per component
+***********************************************************/
+static void blockSum(BlockSystem_t   *sys,
+                     int aBuf, int bBuf, int cBuf,
+                     const octDouble *w_a, 
+                     const octDouble *w_b,
+                     const octBool   *active)
+{
+  const int nRhs = sys->nRhs;
+
+  p4est_locidx_t q;
+  int            c;
+
+  for (q = 0; q < sys->nLocal; q++)
+  {
+    const octDouble *a   = BLOCK_BUF(sys, q, aBuf);
+    const octDouble *b   = BLOCK_BUF(sys, q, bBuf);
+    octDouble       *res = BLOCK_BUF(sys, q, cBuf);
+
+    for (c = 0; c < nRhs; c++)
+      if (active[c])
+        res[c] = w_a[c] * a[c] + w_b[c] * b[c];
+  }
+
+} /* blockSum() */
+
+/***********************************************************
+* blockDot()
+*-----------------------------------------------------------
+* Block solver function to compute the <nProd> scalar 
+* products 
+*
+*   res[p * nRhs + c] = sum( a_i * b_i ) 
+*
+* of the Krylov vectors aBuf[p] and bBuf[p] for all 
+* components c. All products are summed over all 
+* processes in a single reduction.
+***********************************************************/
+static void blockDot(BlockSystem_t *sys,
+                     int            nProd,
+                     const int     *aBuf,
+                     const int     *bBuf,
+                     octDouble     *res)
+{
+  const int nRhs = sys->nRhs;
+
+  octDouble res_loc[2 * OCT_BLOCK_MAX_RHS];
+
+  p4est_locidx_t q;
+  int            p, c;
+
+  for (c = 0; c < nProd * nRhs; c++)
+    res_loc[c] = 0.0;
+
+  for (q = 0; q < sys->nLocal; q++)
+  {
+    for (p = 0; p < nProd; p++)
+    {
+      const octDouble *a = BLOCK_BUF(sys, q, aBuf[p]);
+      const octDouble *b = BLOCK_BUF(sys, q, bBuf[p]);
+
+      for (c = 0; c < nRhs; c++)
+        res_loc[p * nRhs + c] += a[c] * b[c];
+    }
+  }
+
+  sc_MPI_Allreduce(res_loc,
+                   res,
+                   nProd * nRhs,
+                   sc_MPI_DOUBLE,
+                   sc_MPI_SUM,
+                   sys->simData->mpiParam->mpiComm);
+
+} /* blockDot() */
+
+/***********************************************************
+* exchangeOperand()
+*-----------------------------------------------------------
+* Exchanges all components of the operand sys->xBuf of 
+* the mirror quads with the neighbouring processes in a
+* single message
+***********************************************************/
+static void exchangeOperand(BlockSystem_t *sys)
+{
+  p4est_t       *p4est = sys->simData->p4est;
+  p4est_ghost_t *ghost = sys->simData->ghost;
+
+  size_t m;
+
+  for (m = 0; m < ghost->mirrors.elem_count; m++)
+  {
+    p4est_quadrant_t *mirror = 
+      p4est_quadrant_array_index(&ghost->mirrors, m);
+
+    sys->mirrorBuf[m] = 
+      (void *) BLOCK_BUF(sys, mirror->p.piggy3.local_num, sys->xBuf);
+  }
+
+  p4est_ghost_exchange_custom(p4est, 
+                              ghost, 
+                              sys->nRhs * sizeof(octDouble),
+                              sys->mirrorBuf,
+                              sys->ghostBuf);
+
+} /* exchangeOperand() */
+
+/***********************************************************
+* addBlockTimeDerivative()
+*-----------------------------------------------------------
+* Function to initialize the product Ax of all components
+* with the temporal derivative.
+* 
+*   -> p4est_iter_volume_t callback function
+***********************************************************/
+static void addBlockTimeDerivative(p4est_iter_volume_info_t *info,
+                                   void *user_data)
+{
+  BlockSystem_t *sys      = (BlockSystem_t *) user_data;
+  QuadData_t    *quadData = (QuadData_t *) info->quad->p.user_data;
+  p4est_tree_t  *tree     = p4est_tree_array_index(info->p4est->trees,
+                                                   info->treeid);
+
+  const p4est_locidx_t q = tree->quadrants_offset + info->quadid;
+
+  const octDouble *x  = BLOCK_BUF(sys, q, sys->xBuf);
+  octDouble       *Ax = BLOCK_BUF(sys, q, sys->AxBuf);
+
+  const octDouble fac = quadData->volume * quadData->vars[IRHO] 
+                      / sys->dt;
+  int c;
+
+  for (c = 0; c < sys->nRhs; c++)
+    Ax[c] = fac * x[c];
+
+} /* addBlockTimeDerivative() */
+
+/***********************************************************
+* addBlockFlux_conv()
+*-----------------------------------------------------------
+* Function to add the implicit part of the convective 
+* fluxes of all components (see addFlux_conv_imp()).
+* 
+*   -> p4est_iter_face_t callback function
+***********************************************************/
+static void addBlockFlux_conv(p4est_iter_face_info_t *info,
+                              void                   *user_data)
+{
+  BlockSystem_t *sys       = (BlockSystem_t *) user_data;
+  QuadData_t    *ghostData = sys->simData->ghostData;
+
+  const int       nRhs    = sys->nRhs;
+  const octDouble fluxFac = sys->fluxFac;
+
+  sc_array_t *sides = &(info->sides);
+
+  if (sides->elem_count < 2)
+    return;
+
+  p4est_iter_face_side_t *side[2];
+  side[0] = p4est_iter_fside_array_index_int(sides, 0);
+  side[1] = p4est_iter_fside_array_index_int(sides, 1);
+
+  /*-------------------------------------------------------
+  | Gather the quads on both sides of the face
+  | Hanging face: There are 2^(d-1) (P4EST_HALF) subfaces
+  |------------------------------------------------------*/
+  QuadData_t *qData[2][P4EST_HALF];
+  octDouble  *x[2][P4EST_HALF];
+  octDouble  *Ax[2][P4EST_HALF];
+  int         nSide[2];
+  int         s, i, c;
+
+  for (s = 0; s < 2; s++)
+  {
+    p4est_tree_t *tree = p4est_tree_array_index(info->p4est->trees,
+                                                side[s]->treeid);
+    nSide[s] = side[s]->is_hanging ? P4EST_HALF : 1;
+
+    for (i = 0; i < nSide[s]; i++)
+    {
+      int8_t            isGhost;
+      p4est_locidx_t    quadid;
+      p4est_quadrant_t *quad;
+
+      if (side[s]->is_hanging)
+      {
+        isGhost = side[s]->is.hanging.is_ghost[i];
+        quadid  = side[s]->is.hanging.quadid[i];
+        quad    = side[s]->is.hanging.quad[i];
+      }
+      else
+      {
+        isGhost = side[s]->is.full.is_ghost;
+        quadid  = side[s]->is.full.quadid;
+        quad    = side[s]->is.full.quad;
+      }
+
+      if (isGhost)
+      {
+        qData[s][i] = &ghostData[quadid];
+        x[s][i]     = &sys->ghostBuf[(size_t) quadid * nRhs];
+        Ax[s][i]    = NULL;
+      }
+      else
+      {
+        p4est_locidx_t q = tree->quadrants_offset + quadid;
+
+        qData[s][i] = (QuadData_t *) quad->p.user_data;
+        x[s][i]     = BLOCK_BUF(sys, q, sys->xBuf);
+        Ax[s][i]    = BLOCK_BUF(sys, q, sys->AxBuf);
+      }
+    }
+  }
+
+  /*-------------------------------------------------------
+  | The massflux is taken from the (smaller) side <o>, 
+  | which has the outward facing normal
+  |------------------------------------------------------*/
+  const int o = side[1]->is_hanging ? 1 : 0;
+  const int f = 1 - o;
+
+  for (i = 0; i < nSide[o]; i++)
+  {
+    const octDouble mflux = qData[o][i]->mflux[side[o]->face];
+
+    for (c = 0; c < nRhs; c++)
+    {
+      const octDouble var_u = UPWIND_DIR(mflux, 
+                                         x[o][i][c],
+                                         x[f][0][c]);
+      const octDouble flux  = fluxFac * var_u * mflux;
+
+      if (Ax[o][i] != NULL)
+        Ax[o][i][c] += flux;
+      if (Ax[f][0] != NULL)
+        Ax[f][0][c] -= flux;
+    }
+  }
+
+} /* addBlockFlux_conv() */
+
+/***********************************************************
+* applyOperator()
+*-----------------------------------------------------------
+* Computes Ax = A * x for all components of the Krylov 
+* vector <xBuf> and stores the result in <AxBuf>
+***********************************************************/
+static void applyOperator(BlockSystem_t *sys, int xBuf, int AxBuf)
+{
+  SimData_t *simData = sys->simData;
+
+  sys->xBuf  = xBuf;
+  sys->AxBuf = AxBuf;
+
+  /*--------------------------------------------------------
+  | Exchange operand of all components
+  --------------------------------------------------------*/
+  exchangeOperand(sys);
+
+  /*--------------------------------------------------------
+  | Temporal derivative and convective fluxes
+  --------------------------------------------------------*/
+  p4est_iterate(simData->p4est, 
+                simData->ghost, 
+                (void *) sys,
+                addBlockTimeDerivative, // cell callback
+                addBlockFlux_conv,      // face callback
+#ifdef P4_TO_P8
+                NULL,                   // edge callback
+#endif
+                NULL);                  // corner callback
+
+} /* applyOperator() */
+
+/***********************************************************
+* blockResidual()
+*-----------------------------------------------------------
+* Computes the global residuals 
+*   res = sqrt( sum( (b - A*x)^2 ) ) / N
+* of all components of the Krylov vector <xBuf>
+***********************************************************/
+static void blockResidual(BlockSystem_t *sys, 
+                          int            xBuf, 
+                          octDouble     *res)
+{
+  const int       nRhs  = sys->nRhs;
+  const octDouble n_inv = 1. / (octDouble) 
+                          sys->simData->p4est->global_num_quadrants;
+
+  octDouble res_loc[OCT_BLOCK_MAX_RHS];
+
+  p4est_locidx_t q;
+  int            c;
+
+  applyOperator(sys, xBuf, BAX);
+
+  for (c = 0; c < nRhs; c++)
+    res_loc[c] = 0.0;
+
+  for (q = 0; q < sys->nLocal; q++)
+  {
+    const octDouble *b  = BLOCK_BUF(sys, q, BB);
+    const octDouble *Ax = BLOCK_BUF(sys, q, BAX);
+
+    for (c = 0; c < nRhs; c++)
+      res_loc[c] += (b[c] - Ax[c]) * (b[c] - Ax[c]);
+  }
+
+  sc_MPI_Allreduce(res_loc,
+                   res,
+                   nRhs,
+                   sc_MPI_DOUBLE,
+                   sc_MPI_SUM,
+                   sys->simData->mpiParam->mpiComm);
+
+  for (c = 0; c < nRhs; c++)
+    res[c] = n_inv * sqrt(res[c]);
+
+} /* blockResidual() */
+
+/***********************************************************
+* linSolve_bicgstabBlock()
+*-----------------------------------------------------------
+* Iterative solver for the block equation system 
+*
+*   A X = B
+*
+* using a biconjugate gradient stabilized method with 
+* multiple right hand sides.
+* The steps follow linSolve_bicgstab() for every 
+* component.
+***********************************************************/
+void linSolve_bicgstabBlock(BlockSystem_t *sys)
+{
+  SimParam_t *simParam = sys->simData->simParam;
+  const int   nRhs     = sys->nRhs;
+
+  octDouble rho_0[OCT_BLOCK_MAX_RHS];
+  octDouble rho[OCT_BLOCK_MAX_RHS];
+  octDouble alpha[OCT_BLOCK_MAX_RHS];
+  octDouble omega[OCT_BLOCK_MAX_RHS];
+  octDouble w[OCT_BLOCK_MAX_RHS];
+  octDouble one[OCT_BLOCK_MAX_RHS];
+  octDouble res[OCT_BLOCK_MAX_RHS];
+  octDouble gres[OCT_BLOCK_MAX_RHS];
+  octDouble prod[2 * OCT_BLOCK_MAX_RHS];
+  octBool   active[OCT_BLOCK_MAX_RHS];
+  octBool   done[OCT_BLOCK_MAX_RHS];
+  int       kConv[OCT_BLOCK_MAX_RHS];
+
+  int k = 0, c;
+  int nActive = nRhs;
+
+  octDouble wtime = sc_MPI_Wtime();
+
+  /*--------------------------------------------------------
+  | Threshold parameters
+  --------------------------------------------------------*/
+  int kMin = 2;
+  int kMax = 50;
+
+  octDouble eps = 1e-6;
+
+  /*--------------------------------------------------------
+  | Init scalar solver buffers
+  --------------------------------------------------------*/
+  for (c = 0; c < nRhs; c++)
+  {
+    rho_0[c]  = 1.0;
+    alpha[c]  = 1.0;
+    omega[c]  = 1.0;
+    one[c]    = 1.0;
+    res[c]    = 0.0;
+    active[c] = TRUE;
+    kConv[c]  = kMax;
+  }
+
+  /*--------------------------------------------------------
+  | R = B - A*X, R0 = R
+  --------------------------------------------------------*/
+  applyOperator(sys, BX, BAX);
+
+  for (c = 0; c < nRhs; c++)
+    w[c] = -1.0;
+
+  blockSum(sys, BB, BAX, BR, one, w, active);
+
+  for (c = 0; c < nRhs; c++)
+    w[c] = 0.0;
+
+  blockSum(sys, BR, BR, BR0, one, w, active);
+
+  /*--------------------------------------------------------
+  | gres = sqrt( sum( R * R ) ) / N
+  --------------------------------------------------------*/
+  const int prR[1] = { BR };
+
+  blockDot(sys, 1, prR, prR, gres);
+
+  for (c = 0; c < nRhs; c++)
+    gres[c] = sqrt(gres[c]) 
+            / (octDouble) sys->simData->p4est->global_num_quadrants;
+
+  while( k < kMax && nActive > 0 )
+  {
+    k++;
+
+    /*------------------------------------------------------
+    | rho = sum( R0 * R )
+    ------------------------------------------------------*/
+    const int prR0[1] = { BR0 };
+    blockDot(sys, 1, prR0, prR, rho);
+
+    /*------------------------------------------------------
+    | 1) P = (1.0)*P + (-omega)*V
+    | 2) P = (1.0)*R + ( beta )*P
+    ------------------------------------------------------*/
+    for (c = 0; c < nRhs; c++)
+      w[c] = -omega[c];
+
+    blockSum(sys, BP, BV, BP, one, w, active);
+
+    for (c = 0; c < nRhs; c++)
+    {
+      w[c] = (rho[c] / (SMALL+rho_0[c])) 
+           * (alpha[c] / (SMALL+omega[c]));
+      rho_0[c] = rho[c];
+    }
+
+    blockSum(sys, BR, BP, BP, one, w, active);
+
+    /*------------------------------------------------------
+    | V = A*P, alpha = rho / sum( R0 * V )
+    ------------------------------------------------------*/
+    applyOperator(sys, BP, BV);
+
+    const int prV[1] = { BV };
+    blockDot(sys, 1, prR0, prV, prod);
+
+    for (c = 0; c < nRhs; c++)
+      alpha[c] = rho[c] / (SMALL + prod[c]);
+
+    /*------------------------------------------------------
+    | H = (1.0)*X + (alpha)*P
+    ------------------------------------------------------*/
+    blockSum(sys, BX, BP, BH, one, alpha, active);
+
+    /*------------------------------------------------------
+    | Check if H is accurate enough for every component
+    | if yes -> set as new solution and freeze component
+    ------------------------------------------------------*/
+    blockResidual(sys, BH, res);
+
+    for (c = 0; c < nRhs; c++)
+    {
+      done[c] = ( active[c] && res[c] < eps && k > kMin );
+      w[c]    = 0.0;
+    }
+
+    blockSum(sys, BH, BH, BX, one, w, done);
+
+    for (c = 0; c < nRhs; c++)
+    {
+      if (done[c])
+      {
+        active[c] = FALSE;
+        kConv[c]  = k;
+        nActive--;
+      }
+    }
+
+    if (nActive == 0)
+      break;
+
+    /*------------------------------------------------------
+    | S = (1.0)*R + (-alpha)*V
+    ------------------------------------------------------*/
+    for (c = 0; c < nRhs; c++)
+      w[c] = -alpha[c];
+
+    blockSum(sys, BR, BV, BS, one, w, active);
+
+    /*------------------------------------------------------
+    | T = A*S, omega = sum( T * S ) / sum( T * T )
+    | -> both products in a single reduction
+    ------------------------------------------------------*/
+    applyOperator(sys, BS, BT);
+
+    const int prA[2] = { BT, BT };
+    const int prB[2] = { BT, BS };
+    blockDot(sys, 2, prA, prB, prod);
+
+    for (c = 0; c < nRhs; c++)
+      omega[c] = prod[nRhs + c] / (prod[c] + SMALL);
+
+    /*------------------------------------------------------
+    | X = (1.0)*H + (omega)*S
+    ------------------------------------------------------*/
+    blockSum(sys, BH, BS, BX, one, omega, active);
+
+    /*------------------------------------------------------
+    | Check if X is accurate enough for every component
+    ------------------------------------------------------*/
+    blockResidual(sys, BX, res);
+
+    for (c = 0; c < nRhs; c++)
+    {
+      if (active[c] && res[c] < eps && k > kMin)
+      {
+        active[c] = FALSE;
+        kConv[c]  = k;
+        nActive--;
+      }
+    }
+
+    /*------------------------------------------------------
+    | R = (1.0)*S + (-omega)*T
+    ------------------------------------------------------*/
+    for (c = 0; c < nRhs; c++)
+      w[c] = -omega[c];
+
+    blockSum(sys, BS, BT, BR, one, w, active);
+
+  } /* while( k < kMax && nActive > 0 ) */
+
+  /*--------------------------------------------------------
+  | Print out residuals for user
+  --------------------------------------------------------*/
+  for (c = 0; c < nRhs; c++)
+    linSolve_printResidual(sys->xIds[c], MIN(kConv[c], k), 
+                           gres[c], res[c]);
+
+  /*--------------------------------------------------------
+  | Update solver cost statistics 
+  | -> costs per iteration and right hand side
+  --------------------------------------------------------*/
+  UPDATE_RUNNING_AVG(simParam->avgKrylovIter, (octDouble) k);
+  UPDATE_RUNNING_AVG(simParam->timeKrylovIter, 
+                     (sc_MPI_Wtime() - wtime) 
+                     / (octDouble) (MAX(k,1) * nRhs));
+
+} /* linSolve_bicgstabBlock() */
+
+/***********************************************************
+* solveTranEqBlock()
+*-----------------------------------------------------------
+* Function to solve the transport equations for the
+* <nRhs> variables <xIds>, which share the same operator.
+* Implicit schemes use linSolve_bicgstabBlock(), explicit
+* schemes solve every variable with solveTranEq().
+***********************************************************/
+void solveTranEqBlock(SimData_t *simData, 
+                      const int *xIds, 
+                      int        nRhs)
+{
+  SimParam_t *simParam = simData->simParam;
+
+  int c;
+
+  /*--------------------------------------------------------
+  | Explicit schemes do not require a Krylov solver
+  --------------------------------------------------------*/
+  if (  IS_EXPLICIT_SCHEME(simParam->tempScheme) 
+     || nRhs < 2 || nRhs > OCT_BLOCK_MAX_RHS )
+  {
+    for (c = 0; c < nRhs; c++)
+      solveTranEq(simData, xIds[c]);
+    return;
+  }
+
+  BlockSystem_t sys;
+  init_blockSystem(&sys, simData, xIds, nRhs);
+
+  /*--------------------------------------------------------
+  | Compute right hand sides b and initial solutions
+  --------------------------------------------------------*/
+  for (c = 0; c < nRhs; c++)
+  {
+    compute_b_tranEq(simData, xIds[c], sys.dt);
+
+    blockGather(&sys, SB, BB, c);
+    blockGather(&sys, xIds[c], BX, c);
+  }
+
+  /*--------------------------------------------------------
+  | Solve all components together
+  --------------------------------------------------------*/
+  linSolve_bicgstabBlock(&sys);
+
+  for (c = 0; c < nRhs; c++)
+    blockScatter(&sys, BX, c, xIds[c]);
+
+  destroy_blockSystem(&sys);
+
+  /*--------------------------------------------------------
+  | Exchange data
+  --------------------------------------------------------*/
+  p4est_ghost_exchange_data(simData->p4est, 
+                            simData->ghost, 
+                            simData->ghostData);
+
+} /* solveTranEqBlock() */
@@ -0,0 +1,177 @@
+/*
+* This file is part of OctFS. 
+* OctFS is a finite-volume flow solver with adaptive
+* mesh refinement written in C, which is based on 
+* the p4est library.
+*
+* Copyright (C) 2020 Florian Setzwein 
+*
+* OctFS is free software; you can redistribute it and/or 
+* modify it under the terms of the GNU General Public 
+* License as published by the Free Software Foundation; 
+* either version 2 of the License, or (at your option) 
+* any later version.
+*
+* OctFS is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied 
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR 
+* PURPOSE.  See the GNU General Public License for more 
+* details.
+*
+* You should have received a copy of the GNU General 
+* Public License along with OctFS; if not, write to the 
+* Free Software Foundation, Inc., 51 Franklin Street, 
+* Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+#include "solver/checkpoint.h"
+#include "solver/typedefs.h"
+#include "solver/util.h"
+#include "solver/quadData.h"
+#include "solver/simData.h"
+#include "solver/dataIO.h"
+#include "aux/dbg.h"
+
+#ifndef P4_TO_P8
+#include <p4est_bits.h>
+#include <p4est_extended.h>
+#else
+#include <p8est_bits.h>
+#include <p8est_extended.h>
+#endif
+
+/***********************************************************
+* writeCheckpoint()
+*-----------------------------------------------------------
+* Function to write a checkpoint of the simulation after 
+* <step> completed timesteps
+***********************************************************/
+void writeCheckpoint(SimData_t *simData, int step)
+{
+  p4est_t       *p4est       = simData->p4est;
+  SolverParam_t *solverParam = simData->solverParam;
+
+  char filename[BUFSIZ]   = "";
+  char headername[BUFSIZ] = "";
+
+  char *filePrefix = concat_string(solverParam->io_exportDir,
+                                   solverParam->io_exportPrefix);
+  snprintf(filename, BUFSIZ, "%s_%04d.chk", filePrefix, step);
+  snprintf(headername, BUFSIZ, "%s.hdr", filename);
+  free(filePrefix);
+
+  P4EST_GLOBAL_PRODUCTIONF("Writing checkpoint file: %s\n", 
+      filename);
+
+  /*--------------------------------------------------------
+  | Forest, connectivity and quad data are written 
+  | collectively without the partition
+  --------------------------------------------------------*/
+  p4est_save_ext(filename, p4est, TRUE, FALSE);
+
+  /*--------------------------------------------------------
+  | Header is written by the first process
+  --------------------------------------------------------*/
+  if (p4est->mpirank == 0)
+  {
+    ChkHeader_t header;
+    memset(&header, 0, sizeof(ChkHeader_t));
+
+    strncpy(header.magic, OCT_CHK_MAGIC, 8);
+    header.version      = OCT_CHK_VERSION;
+    header.dim          = P4EST_DIM;
+    header.quadDataSize = sizeof(QuadData_t);
+    header.step         = step;
+    header.simTime      = simData->simParam->simTime;
+    header.timestep     = simData->simParam->timestep;
+
+    FILE *fptr = fopen(headername, "wb");
+    check(fptr, "Failed to open %s.", headername);
+
+    fwrite(&header, sizeof(ChkHeader_t), 1, fptr);
+    fclose(fptr);
+  }
+
+  return;
+
+error:
+  SC_ABORT("Failed to write checkpoint header");
+
+} /* writeCheckpoint() */
+
+/***********************************************************
+* loadCheckpoint()
+*-----------------------------------------------------------
+* Function to load the forest, the connectivity and the 
+* quad data of a checkpoint file. 
+* The simulation time and the step counter are restored 
+* from the checkpoint header, all other parameters are 
+* taken from the parameter file.
+* Returns the loaded p4est structure and its connectivity
+* in <conn>.
+***********************************************************/
+p4est_t *loadCheckpoint(SimData_t            *simData,
+                        const char           *filename,
+                        p4est_connectivity_t **conn)
+{
+  SimParam_t *simParam = simData->simParam;
+  FILE       *fptr     = NULL;
+
+  char headername[BUFSIZ] = "";
+  snprintf(headername, BUFSIZ, "%s.hdr", filename);
+
+  /*--------------------------------------------------------
+  | Read and verify checkpoint header
+  --------------------------------------------------------*/
+  ChkHeader_t header;
+
+  fptr = fopen(headername, "rb");
+  check(fptr, "Failed to open %s.", headername);
+  size_t nRead = fread(&header, sizeof(ChkHeader_t), 1, fptr);
+  fclose(fptr);
+
+  check(nRead == 1,
+      "Failed to read checkpoint header %s.", headername);
+
+  check(strncmp(header.magic, OCT_CHK_MAGIC, 8) == 0,
+      "%s is not a checkpoint header.", headername);
+  check(header.version == OCT_CHK_VERSION,
+      "Checkpoint version %d is not supported.", header.version);
+  check(header.dim == P4EST_DIM,
+      "Checkpoint has been written for %dD.", header.dim);
+  check(header.quadDataSize == (int32_t) sizeof(QuadData_t),
+      "Checkpoint quad data size does not match.");
+
+  /*--------------------------------------------------------
+  | Load forest and distribute it among all processes
+  --------------------------------------------------------*/
+  P4EST_GLOBAL_PRODUCTIONF("Loading checkpoint file: %s\n", 
+      filename);
+
+  p4est_t *p4est = p4est_load_ext(filename,
+                                  simData->mpiParam->mpiComm,
+                                  sizeof(QuadData_t),
+                                  TRUE,
+                                  TRUE,
+                                  FALSE,
+                                  (void *) simData,
+                                  conn);
+
+  /*--------------------------------------------------------
+  | Resume simulation time and step counter
+  --------------------------------------------------------*/
+  simParam->simTime = header.simTime;
+  simParam->step    = header.step;
+
+  if (header.timestep != simParam->timestep)
+    octPrint("[WARNING]: Timestep changed from %e to %e on restart",
+        header.timestep, simParam->timestep);
+
+  octPrint("Restart at step %d, t=%e", 
+      simParam->step, simParam->simTime);
+
+  return p4est;
+
+error:
+  return NULL;
+
+} /* loadCheckpoint() */
@@ -29,6 +29,7 @@
 #include "solver/refine.h"
 #include "solver/quadData.h"
 #include "solver/simData.h"
+#include "solver/zones.h"
 
 /***********************************************************
 * coarsening_scalarError()
@@ -102,6 +103,11 @@ int coarsening_scalarError(p4est_t *p4est,
 *-----------------------------------------------------------
 * This is the general function to control the coarsening
 * of trees.
+* The flags of the indicator pass computeAdaptFlags() are
+* used if available for all children. Otherwise, the 
+* coarsening criteria are evaluated directly.
+* Families with a recently refined child or with a child
+* inside of a refinement zone are never coarsened.
 ***********************************************************/
 int globalCoarsening(p4est_t          *p4est,
                      p4est_topidx_t    which_tree,
@@ -110,7 +116,31 @@ int globalCoarsening(p4est_t          *p4est,
   SimData_t  *simData  = (SimData_t*) p4est->user_pointer;
   SimParam_t *simParam = simData->simParam;
 
-  int coarsen = 0;
+  int i;
+  int coarsen = 1;
+  int flagged = 1;
+
+  for (i = 0; i < P4EST_CHILDREN; i++)
+  {
+    QuadData_t *quadData = (QuadData_t *) children[i]->p.user_data;
+
+    flagged &= (quadData->adaptFlag != ADAPT_UNSET);
+    coarsen &= (quadData->adaptFlag == ADAPT_COARSEN);
+
+    if (quadData->adaptAge < simData->solverParam->minRefineAge)
+      return 0;
+  }
+
+  if (flagged)
+    return coarsen;
+
+  for (i = 0; i < P4EST_CHILDREN; i++)
+  {
+    if (zoneRefineLevel(p4est, which_tree, children[i]) >= 0)
+      return 0;
+  }
+
+  coarsen = 0;
 
   coarsen |= coarsening_scalarError(p4est, 
                                     which_tree, 
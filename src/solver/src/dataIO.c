@@ -55,9 +55,22 @@ static char varNames[OCT_MAX_VARS][OCT_VARNAME_LENGTH] =
 }; 
 
 /***********************************************************
-* Variable index
+* Indices of the variables that are written to the 
+* solution files
 ***********************************************************/
-static int io_idx = -1;
+static const int ioVars[] = 
+{
+  IRHO,
+  IVX,
+  IVY,
+#ifdef P4_TO_P8
+  IVZ,
+#endif
+  IP,
+  IS
+};
+
+#define OCT_IO_VARS ( (int) (sizeof(ioVars) / sizeof(ioVars[0])) )
 
 /***********************************************************
 * Function to concatenate two strings.
@@ -87,40 +100,35 @@ error:
 }
 
 /***********************************************************
-* Callback function for interpolating the solution from 
-* quadrant midpoints to corners.
+* gatherSolution()
+*-----------------------------------------------------------
+* Callback function for gathering the output variables 
+* of a quadrant into the cell data arrays.
 *
 * The function p4est_iterate() takes as an argument a 
 * p4est_iter_volume_t callback function, which it executes at 
 * every local quadrant (see p4est_iterate.h).  
 * This function matches the p4est_iter_volume_t prototype.
 *
-* Use the callback function to interpolate the state
-* variable to the corners, and write those corners into an 
-* array so that they can be written out.
+* All output variables are gathered in a single traversal
+* of the mesh.
 *-----------------------------------------------------------
 * Arguments:
 * *info       : the information about this quadrant that 
 *               has been  populated by p4est_iterate()
 * user_data   : the user_data that was given as an argument to
 *               p4est_iterate: in this case, it points to the
-*               array of corner values that we want to write.
-*               The values for the corner of the quadrant
-*               described by a info are written during the
-*               execution of the callback.
+*               array of cell data arrays (one for every 
+*               entry in ioVars) that we want to write.
 *
 ***********************************************************/
-static void interpSolution(p4est_iter_volume_info_t *info, 
-                           void *user_data)
+void gatherSolution(p4est_iter_volume_info_t *info, 
+                    void *user_data)
 {
-  /*--------------------------------------------------------
-  | we passed the array of values to fill as the user_data 
-  | in the call to p4est_iterate 
-  |-------------------------------------------------------*/
-  sc_array_t         *var_interp = (sc_array_t *) user_data;      
-  p4est_t            *p4est      = info->p4est;
-  p4est_quadrant_t   *q          = info->quad;
-  p4est_topidx_t      which_tree = info->treeid;
+  sc_array_t      **cellData   = (sc_array_t **) user_data;      
+  p4est_t          *p4est      = info->p4est;
+  p4est_quadrant_t *q          = info->quad;
+  p4est_topidx_t    which_tree = info->treeid;
 
   /*--------------------------------------------------------
   | local_id is the index of q *within its tree's numbering.  
@@ -134,46 +142,412 @@ static void interpSolution(p4est_iter_volume_info_t *info,
 
   // now the id is relative to the MPI process 
   local_id += tree->quadrants_offset;   
-  
-  // each local quadrant has 2^d (P4EST_CHILDREN) 
-  // values in var_interp 
-  p4est_locidx_t arrayoffset = P4EST_CHILDREN * local_id;      
-  //double h = (double) P4EST_QUADRANT_LEN (q->level) / (double) P4EST_ROOT_LEN;
 
-  double  this_u;
-  double *this_u_ptr;
-  int     i, j;
+  int i;
 
-  for (i = 0; i < P4EST_CHILDREN; i++) 
+  for (i = 0; i < OCT_IO_VARS; i++) 
   {
-    this_u = quadData->vars[io_idx];
-    //this_u = quadData->b[io_idx] / quadData->volume;
-    //this_u = quadData->grad_vars[io_idx][1];
-
-    /*------------------------------------------------------
-    | loop over the derivative components and 
-    | linearly interpolate from the midpoint to the corners 
-    |-----------------------------------------------------*/
-    for (j = 0; j < P4EST_DIM; j++) 
-    {
-      /*----------------------------------------------------
-      | In order to know whether the direction from the 
-      | midpoint to the corner is negative or positive, we 
-      | take advantage of the fact that the corners are 
-      | in z-order.  
-      | If i is an odd number, it is 
-      | on the +x side; if it is even, it is on the -x side.  
-      | If (i / 2) is an odd number, it is on the +y sidea.. 
-      |---------------------------------------------------*/
-      // this_u += (h / 2) * data->grad_u[j] * ((i & (1 << j)) ? 1. : -1.);
-    }
-
-    this_u_ptr = (double *) sc_array_index(var_interp, 
-                                           arrayoffset + i);
-    this_u_ptr[0] = this_u;
+    double *val = (double *) sc_array_index(cellData[i], local_id);
+    *val = quadData->vars[ioVars[i]];
   }
 
-} /* interpSolution(...) */
+} /* gatherSolution() */
+
+/***********************************************************
+* gatherLayout()
+*-----------------------------------------------------------
+* Callback function for gathering the tree, level and 
+* coordinates of a quadrant into the snapshot layout array.
+*   -> p4est_iter_volume_t callback function
+***********************************************************/
+void gatherLayout(p4est_iter_volume_info_t *info, 
+                  void *user_data)
+{
+  SnapQuad_t       *layout     = (SnapQuad_t *) user_data;
+  p4est_t          *p4est      = info->p4est;
+  p4est_quadrant_t *q          = info->quad;
+  p4est_topidx_t    which_tree = info->treeid;
+
+  p4est_tree_t   *tree     = p4est_tree_array_index(p4est->trees, 
+                                                    which_tree);
+  p4est_locidx_t  local_id = info->quadid + tree->quadrants_offset;
+
+  SnapQuad_t *sq = &layout[local_id];
+
+  sq->tree   = which_tree;
+  sq->level  = q->level;
+  sq->xyz[0] = q->x;
+  sq->xyz[1] = q->y;
+#ifdef P4_TO_P8
+  sq->xyz[2] = q->z;
+#else
+  sq->xyz[2] = 0;
+#endif
+
+} /* gatherLayout() */
+
+/***********************************************************
+* writeSolution()
+*-----------------------------------------------------------
+* Function to write the solution of a single timestep 
+* in the output format chosen in the parameter file
+***********************************************************/
+void writeSolution(SimData_t *simData, int step)
+{
+  if (simData->solverParam->io_format == OUTPUT_SNAPSHOT)
+  {
+    if (simData->writer != NULL)
+      writeSolutionAsync(simData, step);
+    else
+      writeSolutionSnapshot(simData, step);
+  }
+  else
+    writeSolutionVtk(simData, step);
+
+} /* writeSolution() */
+
+/***********************************************************
+* stagingSize()
+*-----------------------------------------------------------
+* Returns the maximum number of bytes over all processes,
+* that are required to stage a snapshot of the solution
+***********************************************************/
+static long stagingSize(SimData_t *simData)
+{
+  long bytes_loc  = (long) simData->p4est->local_num_quadrants 
+                  * (sizeof(SnapQuad_t) + OCT_IO_VARS * sizeof(double));
+  long bytes_glob = 0;
+
+  sc_MPI_Allreduce(&bytes_loc,
+                   &bytes_glob,
+                   1,
+                   sc_MPI_LONG,
+                   sc_MPI_MAX,
+                   simData->mpiParam->mpiComm);
+
+  return bytes_glob;
+
+} /* stagingSize() */
+
+/***********************************************************
+* stageSnapshot()
+*-----------------------------------------------------------
+* Copies the quadrant layout and the output variables of 
+* the local quadrants into the staging buffers of a 
+* snapshot slot and opens the snapshot file.
+* After this call, the solver may modify the quad data.
+***********************************************************/
+static void stageSnapshot(SimData_t  *simData, 
+                          int         step,
+                          SnapSlot_t *slot)
+{
+  p4est_t       *p4est       = simData->p4est;
+  SolverParam_t *solverParam = simData->solverParam;
+
+  char filename[BUFSIZ] = "";
+  int  mpiret, i;
+
+  char *filePrefix = concat_string(solverParam->io_exportDir,
+                                   solverParam->io_exportPrefix);
+  snprintf(filename, BUFSIZ, "%s_%04d.octsnap", filePrefix, step);
+  free(filePrefix);
+
+  P4EST_GLOBAL_PRODUCTIONF("Writing snapshot file: %s\n", 
+      filename);
+
+  /*--------------------------------------------------------
+  | Gather quadrant layout and output variables 
+  |-------------------------------------------------------*/
+  p4est_locidx_t numquads = p4est->local_num_quadrants;
+
+  slot->numquads = numquads;
+  slot->nGlob    = p4est->global_num_quadrants;
+  slot->offset   = p4est->global_first_quadrant[p4est->mpirank];
+  slot->layout   = P4EST_ALLOC(SnapQuad_t, numquads);
+  slot->data     = P4EST_ALLOC(double, OCT_IO_VARS * numquads);
+
+  sc_array_t *cellData[OCT_IO_VARS];
+
+  for (i = 0; i < OCT_IO_VARS; i++)
+    cellData[i] = sc_array_new_data(&slot->data[i * numquads], 
+                                    sizeof (double), numquads);
+
+  p4est_iterate(p4est, NULL, (void *) slot->layout,
+                gatherLayout,   // cell callback
+                NULL,           // face callback
+#ifdef P4_TO_P8
+                NULL,           // edge callback
+#endif
+                NULL);          // corner callback
+
+  p4est_iterate(p4est, NULL, (void *) cellData,
+                gatherSolution, // cell callback
+                NULL,           // face callback
+#ifdef P4_TO_P8
+                NULL,           // edge callback
+#endif
+                NULL);          // corner callback
+
+  for (i = 0; i < OCT_IO_VARS; i++)
+    sc_array_destroy(cellData[i]);
+
+  /*--------------------------------------------------------
+  | Prepare header 
+  |-------------------------------------------------------*/
+  SnapHeader_t *header = &slot->header;
+  memset(header, 0, sizeof(SnapHeader_t));
+
+  strncpy(header->magic, OCT_SNAP_MAGIC, 8);
+  header->version = OCT_SNAP_VERSION;
+  header->dim     = P4EST_DIM;
+  header->nVars   = OCT_IO_VARS;
+  header->step    = step;
+  header->nQuads  = slot->nGlob;
+  header->simTime = simData->simParam->simTime;
+
+  for (i = 0; i < OCT_IO_VARS; i++)
+    strncpy(header->varNames[i], varNames[ioVars[i]], 
+            OCT_VARNAME_LENGTH-1);
+
+  /*--------------------------------------------------------
+  | Open file collectively
+  |-------------------------------------------------------*/
+  mpiret = MPI_File_open(p4est->mpicomm, filename,
+                         MPI_MODE_CREATE | MPI_MODE_WRONLY,
+                         MPI_INFO_NULL, &slot->fh);
+  SC_CHECK_ABORT(mpiret == MPI_SUCCESS, 
+                 "Error opening snapshot file");
+
+  mpiret = MPI_File_set_size(slot->fh, 0);
+  SC_CHECK_MPI(mpiret);
+
+  slot->nReq   = 0;
+  slot->active = TRUE;
+
+} /* stageSnapshot() */
+
+/***********************************************************
+* postSnapshot()
+*-----------------------------------------------------------
+* Starts the non-blocking collective writes of a staged 
+* snapshot slot
+***********************************************************/
+static void postSnapshot(SimData_t *simData, SnapSlot_t *slot)
+{
+  int mpiret, i;
+
+  /*--------------------------------------------------------
+  | Header is written by the first process
+  |-------------------------------------------------------*/
+  if (simData->p4est->mpirank == 0)
+  {
+    mpiret = MPI_File_iwrite_at(slot->fh, 0, &slot->header, 
+                                sizeof(SnapHeader_t), MPI_BYTE,
+                                &slot->req[slot->nReq++]);
+    SC_CHECK_MPI(mpiret);
+  }
+
+  /*--------------------------------------------------------
+  | Quadrant layout and variables are written collectively
+  |-------------------------------------------------------*/
+  MPI_Offset off = (MPI_Offset) sizeof(SnapHeader_t) 
+                 + (MPI_Offset) slot->offset * sizeof(SnapQuad_t);
+
+  mpiret = MPI_File_iwrite_at_all(slot->fh, off, slot->layout, 
+                                  slot->numquads * sizeof(SnapQuad_t), 
+                                  MPI_BYTE, &slot->req[slot->nReq++]);
+  SC_CHECK_MPI(mpiret);
+
+  for (i = 0; i < OCT_IO_VARS; i++)
+  {
+    off = (MPI_Offset) sizeof(SnapHeader_t) 
+        + (MPI_Offset) slot->nGlob * sizeof(SnapQuad_t)
+        + ((MPI_Offset) i * slot->nGlob + slot->offset) 
+          * sizeof(double);
+
+    mpiret = MPI_File_iwrite_at_all(slot->fh, off, 
+                                    &slot->data[i * slot->numquads], 
+                                    slot->numquads, MPI_DOUBLE, 
+                                    &slot->req[slot->nReq++]);
+    SC_CHECK_MPI(mpiret);
+  }
+
+} /* postSnapshot() */
+
+/***********************************************************
+* finishSnapshot()
+*-----------------------------------------------------------
+* Waits for all writes of a snapshot slot, closes the 
+* snapshot file and releases the staging buffers
+***********************************************************/
+static void finishSnapshot(SnapSlot_t *slot)
+{
+  int mpiret;
+
+  if (slot->active == FALSE)
+    return;
+
+  mpiret = MPI_Waitall(slot->nReq, slot->req, MPI_STATUSES_IGNORE);
+  SC_CHECK_MPI(mpiret);
+
+  mpiret = MPI_File_close(&slot->fh);
+  SC_CHECK_MPI(mpiret);
+
+  P4EST_FREE(slot->layout);
+  P4EST_FREE(slot->data);
+
+  slot->layout = NULL;
+  slot->data   = NULL;
+  slot->bytes  = 0;
+  slot->nReq   = 0;
+  slot->active = FALSE;
+
+} /* finishSnapshot() */
+
+/***********************************************************
+* writeSolutionSnapshot()
+*-----------------------------------------------------------
+* Function to write the solution of a single timestep 
+* to a single snapshot file using MPI-IO
+***********************************************************/
+void writeSolutionSnapshot(SimData_t *simData, int step)
+{
+  SnapSlot_t slot;
+  slot.active = FALSE;
+
+  stageSnapshot(simData, step, &slot);
+  postSnapshot(simData, &slot);
+  finishSnapshot(&slot);
+
+} /* writeSolutionSnapshot() */
+
+/***********************************************************
+* init_asyncWriter()
+*-----------------------------------------------------------
+* Creates an asynchronous snapshot writer with 
+* OCT_IO_BUFFERS staging slots. At most <budget> bytes
+* per process are used for staging.
+***********************************************************/
+AsyncWriter_t *init_asyncWriter(long budget)
+{
+  AsyncWriter_t *writer = malloc(sizeof(AsyncWriter_t));
+
+  int i;
+
+  for (i = 0; i < OCT_IO_BUFFERS; i++)
+  {
+    writer->slot[i].active = FALSE;
+    writer->slot[i].layout = NULL;
+    writer->slot[i].data   = NULL;
+    writer->slot[i].bytes  = 0;
+    writer->slot[i].nReq   = 0;
+  }
+
+  writer->next   = 0;
+  writer->budget = budget;
+
+  return writer;
+
+} /* init_asyncWriter() */
+
+/***********************************************************
+* destroy_asyncWriter()
+*-----------------------------------------------------------
+* Completes all pending snapshots and frees the writer
+***********************************************************/
+void destroy_asyncWriter(AsyncWriter_t *writer)
+{
+  flushAsyncWriter(writer);
+  free(writer);
+
+} /* destroy_asyncWriter() */
+
+/***********************************************************
+* flushAsyncWriter()
+*-----------------------------------------------------------
+* Completes all pending snapshots of the writer, 
+* starting with the oldest one
+***********************************************************/
+void flushAsyncWriter(AsyncWriter_t *writer)
+{
+  int i;
+
+  for (i = 0; i < OCT_IO_BUFFERS; i++)
+    finishSnapshot(&writer->slot[(writer->next + i) % OCT_IO_BUFFERS]);
+
+} /* flushAsyncWriter() */
+
+/***********************************************************
+* writeSolutionAsync()
+*-----------------------------------------------------------
+* Function to write the solution of a single timestep 
+* to a single snapshot file in the background.
+* The solution is copied to a staging slot and the file 
+* is written with non-blocking collective MPI-IO, while
+* the solver continues with the next timesteps. 
+* The writes are completed, when the slot is reused, when 
+* the staging memory budget is exceeded or when the writer 
+* is flushed.
+***********************************************************/
+void writeSolutionAsync(SimData_t *simData, int step)
+{
+  AsyncWriter_t *writer = simData->writer;
+  SnapSlot_t    *slot   = &writer->slot[writer->next];
+
+  int i;
+
+  /*--------------------------------------------------------
+  | Staging size is reduced over all processes, so that 
+  | every process takes the same (collective) decisions
+  |-------------------------------------------------------*/
+  long bytes = stagingSize(simData);
+
+  /*--------------------------------------------------------
+  | Slot is reused -> complete its previous snapshot
+  |-------------------------------------------------------*/
+  finishSnapshot(slot);
+
+  /*--------------------------------------------------------
+  | Snapshot does not fit into the budget at all
+  | -> write synchronously
+  |-------------------------------------------------------*/
+  if (bytes > writer->budget)
+  {
+    flushAsyncWriter(writer);
+    writeSolutionSnapshot(simData, step);
+    return;
+  }
+
+  /*--------------------------------------------------------
+  | Complete older snapshots until the new one fits into 
+  | the budget
+  |-------------------------------------------------------*/
+  long staged = bytes;
+
+  for (i = 1; i < OCT_IO_BUFFERS; i++)
+  {
+    SnapSlot_t *other = 
+      &writer->slot[(writer->next + i) % OCT_IO_BUFFERS];
+
+    if (other->active == FALSE)
+      continue;
+
+    if (staged + other->bytes > writer->budget)
+      finishSnapshot(other);
+    else
+      staged += other->bytes;
+  }
+
+  /*--------------------------------------------------------
+  | Stage solution and start writing
+  |-------------------------------------------------------*/
+  stageSnapshot(simData, step, slot);
+  slot->bytes = bytes;
+  postSnapshot(simData, slot);
+
+  writer->next = (writer->next + 1) % OCT_IO_BUFFERS;
+
+} /* writeSolutionAsync() */
 
 
 /***********************************************************
@@ -191,25 +565,42 @@ void writeSolutionVtk(SimData_t *simData, int step)
   int                  retval;
   p4est_vtk_context_t *context;
 
-  snprintf(filename, BUFSIZ, "%s_%04d", 
-      concat_string(solverParam->io_exportDir,
-                    solverParam->io_exportPrefix), step);
+  char *filePrefix = concat_string(solverParam->io_exportDir,
+                                   solverParam->io_exportPrefix);
+  snprintf(filename, BUFSIZ, "%s_%04d", filePrefix, step);
+  free(filePrefix);
+
   P4EST_GLOBAL_PRODUCTIONF("Writing results file: %s\n", 
       filename);
 
   /*--------------------------------------------------------
-  | create a vector with one value for the corner of 
-  | every local quadrant (the number of children is always 
-  | the same as the number of corners)
+  | create a vector with one value for every local 
+  | quadrant and output variable
   |-------------------------------------------------------*/
   p4est_locidx_t numquads = p4est->local_num_quadrants;
-  int nEntries            = numquads * P4EST_CHILDREN;
-  sc_array_t *var_interp[OCT_MAX_VARS];
+  sc_array_t    *cellData[OCT_IO_VARS];
+  const char    *cellNames[OCT_IO_VARS];
+
+  int i;
   
-  for (io_idx = 0; io_idx < OCT_MAX_VARS; io_idx++)
-    var_interp[io_idx] = sc_array_new_size(sizeof (double), 
-                                           nEntries);
+  for (i = 0; i < OCT_IO_VARS; i++)
+  {
+    cellData[i]  = sc_array_new_size(sizeof (double), numquads);
+    cellNames[i] = varNames[ioVars[i]];
+  }
 
+  /*--------------------------------------------------------
+  | Gather all output variables in a single traversal
+  |-------------------------------------------------------*/
+  p4est_iterate(p4est, 
+                NULL,   
+                (void *) cellData,     
+                gatherSolution,
+                NULL,          
+#ifdef P4_TO_P8
+                NULL,         
+#endif
+                NULL);         
 
   /*--------------------------------------------------------
   | create VTK output context and set its parameters
@@ -225,55 +616,20 @@ void writeSolutionVtk(SimData_t *simData, int step)
   SC_CHECK_ABORT(context != NULL,
                  P4EST_STRING "_vtk: Error writing vtk header");
 
-  /* do not write the tree id's of each quadrant */
-  context = p4est_vtk_write_cell_dataf(context, 0, 
-                                       1, // write refinelevel 
-                                       1, // write mpi id      
-                                       0, // wrap mpi rank     
-                                       0, // custom scalar data
-                                       0, // custom vector data
-                                       context);      
-
-  SC_CHECK_ABORT(context != NULL,
-                 P4EST_STRING "_vtk: Error writing cell data");
-
-  /*--------------------------------------------------------
-  | Interpolate field data to points
-  |-------------------------------------------------------*/
-  for (io_idx = 0; io_idx < OCT_MAX_VARS; io_idx++)
-  {
-    p4est_iterate(p4est, 
-                  NULL,   
-                  (void *) var_interp[io_idx],     
-                  interpSolution,
-                  NULL,          
-#ifdef P4_TO_P8
-                  NULL,         
-#endif
-                  NULL);         
-  }
-
   /*--------------------------------------------------------
-  | Set field data for output file
+  | Write field data as cell data
   |-------------------------------------------------------*/
-  context = p4est_vtk_write_point_dataf(context, 
-#ifdef P4_TO_P8
-                              OCT_MAX_VARS - OCT_SOLVER_VARS,
-#else
-                              OCT_MAX_VARS - OCT_SOLVER_VARS - 1,
-#endif
-                              0, 
-                              varNames[16], var_interp[16], 
-                              varNames[0], var_interp[0], 
-#ifdef P4_TO_P8
-                              varNames[3], var_interp[3], 
-#endif
-                              varNames[1], var_interp[1], 
-                              varNames[3], var_interp[3], 
-                              varNames[7], var_interp[7], 
-                              context);    
+  context = p4est_vtk_write_cell_data(context, 
+                                      0,           // tree id   
+                                      1,           // refinelevel
+                                      1,           // mpi id  
+                                      0,           // wrap rank
+                                      OCT_IO_VARS, // scalar data
+                                      0,           // vector data
+                                      cellNames,
+                                      cellData);
   SC_CHECK_ABORT(context != NULL,
-                 P4EST_STRING "_vtk: Error writing field data");
+                 P4EST_STRING "_vtk: Error writing cell data");
 
   /*--------------------------------------------------------
   | Finalize vtk file
@@ -282,8 +638,8 @@ void writeSolutionVtk(SimData_t *simData, int step)
 
   SC_CHECK_ABORT(!retval, P4EST_STRING "_vtk: Error writing footer");
 
-  for (io_idx = 0; io_idx < OCT_MAX_VARS; io_idx++)
-    sc_array_destroy(var_interp[io_idx]);
+  for (i = 0; i < OCT_IO_VARS; i++)
+    sc_array_destroy(cellData[i]);
 
 
 } /* writeSolutionVtk() */
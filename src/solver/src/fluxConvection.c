@@ -41,16 +41,6 @@
 #include <p8est_iterate.h>
 #endif
 
-/***********************************************************
-* Funtion to determine the upwind element. 
-* var_out is the element with the outward facing normal
-* var_in is the element with the inward facing normal.
-***********************************************************/
-#define UPWIND_DIR(mflux, var_out, var_in) \
-  ( (mflux) > 0.0 ? (var_out) : (var_in) )
-
-
-
 /***********************************************************
 * addFlux_conv_imp()
 *-----------------------------------------------------------
@@ -63,28 +53,32 @@
 * *info      : Information about this quadrant that has 
 *              been populated by the p4est_iterate()
 * *user_data : user_data that is given to p4est_iterate,
-*              in this case, it points to the ghost_data
-*              array, which contains the SimVars_t data
-*              for all of the ghost cells, that has been 
-*              populated by p4est_ghost_exchange_data
+*              in this case, it points to the kernel 
+*              context (KernelCtx_t) with the variable and
+*              buffer indices, the flux factor and the 
+*              ghost data, that has been populated by 
+*              p4est_ghost_exchange_data
 *
 ***********************************************************/
 void addFlux_conv_imp(p4est_iter_face_info_t *info,
                       void *user_data)
 {
-  p4est_t    *p4est    = info->p4est;
-  SimData_t  *simData  = (SimData_t *) p4est->user_pointer;
-  SimParam_t *simParam = simData->simParam;
+  KernelCtx_t *ctx      = (KernelCtx_t *) user_data;
 
-  octDouble fluxFac = simParam->tmp_fluxFac;
-  int       xId     = simParam->tmp_xId;
-  int       AxId    = simParam->tmp_AxId;
+  octDouble fluxFac = ctx->fluxFac;
+  int       xId     = ctx->xId;
+  int       AxId    = ctx->AxId;
 
   QuadData_t      *qDat0, *qDat1;
-  QuadData_t      *ghostData = (QuadData_t *) user_data;
+  QuadData_t      *ghostData = ctx->ghostData;
 
   sc_array_t *sides = &(info->sides);
-  P4EST_ASSERT(sides->elem_count == 2);
+
+  /*-------------------------------------------------------
+  | No convective flux across the domain boundary
+  |------------------------------------------------------*/
+  if (sides->elem_count < 2)
+    return;
 
   int i;
 
@@ -0,0 +1,188 @@
+/*
+* This file is part of OctFS. 
+* OctFS is a finite-volume flow solver with adaptive
+* mesh refinement written in C, which is based on 
+* the p4est library.
+*
+* Copyright (C) 2020 Florian Setzwein 
+*
+* OctFS is free software; you can redistribute it and/or 
+* modify it under the terms of the GNU General Public 
+* License as published by the Free Software Foundation; 
+* either version 2 of the License, or (at your option) 
+* any later version.
+*
+* OctFS is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied 
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR 
+* PURPOSE.  See the GNU General Public License for more 
+* details.
+*
+* You should have received a copy of the GNU General 
+* Public License along with OctFS; if not, write to the 
+* Free Software Foundation, Inc., 51 Franklin Street, 
+* Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+#include "solver/geometry.h"
+#include "solver/typedefs.h"
+#include "solver/util.h"
+#include "solver/quadData.h"
+#include "solver/simData.h"
+#include "aux/dbg.h"
+
+#ifndef P4_TO_P8
+#include <p4est_bits.h>
+#include <p4est_extended.h>
+#include <p4est_iterate.h>
+#else
+#include <p8est_bits.h>
+#include <p8est_extended.h>
+#include <p8est_iterate.h>
+#endif
+
+/***********************************************************
+* init_geomTable()
+*-----------------------------------------------------------
+* Initializes the per-level geometry table from the 
+* extents of the first tree in the connectivity
+***********************************************************/
+GeomTable_t *init_geomTable(p4est_connectivity_t *conn)
+{
+  GeomTable_t *geomTable = malloc(sizeof(GeomTable_t));
+  check_mem(geomTable);
+
+  /*--------------------------------------------------------
+  | Get tree origin and tree corners along every axis
+  --------------------------------------------------------*/
+  const p4est_qcoord_t l = P4EST_ROOT_LEN;
+
+  double x0[3], xi[3];
+  octDouble hRoot[P4EST_DIM];
+
+  int i, j, lvl;
+
+#ifdef P4_TO_P8
+  p4est_qcoord_to_vertex(conn, 0, 0, 0, 0, x0);
+#else
+  p4est_qcoord_to_vertex(conn, 0, 0, 0, x0);
+#endif
+
+  for (i = 0; i < P4EST_DIM; i++)
+  {
+#ifdef P4_TO_P8
+    p4est_qcoord_to_vertex(conn, 0, 
+                           (i == 0) * l, (i == 1) * l, (i == 2) * l, 
+                           xi);
+#else
+    p4est_qcoord_to_vertex(conn, 0, 
+                           (i == 0) * l, (i == 1) * l, 
+                           xi);
+#endif
+    hRoot[i] = 0.0;
+    for (j = 0; j < P4EST_DIM; j++)
+      hRoot[i] += (xi[j] - x0[j]) * (xi[j] - x0[j]);
+    hRoot[i] = sqrt(hRoot[i]);
+  }
+
+  /*--------------------------------------------------------
+  | Fill table for all levels
+  --------------------------------------------------------*/
+  for (lvl = 0; lvl <= P4EST_MAXLEVEL; lvl++)
+  {
+    const octDouble fac = 1.0 / (octDouble) ((int64_t) 1 << lvl);
+
+    geomTable->volume[lvl] = 1.0;
+
+    for (i = 0; i < P4EST_DIM; i++)
+    {
+      geomTable->h[lvl][i]    = hRoot[i] * fac;
+      geomTable->volume[lvl] *= geomTable->h[lvl][i];
+    }
+
+    for (i = 0; i < P4EST_DIM; i++)
+      geomTable->area[lvl][i] = geomTable->volume[lvl] 
+                              / geomTable->h[lvl][i];
+  }
+
+  return geomTable;
+
+error:
+  return NULL;
+
+} /* init_geomTable() */
+
+/***********************************************************
+* destroy_geomTable()
+*-----------------------------------------------------------
+* Frees all memory of a GeomTable structure
+***********************************************************/
+void destroy_geomTable(GeomTable_t *geomTable)
+{
+  free(geomTable);
+
+} /* destroy_geomTable() */
+
+/***********************************************************
+* geom_centroid()
+*-----------------------------------------------------------
+* Computes the centroid of a quad from its coordinates
+***********************************************************/
+void geom_centroid(p4est_t          *p4est,
+                   p4est_topidx_t    which_tree,
+                   p4est_quadrant_t *q,
+                   octDouble         xc[P4EST_DIM])
+{
+  const p4est_qcoord_t half = P4EST_QUADRANT_LEN(q->level) / 2;
+
+  double xyz[3];
+
+  p4est_qcoord_to_vertex(p4est->connectivity,
+                         which_tree,
+                         q->x + half,
+                         q->y + half,
+#ifdef P4_TO_P8
+                         q->z + half,
+#endif
+                         xyz);
+
+  int i;
+  for (i = 0; i < P4EST_DIM; i++)
+    xc[i] = xyz[i];
+
+} /* geom_centroid() */
+
+/***********************************************************
+* geom_faceNormal()
+*-----------------------------------------------------------
+* Returns the outward facing normal of face <face> of 
+* quad <q>, scaled by the face area.
+* The normal is computed from the refinement level of the
+* quad, unless OCT_MAPPED_GEOMETRY is defined. In this case
+* the normals stored in <quadData> are used.
+*
+* Faces are ordered as in p4est: 
+*   face / 2 -> normal direction
+*   face % 2 -> 0: negative side, 1: positive side
+***********************************************************/
+void geom_faceNormal(SimData_t        *simData,
+                     p4est_quadrant_t *q,
+                     QuadData_t       *quadData,
+                     int               face,
+                     octDouble         normal[P4EST_DIM])
+{
+  int i;
+
+#ifdef OCT_MAPPED_GEOMETRY
+  for (i = 0; i < P4EST_DIM; i++)
+    normal[i] = quadData->normals[face][i];
+#else
+  const int       dir = face / 2;
+  const octDouble sgn = (face % 2) ? 1.0 : -1.0;
+
+  for (i = 0; i < P4EST_DIM; i++)
+    normal[i] = 0.0;
+
+  normal[dir] = sgn * simData->geomTable->area[q->level][dir];
+#endif
+
+} /* geom_faceNormal() */
@@ -27,6 +27,7 @@
 #include "solver/util.h"
 #include "solver/quadData.h"
 #include "solver/simData.h"
+#include "solver/geometry.h"
 #include "solver/util.h"
 #include "aux/dbg.h"
 
@@ -41,23 +42,6 @@
 #endif
 
 
-/***********************************************************
-* Constants  
-***********************************************************/
-static int gradVarIdx = -1;
-
-
-/***********************************************************
-* setGradVarIdx()
-*-----------------------------------------------------------
-* Function to set the index of the gradient variable to
-* compute.
-***********************************************************/
-static void setGradVarIdx(int varIdx)
-{
-  gradVarIdx = varIdx;
-}
-
 /***********************************************************
 * resetDerivatives()
 *-----------------------------------------------------------
@@ -70,6 +54,9 @@ void resetDerivatives(p4est_iter_volume_info_t *info,
   p4est_quadrant_t   *q = info->quad;
 
   QuadData_t     *quadData = (QuadData_t *) q->p.user_data;
+  KernelCtx_t    *ctx      = (KernelCtx_t *) user_data;
+
+  const int gradVarIdx = ctx->xId;
 
   int i;
 
@@ -92,6 +79,9 @@ void divideByVolume(p4est_iter_volume_info_t *info,
   p4est_quadrant_t   *q = info->quad;
 
   QuadData_t     *quadData = (QuadData_t *) q->p.user_data;
+  KernelCtx_t    *ctx      = (KernelCtx_t *) user_data;
+
+  const int gradVarIdx = ctx->xId;
 
   int i;
 
@@ -116,11 +106,35 @@ void computeGradGauss(p4est_iter_face_info_t *info,
 {
   int i;
 
+  SimData_t       *simData   = (SimData_t *) info->p4est->user_pointer;
   QuadData_t      *qDat0, *qDat1;
-  QuadData_t      *ghostData = (QuadData_t *) user_data;
+  KernelCtx_t     *ctx       = (KernelCtx_t *) user_data;
+  QuadData_t      *ghostData = ctx->ghostData;
+
+  const int gradVarIdx = ctx->xId;
 
   sc_array_t *sides = &(info->sides);
-  P4EST_ASSERT(sides->elem_count == 2);
+
+  /*-------------------------------------------------------
+  | Boundary face: Zero-gradient extrapolation of the 
+  | state to the face
+  |------------------------------------------------------*/
+  if (sides->elem_count == 1)
+  {
+    p4est_iter_face_side_t *bside;
+    bside = p4est_iter_fside_array_index_int(sides, 0);
+
+    qDat0 = (QuadData_t *) bside->is.full.quad->p.user_data;
+
+    octDouble normal[P4EST_DIM];
+    geom_faceNormal(simData, bside->is.full.quad, 
+                    qDat0, bside->face, normal);
+
+    for (i = 0; i < P4EST_DIM; i++)
+      qDat0->grad_vars[gradVarIdx][i] += normal[i] 
+                                       * qDat0->vars[gradVarIdx];
+    return;
+  }
 
   /*-------------------------------------------------------
   | every face has two sides
@@ -159,10 +173,15 @@ void computeGradGauss(p4est_iter_face_info_t *info,
       /*---------------------------------------------------
       | Add flux contribution
       |--------------------------------------------------*/
-      const octDouble nx = qDat0->normals[iface][0];
-      const octDouble ny = qDat0->normals[iface][1];
+      octDouble normal[P4EST_DIM];
+      geom_faceNormal(simData, 
+                      side[0]->is.hanging.quad[i], 
+                      qDat0, iface, normal);
+
+      const octDouble nx = normal[0];
+      const octDouble ny = normal[1];
 #ifdef P4_TO_P8
-      const octDouble nz = qDat0->normals[iface][2];
+      const octDouble nz = normal[2];
 #endif
       const octDouble var_1  = qDat1->vars[gradVarIdx];
       const octDouble var_0  = qDat0->vars[gradVarIdx];
@@ -213,10 +232,15 @@ void computeGradGauss(p4est_iter_face_info_t *info,
       /*---------------------------------------------------
       | Add flux contribution
       |--------------------------------------------------*/
-      const octDouble nx = qDat1->normals[iface][0];
-      const octDouble ny = qDat1->normals[iface][1];
+      octDouble normal[P4EST_DIM];
+      geom_faceNormal(simData, 
+                      side[1]->is.hanging.quad[i], 
+                      qDat1, iface, normal);
+
+      const octDouble nx = normal[0];
+      const octDouble ny = normal[1];
 #ifdef P4_TO_P8
-      const octDouble nz = qDat1->normals[iface][2];
+      const octDouble nz = normal[2];
 #endif
       const octDouble var_1  = qDat1->vars[gradVarIdx];
       const octDouble var_0  = qDat0->vars[gradVarIdx];
@@ -264,10 +288,15 @@ void computeGradGauss(p4est_iter_face_info_t *info,
     /*-----------------------------------------------------
     | Add flux contribution
     |----------------------------------------------------*/
-    const octDouble nx = qDat0->normals[iface][0];
-    const octDouble ny = qDat0->normals[iface][1];
+    octDouble normal[P4EST_DIM];
+    geom_faceNormal(simData, 
+                    side[0]->is.full.quad, 
+                    qDat0, iface, normal);
+
+    const octDouble nx = normal[0];
+    const octDouble ny = normal[1];
 #ifdef P4_TO_P8
-    const octDouble nz = qDat0->normals[iface][2];
+    const octDouble nz = normal[2];
 #endif
     const octDouble var_0  = qDat0->vars[gradVarIdx];
     const octDouble var_1  = qDat1->vars[gradVarIdx];
@@ -309,12 +338,13 @@ void computeGradients(SimData_t *simData, int varIdx)
 {
   p4est_t       *p4est       = simData->p4est;
   p4est_ghost_t *ghost       = simData->ghost;
-  QuadData_t    *ghostData   = simData->ghostData;
-  
+
   /*-------------------------------------------------------
-  | Set variable index for gradient calculation
+  | Kernel context with the variable index for the 
+  | gradient calculation
   -------------------------------------------------------*/
-  setGradVarIdx(varIdx);
+  KernelCtx_t ctx;
+  init_kernelCtx(&ctx, simData, varIdx, -1);
 
   /*--------------------------------------------------------
   | Exchange data
@@ -328,7 +358,7 @@ void computeGradients(SimData_t *simData, int varIdx)
   -------------------------------------------------------*/
   p4est_iterate(p4est, 
                 ghost, 
-                (void *) ghostData,
+                (void *) &ctx,
                 resetDerivatives,  // cell callback
                 computeGradGauss,   // face callback
 #ifdef P4_TO_P8
@@ -341,7 +371,7 @@ void computeGradients(SimData_t *simData, int varIdx)
   -------------------------------------------------------*/
   p4est_iterate(p4est, 
                 ghost, 
-                (void *) ghostData,
+                (void *) &ctx,
                 divideByVolume,  // cell callback
                 NULL,     // face callback
 #ifdef P4_TO_P8
@@ -41,6 +41,25 @@
 #include <p8est_iterate.h>
 #endif
 
+/***********************************************************
+* init_linSolveOp()
+*-----------------------------------------------------------
+* Initializes the arguments of a linear solver field 
+* operation
+***********************************************************/
+static void init_linSolveOp(LinSolveOp_t *op,
+                            int aId, int bId, int cId,
+                            octDouble w_a, octDouble w_b)
+{
+  op->aId = aId;
+  op->bId = bId;
+  op->cId = cId;
+  op->w_a = w_a;
+  op->w_b = w_b;
+  op->sum = 0.0;
+
+} /* init_linSolveOp() */
+
 /***********************************************************
 * linSolve_printResidual()
 *-----------------------------------------------------------
@@ -61,7 +80,7 @@ void linSolve_printResidual(int xId, int k,
 * Linear solver function for the calculaiton of the global 
 * residual.
 * The local residual is always stored in vars[SRES] and
-* the global residual is stored in sbuf[PRES]
+* the global residual is returned
 ***********************************************************/
 octDouble linSolve_calcGlobResidual(SimData_t *simData,
                                     computeAx  cmpAx,
@@ -69,19 +88,13 @@ octDouble linSolve_calcGlobResidual(SimData_t *simData,
                                     int        AxId,
                                     int         bId)
 {
-  SimParam_t *simParam = simData->simParam;
-
   const int n_elements  = simData->p4est->global_num_quadrants;
   const octDouble n_inv = 1. / (octDouble) n_elements;
 
   /*--------------------------------------------------------
   | vars[AxId] = A * vars[xId]
-  | reset simParam->tmp_xId to xId, since its changed 
-  | inside cmpAx()
   --------------------------------------------------------*/
-  int xId_old = simParam->tmp_xId;
   cmpAx(simData, xId, AxId);
-  simParam->tmp_xId = xId_old;
 
   /*--------------------------------------------------------
   | vars[SRES] = (1.0)*vars[bId] + (-1.0)*vars[AxId] 
@@ -89,12 +102,11 @@ octDouble linSolve_calcGlobResidual(SimData_t *simData,
   linSolve_fieldSum(simData, bId, AxId, SRES, 1.0,  -1.0);
 
   /*--------------------------------------------------------
-  | sbuf[PRES] = sum( vars[SRES] * vars[SRES] )
+  | res = sum( vars[SRES] * vars[SRES] )
   --------------------------------------------------------*/
-  linSolve_scalarProd(simData, SRES, SRES, PRES);
-  simParam->sbuf[PRES] = n_inv * sqrt(simParam->sbuf[PRES]);
+  octDouble res = linSolve_scalarProd(simData, SRES, SRES);
 
-  return simParam->sbuf[PRES];
+  return n_inv * sqrt(res);
 
 } /* linSolve_calcGlobResidual() */
 
@@ -105,15 +117,13 @@ octDouble linSolve_calcGlobResidual(SimData_t *simData,
 * variable over all MPI processes 
 ***********************************************************/
 void linSolve_exchangeScalarBuffer(SimData_t      *simData, 
-                                   int             sbufId,
+                                   octDouble      *sbuf,
                                    sc_MPI_Datatype varType,
                                    sc_MPI_Op       mpiType)
 {
-  SimParam_t *simParam = simData->simParam;
-
-  octDouble buf = simParam->sbuf[sbufId];
+  octDouble buf = *sbuf;
 
-  sc_MPI_Allreduce(&buf, &simParam->sbuf[sbufId],
+  sc_MPI_Allreduce(&buf, sbuf,
                    1, varType, mpiType,
                    simData->mpiParam->mpiComm);
 
@@ -127,18 +137,15 @@ void linSolve_exchangeScalarBuffer(SimData_t      *simData,
 *
 *   c = a_i * b_i
 *
-* and store the in a scalar variable c.
+* and return the global result c.
 ***********************************************************/
-void linSolve_scalarProd(SimData_t *simData, 
-                         int aId, int bId, int cId)
+octDouble linSolve_scalarProd(SimData_t *simData, 
+                              int aId, int bId)
 {
-  int prodBuf[3] = { aId, bId, cId };
+  LinSolveOp_t op;
+  init_linSolveOp(&op, aId, bId, -1, 1.0, 1.0);
 
-  SimParam_t *simParam = simData->simParam;
-
-  simParam->sbuf[cId] = 0.0;
-
-  p4est_iterate(simData->p4est, NULL, (void *) prodBuf,
+  p4est_iterate(simData->p4est, NULL, (void *) &op,
                 linSolve_scalarProd_cb, // cell callback
                 NULL,                   // face callback
 #ifdef P4_TO_P8
@@ -149,10 +156,12 @@ void linSolve_scalarProd(SimData_t *simData,
   /*--------------------------------------------------------
   | Exchange data among all processes
   --------------------------------------------------------*/
-  linSolve_exchangeScalarBuffer(simData, cId, 
+  linSolve_exchangeScalarBuffer(simData, &op.sum, 
                                   sc_MPI_DOUBLE, 
                                   sc_MPI_SUM);
 
+  return op.sum;
+
 } /* linSolve_scalarProd() */
 
 /***********************************************************
@@ -168,9 +177,10 @@ void linSolve_scalarProd(SimData_t *simData,
 void linSolve_fieldProd(SimData_t *simData, 
                         int aId, int bId, int cId)
 {
-  int prodBuf[3] = { aId, bId, cId };
+  LinSolveOp_t op;
+  init_linSolveOp(&op, aId, bId, cId, 1.0, 1.0);
 
-  p4est_iterate(simData->p4est, NULL, (void *) prodBuf,
+  p4est_iterate(simData->p4est, NULL, (void *) &op,
                 linSolve_fieldProd_cb, // cell callback
                 NULL,                  // face callback
 #ifdef P4_TO_P8
@@ -188,22 +198,16 @@ void linSolve_fieldProd(SimData_t *simData,
 *
 *   c = w_a * a_i + w_b * b_i
 *
-* and store the in a scalar variable c.
+* and return the local result c.
 ***********************************************************/
-void linSolve_scalarSum(SimData_t *simData, 
-                        int aId, int bId, int cId,
-                        octDouble w_a, octDouble w_b)
+octDouble linSolve_scalarSum(SimData_t *simData, 
+                             int aId, int bId,
+                             octDouble w_a, octDouble w_b)
 {
-  octDouble sumBuf[5] = { (octDouble) aId,
-                          (octDouble) bId,
-                          (octDouble) cId,
-                           w_a, w_b };
-
-  SimParam_t *simParam = simData->simParam;
+  LinSolveOp_t op;
+  init_linSolveOp(&op, aId, bId, -1, w_a, w_b);
 
-  simParam->sbuf[cId] = 0.0;
-
-  p4est_iterate(simData->p4est, NULL, (void *) sumBuf,
+  p4est_iterate(simData->p4est, NULL, (void *) &op,
                 linSolve_scalarSum_cb, // cell callback
                 NULL,                 // face callback
 #ifdef P4_TO_P8
@@ -211,6 +215,8 @@ void linSolve_scalarSum(SimData_t *simData,
 #endif
                 NULL);                // corner callback*/
 
+  return op.sum;
+
 } /* linSolve_scalarSum() */
 
 /***********************************************************
@@ -227,12 +233,10 @@ void linSolve_fieldSum(SimData_t *simData,
                        int aId, int bId, int cId, 
                        octDouble w_a, octDouble w_b)
 {
-  octDouble sumBuf[5] = { (octDouble) aId,
-                          (octDouble) bId,
-                          (octDouble) cId,
-                           w_a, w_b };
+  LinSolveOp_t op;
+  init_linSolveOp(&op, aId, bId, cId, w_a, w_b);
 
-  p4est_iterate(simData->p4est, NULL, (void *) sumBuf,
+  p4est_iterate(simData->p4est, NULL, (void *) &op,
                 linSolve_fieldSum_cb, // cell callback
                 NULL,                 // face callback
 #ifdef P4_TO_P8
@@ -251,9 +255,10 @@ void linSolve_fieldSum(SimData_t *simData,
 void linSolve_fieldCopy(SimData_t *simData, 
                        int aId, int bId)
 {
-  int cpyBuf[2] = {  aId, bId };
+  LinSolveOp_t op;
+  init_linSolveOp(&op, aId, bId, -1, 1.0, 0.0);
 
-  p4est_iterate(simData->p4est, NULL, (void *) cpyBuf,
+  p4est_iterate(simData->p4est, NULL, (void *) &op,
                 linSolve_fieldCopy_cb, // cell callback
                 NULL,                  // face callback
 #ifdef P4_TO_P8
@@ -274,19 +279,13 @@ void linSolve_fieldCopy(SimData_t *simData,
 void linSolve_fieldSum_cb(p4est_iter_volume_info_t *info,
                           void *user_data)
 {
-  QuadData_t *quadData = (QuadData_t*)info->quad->p.user_data;
-
-  int aId = (int)((octDouble *) user_data)[0];
-  int bId = (int)((octDouble *) user_data)[1];
-  int cId = (int)((octDouble *) user_data)[2];
+  QuadData_t   *quadData = (QuadData_t*)info->quad->p.user_data;
+  LinSolveOp_t *op       = (LinSolveOp_t*)user_data;
 
-  octDouble w_a = ((octDouble *) user_data)[3];
-  octDouble w_b = ((octDouble *) user_data)[4];
+  octDouble a = quadData->vars[op->aId];
+  octDouble b = quadData->vars[op->bId];
 
-  octDouble a = quadData->vars[aId];
-  octDouble b = quadData->vars[bId];
-
-  quadData->vars[cId] = w_a*a + w_b*b;
+  quadData->vars[op->cId] = op->w_a*a + op->w_b*b;
 
 } /* linSolve_fieldSum_cb() */
 
@@ -299,21 +298,13 @@ void linSolve_fieldSum_cb(p4est_iter_volume_info_t *info,
 void linSolve_scalarSum_cb(p4est_iter_volume_info_t *info,
                            void *user_data)
 {
-  QuadData_t *quadData = (QuadData_t*)info->quad->p.user_data;
-  SimData_t  *simData  = (SimData_t*)info->p4est->user_pointer;
-  SimParam_t *simParam = simData->simParam;
-
-  int aId = (int)((octDouble *) user_data)[0];
-  int bId = (int)((octDouble *) user_data)[1];
-  int cId = (int)((octDouble *) user_data)[2];
+  QuadData_t   *quadData = (QuadData_t*)info->quad->p.user_data;
+  LinSolveOp_t *op       = (LinSolveOp_t*)user_data;
 
-  octDouble w_a = ((octDouble *) user_data)[3];
-  octDouble w_b = ((octDouble *) user_data)[4];
+  octDouble a = quadData->vars[op->aId];
+  octDouble b = quadData->vars[op->bId];
 
-  octDouble a = quadData->vars[aId];
-  octDouble b = quadData->vars[bId];
-
-  simParam->sbuf[cId] += w_a*a + w_b*b;
+  op->sum += op->w_a*a + op->w_b*b;
 
 } /* linSolve_scalarSum_cb() */
 
@@ -326,16 +317,13 @@ void linSolve_scalarSum_cb(p4est_iter_volume_info_t *info,
 void linSolve_fieldProd_cb(p4est_iter_volume_info_t *info,
                            void *user_data)
 {
-  QuadData_t *quadData = (QuadData_t*)info->quad->p.user_data;
-
-  int aId = ((int *) user_data)[0];
-  int bId = ((int *) user_data)[1];
-  int cId = ((int *) user_data)[2];
+  QuadData_t   *quadData = (QuadData_t*)info->quad->p.user_data;
+  LinSolveOp_t *op       = (LinSolveOp_t*)user_data;
 
-  octDouble a = quadData->vars[aId];
-  octDouble b = quadData->vars[bId];
+  octDouble a = quadData->vars[op->aId];
+  octDouble b = quadData->vars[op->bId];
 
-  quadData->vars[cId] = a * b;
+  quadData->vars[op->cId] = a * b;
 
 } /* linSolve_fieldProd_cb() */
 
@@ -348,18 +336,13 @@ void linSolve_fieldProd_cb(p4est_iter_volume_info_t *info,
 void linSolve_scalarProd_cb(p4est_iter_volume_info_t *info,
                             void *user_data)
 {
-  QuadData_t *quadData = (QuadData_t*)info->quad->p.user_data;
-  SimData_t  *simData  = (SimData_t*)info->p4est->user_pointer;
-  SimParam_t *simParam = simData->simParam;
+  QuadData_t   *quadData = (QuadData_t*)info->quad->p.user_data;
+  LinSolveOp_t *op       = (LinSolveOp_t*)user_data;
 
-  int aId = ((int *) user_data)[0];
-  int bId = ((int *) user_data)[1];
-  int cId = ((int *) user_data)[2];
+  octDouble a = quadData->vars[op->aId];
+  octDouble b = quadData->vars[op->bId];
 
-  octDouble a = quadData->vars[aId];
-  octDouble b = quadData->vars[bId];
-
-  simParam->sbuf[cId] += a * b;
+  op->sum += a * b;
 
 } /* linSolve_scalarProd_cb() */
 
@@ -372,12 +355,10 @@ void linSolve_scalarProd_cb(p4est_iter_volume_info_t *info,
 void linSolve_fieldCopy_cb(p4est_iter_volume_info_t *info,
                            void *user_data)
 {
-  QuadData_t *quadData = (QuadData_t*)info->quad->p.user_data;
-
-  int aId = ((int *) user_data)[0];
-  int bId = ((int *) user_data)[1];
+  QuadData_t   *quadData = (QuadData_t*)info->quad->p.user_data;
+  LinSolveOp_t *op       = (LinSolveOp_t*)user_data;
 
-  quadData->vars[bId] = quadData->vars[aId];
+  quadData->vars[op->bId] = quadData->vars[op->aId];
 
 } /* linSolve_fieldCopy_cb() */
 
@@ -396,15 +377,12 @@ void addRightHandSide(p4est_iter_volume_info_t *info,
 {
   p4est_quadrant_t  *q = info->quad;
 
-  p4est_t    *p4est    = info->p4est;
-  SimData_t  *simData  = (SimData_t *) p4est->user_pointer;
-  QuadData_t *quadData = (QuadData_t *) q->p.user_data;
-
-  SimParam_t *simParam = simData->simParam;
-  int         xId      = simParam->tmp_xId;
+  QuadData_t  *quadData = (QuadData_t *) q->p.user_data;
+  KernelCtx_t *ctx      = (KernelCtx_t *) user_data;
+  int          xId      = ctx->xId;
 
   const octDouble vol     = quadData->volume;
-  const octDouble dt      = simParam->timestep;
+  const octDouble dt      = ctx->dt;
   const octDouble rho     = quadData->vars[IRHO];
   const octDouble b       = quadData->vars[SB];
 
@@ -433,16 +411,20 @@ void linSolve_bicgstab(SimData_t *simData,
 
   int k = 0;
 
+  octDouble wtime = sc_MPI_Wtime();
+
   /*--------------------------------------------------------
   | Init scalar solver buffers
   --------------------------------------------------------*/
-  simParam->sbuf[PR0]   = 1.0;
-  simParam->sbuf[PA]    = 1.0;
-  simParam->sbuf[PO]    = 1.0;
-  simParam->sbuf[PR]    = 0.0;
-  simParam->sbuf[PB]    = 0.0;
-  simParam->sbuf[PRES]  = 0.0;
-  simParam->sbuf[PGRES] = 0.0;
+  octDouble sbuf[PARAM_BUF_VARS];
+
+  sbuf[PR0]   = 1.0;
+  sbuf[PA]    = 1.0;
+  sbuf[PO]    = 1.0;
+  sbuf[PR]    = 0.0;
+  sbuf[PB]    = 0.0;
+  sbuf[PRES]  = 0.0;
+  sbuf[PGRES] = 0.0;
 
   /*--------------------------------------------------------
   | Threshold parameters
@@ -470,8 +452,8 @@ void linSolve_bicgstab(SimData_t *simData,
   /*--------------------------------------------------------
   | sbuf[PGRES] = sqrt( sum( vars[SR] * vars[SR] ) ) / N
   --------------------------------------------------------*/
-  linSolve_scalarProd(simData, SR, SR, PGRES);
-  simParam->sbuf[PGRES] = n_inv * sqrt(simParam->sbuf[PGRES]);
+  sbuf[PGRES] = linSolve_scalarProd(simData, SR, SR);
+  sbuf[PGRES] = n_inv * sqrt(sbuf[PGRES]);
 
   while( k < kMax )
   {
@@ -480,62 +462,59 @@ void linSolve_bicgstab(SimData_t *simData,
     /*------------------------------------------------------
     | sbuf[PR] = sum( vars[SR0] * vars[SR] )
     ------------------------------------------------------*/
-    linSolve_scalarProd(simData, SR0, SR, PR);
+    sbuf[PR] = linSolve_scalarProd(simData, SR0, SR);
 
     /*------------------------------------------------------
     | Update buffers beta (PB) and rho_0 (PR0) 
     ------------------------------------------------------*/
-    octDouble rho   = simParam->sbuf[PR];
-    octDouble rho_0 = simParam->sbuf[PR0];
-    octDouble alpha = simParam->sbuf[PA];
-    octDouble omega = simParam->sbuf[PO];
+    octDouble rho   = sbuf[PR];
+    octDouble rho_0 = sbuf[PR0];
+    octDouble alpha = sbuf[PA];
+    octDouble omega = sbuf[PO];
 
-    simParam->sbuf[PB]  = (rho / (SMALL+rho_0)) 
+    sbuf[PB]  = (rho / (SMALL+rho_0)) 
                         * (alpha / (SMALL+omega));
-    simParam->sbuf[PR0] = rho;
+    sbuf[PR0] = rho;
 
     /*------------------------------------------------------
     | 1) vars[SP] = (1.0)*vars[SP] + (-sbuf[PO])*vars[SV]
     | 2) vars[SP] = (1.0)*vars[SR] + ( sbuf[PB])*vars[SP]
     ------------------------------------------------------*/
     linSolve_fieldSum(simData, SP, SV, SP, 
-                      1.0, -simParam->sbuf[PO]);
+                      1.0, -sbuf[PO]);
     linSolve_fieldSum(simData, SR, SP, SP, 
-                      1.0,  simParam->sbuf[PB]);
+                      1.0,  sbuf[PB]);
 
     /*------------------------------------------------------
     | Compute v = A*p
-    | reset simParam->tmp_xId to xId, since its changed 
-    | inside cmpAx()
     ------------------------------------------------------*/
     cmpAx(simData, SP, SV);
-    simParam->tmp_xId = xId;
 
     /*------------------------------------------------------
     | sbuf[PA] = sum( vars[SR0] * vars[SV] )
     ------------------------------------------------------*/
-    linSolve_scalarProd(simData, SR0, SV, PA);
+    sbuf[PA] = linSolve_scalarProd(simData, SR0, SV);
 
-    alpha = 1. / (SMALL + simParam->sbuf[PA]);
-    simParam->sbuf[PA] = alpha * simParam->sbuf[PR]; 
+    alpha = 1. / (SMALL + sbuf[PA]);
+    sbuf[PA] = alpha * sbuf[PR]; 
 
     /*------------------------------------------------------
     | vars[SH] = (1.0)*vars[xId] + (sbuf[PA])*vars[SP]
     ------------------------------------------------------*/
     linSolve_fieldSum(simData, xId, SP, SH, 
-                      1.0,  simParam->sbuf[PA]);
+                      1.0,  sbuf[PA]);
 
     /*------------------------------------------------------
     | Calculate global residual for the equation system
     | A*h = b and store it in sbuf[PRES]
     ------------------------------------------------------*/
-    linSolve_calcGlobResidual(simData, cmpAx, SH, SAX, SB);
+    sbuf[PRES] = linSolve_calcGlobResidual(simData, cmpAx, SH, SAX, SB);
 
     /*------------------------------------------------------
     | Check if vars[SH] is accuarte enough
     | if yes -> set as new solution and resume
     ------------------------------------------------------*/
-    if ( simParam->sbuf[PRES] < eps && k > kMin )
+    if ( sbuf[PRES] < eps && k > kMin )
     {
       linSolve_fieldCopy(simData, SH, xId);
       break;
@@ -545,49 +524,48 @@ void linSolve_bicgstab(SimData_t *simData,
     | vars[SS] = (1.0)*vars[SR] + (-sbuf[PA])*vars[SV]
     ------------------------------------------------------*/
     linSolve_fieldSum(simData, SR, SV, SS, 
-                      1.0,  -simParam->sbuf[PA]);
+                      1.0,  -sbuf[PA]);
 
     /*------------------------------------------------------
     | vars[ST] = A*vars[SS]
     ------------------------------------------------------*/
     cmpAx(simData, SS, ST);
-    simParam->tmp_xId = xId;
 
     /*------------------------------------------------------
     | sbuf[PO] = sum( vars[ST] * vars[ST] )
     ------------------------------------------------------*/
-    linSolve_scalarProd(simData, ST, ST, PO);
-    omega = 1. / (simParam->sbuf[PO] + SMALL);
+    sbuf[PO] = linSolve_scalarProd(simData, ST, ST);
+    omega = 1. / (sbuf[PO] + SMALL);
 
     /*------------------------------------------------------
     | sbuf[PO] = sum( vars[ST] * vars[SS] )
     ------------------------------------------------------*/
-    linSolve_scalarProd(simData, ST, SS, PO);
-    simParam->sbuf[PO] *= omega;
+    sbuf[PO] = linSolve_scalarProd(simData, ST, SS);
+    sbuf[PO] *= omega;
 
     /*------------------------------------------------------
     | vars[xId] = (1.0)*vars[SH] + (sbuf[PO])*vars[SS]
     ------------------------------------------------------*/
     linSolve_fieldSum(simData, SH, SS, xId, 
-                      1.0,  simParam->sbuf[PO]);
+                      1.0,  sbuf[PO]);
 
     /*------------------------------------------------------
     | Calculate global residual for the equation system
     | A*h = b and store it in sbuf[PRES]
     ------------------------------------------------------*/
-    linSolve_calcGlobResidual(simData, cmpAx, xId, SAX, SB);
+    sbuf[PRES] = linSolve_calcGlobResidual(simData, cmpAx, xId, SAX, SB);
 
     /*------------------------------------------------------
     | Check if vars[xId] is accuarte enough
     ------------------------------------------------------*/
-    if ( simParam->sbuf[PRES] < eps && k > kMin )
+    if ( sbuf[PRES] < eps && k > kMin )
       break;
 
     /*------------------------------------------------------
     | vars[SR] = (1.0)*vars[SS] + (-sbuf[PO])*vars[ST]
     ------------------------------------------------------*/
     linSolve_fieldSum(simData, SS, ST, SR, 
-                      1.0, -simParam->sbuf[PO]);
+                      1.0, -sbuf[PO]);
 
   } /* while( k < kMax ) */
 
@@ -596,8 +574,15 @@ void linSolve_bicgstab(SimData_t *simData,
   | Print out residuals for user
   --------------------------------------------------------*/
   linSolve_printResidual(xId, k, 
-                         simParam->sbuf[PGRES], 
-                         simParam->sbuf[PRES]);
+                         sbuf[PGRES], 
+                         sbuf[PRES]);
+
+  /*--------------------------------------------------------
+  | Update solver cost statistics
+  --------------------------------------------------------*/
+  UPDATE_RUNNING_AVG(simParam->avgKrylovIter, (octDouble) k);
+  UPDATE_RUNNING_AVG(simParam->timeKrylovIter, 
+                     (sc_MPI_Wtime() - wtime) / (octDouble) MAX(k,1));
 
 
 } /* linSolve_bicgstab() */
@@ -608,19 +593,21 @@ void linSolve_bicgstab(SimData_t *simData,
 *-----------------------------------------------------------
 * Solve the equation system 
 *   A x = b
-* using an explicit method.
+* using an explicit method with timestep <dt>.
 ***********************************************************/
 void solve_explicit_sequential(SimData_t *simData, 
-                               int        xId)
+                               int        xId,
+                               octDouble  dt)
 {
-  SimParam_t *simParam = simData->simParam;
-  simParam->tmp_xId    = xId;
+  KernelCtx_t ctx;
+  init_kernelCtx(&ctx, simData, xId, SB);
+  ctx.dt = dt;
 
   /*--------------------------------------------------------
   | Add right hand side to solution 
   --------------------------------------------------------*/
   p4est_iterate(simData->p4est, simData->ghost, 
-                (void *) simData->ghostData,
+                (void *) &ctx,
                 addRightHandSide,  // cell callback
                 NULL,              // face callback
 #ifdef P4_TO_P8
@@ -642,9 +629,6 @@ void solve_implicit_sequential(SimData_t *simData,
                                computeAx  cmpAx,
                                int        xId)
 {
-  SimParam_t *simParam = simData->simParam;
-  simParam->tmp_xId    = xId;
-
   /*--------------------------------------------------------
   | Solve linear equation system using Krylov solver
   --------------------------------------------------------*/
@@ -28,9 +28,12 @@
 #include "solver/util.h"
 #include "solver/quadData.h"
 #include "solver/simData.h"
+#include "solver/geometry.h"
 #include "solver/util.h"
 #include "aux/dbg.h"
 
+#include <math.h>
+
 #ifndef P4_TO_P8
 #include <p4est_bits.h>
 #include <p4est_extended.h>
@@ -70,18 +73,23 @@ void resetMassflux(p4est_iter_volume_info_t *info,
 void computeMassflux(p4est_iter_face_info_t *info,
                      void                   *user_data)
 {
+  SimData_t       *simData   = (SimData_t *) info->p4est->user_pointer;
   QuadData_t      *qData;
   QuadData_t      *ghostData = (QuadData_t *) user_data;
 
   sc_array_t *sides = &(info->sides);
-  P4EST_ASSERT(sides->elem_count == 2);
+
+  /*-------------------------------------------------------
+  | Boundary faces are closed walls -> mflux remains zero
+  |------------------------------------------------------*/
+  if (sides->elem_count < 2)
+    return;
 
 
   int i;
 
   /*-------------------------------------------------------
-  | No boundaries implemented yet -> every face has two 
-  | sides
+  | Inner face -> every face has two sides
   |------------------------------------------------------*/
   p4est_iter_face_side_t *side[2];
   side[0] = p4est_iter_fside_array_index_int(sides, 0);
@@ -128,10 +136,15 @@ void computeMassflux(p4est_iter_face_info_t *info,
       const octDouble w0 = qData->vars[IVZ];
 #endif
 
-      const octDouble nx = qData->normals[iface_0][0];
-      const octDouble ny = qData->normals[iface_0][1];
+      octDouble normal[P4EST_DIM];
+      geom_faceNormal(simData, 
+                      side[0]->is.hanging.quad[i], 
+                      qData, iface_0, normal);
+
+      const octDouble nx = normal[0];
+      const octDouble ny = normal[1];
 #ifdef P4_TO_P8
-      const octDouble nz = qData->normals[iface_0][2];
+      const octDouble nz = normal[2];
 #endif
 
       /*---------------------------------------------------
@@ -195,10 +208,15 @@ void computeMassflux(p4est_iter_face_info_t *info,
       const octDouble w1 = qData->vars[IVZ];
 #endif
 
-      const octDouble nx = qData->normals[iface_1][0];
-      const octDouble ny = qData->normals[iface_1][1];
+      octDouble normal[P4EST_DIM];
+      geom_faceNormal(simData, 
+                      side[1]->is.hanging.quad[i], 
+                      qData, iface_1, normal);
+
+      const octDouble nx = normal[0];
+      const octDouble ny = normal[1];
 #ifdef P4_TO_P8
-      const octDouble nz = qData->normals[iface_1][2];
+      const octDouble nz = normal[2];
 #endif
 
       /*---------------------------------------------------
@@ -247,10 +265,15 @@ void computeMassflux(p4est_iter_face_info_t *info,
     /*-----------------------------------------------------
     | Use normals from side 0
     |----------------------------------------------------*/
-    const octDouble nx = qData->normals[iface_0][0];
-    const octDouble ny = qData->normals[iface_0][1];
+    octDouble normal[P4EST_DIM];
+    geom_faceNormal(simData, 
+                    side[0]->is.full.quad, 
+                    qData, iface_0, normal);
+
+    const octDouble nx = normal[0];
+    const octDouble ny = normal[1];
 #ifdef P4_TO_P8
-    const octDouble nz = qData->normals[iface_0][2];
+    const octDouble nz = normal[2];
 #endif
 
 
@@ -300,6 +323,46 @@ void computeMassflux(p4est_iter_face_info_t *info,
 
 } /* computeMassflux() */
 
+/***********************************************************
+* computeCourantRate()
+*-----------------------------------------------------------
+* Function to compute the CFL number of a quad for a unit 
+* timestep from its mass fluxes and volume. The maximum 
+* over all local quads is accumulated in the kernel 
+* context (KernelCtx_t.courantRate), the maximum for 
+* local time stepping in KernelCtx_t.courantRateSub.
+*
+*   -> p4est_iter_volume_t callback function
+***********************************************************/
+void computeCourantRate(p4est_iter_volume_info_t *info,
+                        void  *user_data)
+{
+  SimData_t   *simData  = (SimData_t *) info->p4est->user_pointer;
+  QuadData_t  *quadData = (QuadData_t *) info->quad->p.user_data;
+  KernelCtx_t *ctx      = (KernelCtx_t *) user_data;
+  SimParam_t  *simParam = simData->simParam;
+
+  octDouble flux = 0.0;
+  int i;
+
+  for (i = 0; i < 2*P4EST_DIM; i++)
+    flux += fabs(quadData->mflux[i]);
+
+  octDouble rate = 0.5 * flux / quadData->volume;
+
+  ctx->courantRate = MAX(ctx->courantRate, rate);
+
+  /*--------------------------------------------------------
+  | Local time stepping: quads advance with 
+  | dt / 2^(level - lvlMin)
+  --------------------------------------------------------*/
+  if (simParam->subcycling == TRUE)
+    rate = ldexp(rate, simParam->lvlMin - info->quad->level);
+
+  ctx->courantRateSub = MAX(ctx->courantRateSub, rate);
+
+} /* computeCourantRate() */
+
 /***********************************************************
 * initMassfluxes()
 *-----------------------------------------------------------
@@ -332,6 +395,28 @@ void initMassfluxes(SimData_t *simData)
 #endif
                 NULL);           // corner callback*/
 
+  /*-------------------------------------------------------
+  | Estimate CFL numbers from the complete mass fluxes
+  -------------------------------------------------------*/
+  if (  simData->simParam->adaptTimestep == TRUE
+     || simData->simParam->autoScheme    == TRUE )
+  {
+    KernelCtx_t ctx;
+    init_kernelCtx(&ctx, simData, -1, -1);
+
+    p4est_iterate(p4est, 
+                  NULL, 
+                  (void *) &ctx,
+                  computeCourantRate, // cell callback
+                  NULL,               // face callback
+#ifdef P4_TO_P8
+                  NULL,               // edge callback
+#endif
+                  NULL);              // corner callback
+
+    simData->simParam->courantRate    = ctx.courantRate;
+    simData->simParam->courantRateSub = ctx.courantRateSub;
+  }
 
 } /* calcMassfluxes() */
 
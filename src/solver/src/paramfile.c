@@ -27,6 +27,8 @@
 #include "aux/bstrlib.h"
 #include "solver/paramfile.h"
 #include "solver/simData.h"
+#include "solver/probes.h"
+#include "solver/zones.h"
 
 /*************************************************************
 * octParam_readParamfile()
@@ -52,6 +54,16 @@ int octParam_readParamfile(SimData_t  *simData,
   int stopSim = FALSE;
   stopSim = octParam_initParameters(simData, paramFile);
 
+  /*----------------------------------------------------------
+  | Read probe definitions
+  ----------------------------------------------------------*/
+  simData->probes = init_probes(paramFile);
+
+  /*----------------------------------------------------------
+  | Read refinement zones
+  ----------------------------------------------------------*/
+  simData->zones = init_zones(paramFile);
+
   /*----------------------------------------------------------
   | Free memory
   ----------------------------------------------------------*/
@@ -73,6 +85,10 @@ int octParam_initParameters(SimData_t *simData,
   SimParam_t    *simParam    = simData->simParam;
   SolverParam_t *solverParam = simData->solverParam;
 
+  bstring tempScheme   = NULL;
+  bstring autoExplicit = NULL;
+  bstring autoImplicit = NULL;
+
   /*----------------------------------------------------------
   | Define simulation parameter instructions
   ----------------------------------------------------------*/
@@ -84,8 +100,35 @@ int octParam_initParameters(SimData_t *simData,
     {"Total simulation time [s]:",
      &simParam->simTimeTot, DBLVAL, TRUE, 
      -1, -1.0, NULL},
+    {"Adaptive time step (0/1):",
+     &simParam->adaptTimestep, INTVAL, FALSE, 
+     FALSE, -1.0, NULL},
+    {"Target CFL number:",
+     &simParam->cflTarget, DBLVAL, FALSE, 
+     -1, 1.0, NULL},
+    {"Target CFL number (explicit):",
+     &simParam->cflTargetExplicit, DBLVAL, FALSE, 
+     -1, 0.5, NULL},
+    {"Minimum time step [s]:",
+     &simParam->timestepMin, DBLVAL, FALSE, 
+     -1, 1.0E-08, NULL},
+    {"Maximum time step [s]:",
+     &simParam->timestepMax, DBLVAL, FALSE, 
+     -1, 1.0, NULL},
+    {"Automatic scheme (explicit):",
+     &autoExplicit, STRVAL, FALSE, 
+     -1, -1.0, "SSP-RK2"},
+    {"Automatic scheme (implicit):",
+     &autoImplicit, STRVAL, FALSE, 
+     -1, -1.0, "Crank-Nicolson"},
+    {"Local time stepping (0/1):",
+     &simParam->subcycling, INTVAL, FALSE, 
+     FALSE, -1.0, NULL},
+    {"Solve momentum predictor (0/1):",
+     &simParam->solveMomentum, INTVAL, FALSE, 
+     FALSE, -1.0, NULL},
     {"Temporal discretization scheme:",
-     &simParam->tempScheme, STRVAL, FALSE, 
+     &tempScheme, STRVAL, FALSE, 
      -1, -1.0, "Crank-Nicolson"},
     {"Reference kinematic viscosity [Pa*s]:",
      &simParam->viscosity, DBLVAL, FALSE, 
@@ -95,67 +138,228 @@ int octParam_initParameters(SimData_t *simData,
   /*----------------------------------------------------------
   | Define solver parameter instructions
   ----------------------------------------------------------*/
+  octParamInst solverParamInst[OCT_MAX_PARAMETERS] = 
+  {
+    {"Mesh file (.inp):",
+     &solverParam->meshFile, STRVAL, FALSE, 
+     -1, -1.0, ""},
+    {"Number of trees in x-direction:",
+     &solverParam->nTrees[0], INTVAL, FALSE, 
+     1, -1.0, NULL},
+    {"Number of trees in y-direction:",
+     &solverParam->nTrees[1], INTVAL, FALSE, 
+     1, -1.0, NULL},
+    {"Number of trees in z-direction:",
+     &solverParam->nTrees[2], INTVAL, FALSE, 
+     1, -1.0, NULL},
+    {"Periodic in x-direction (0/1):",
+     &solverParam->periodic[0], INTVAL, FALSE, 
+     TRUE, -1.0, NULL},
+    {"Periodic in y-direction (0/1):",
+     &solverParam->periodic[1], INTVAL, FALSE, 
+     TRUE, -1.0, NULL},
+    {"Periodic in z-direction (0/1):",
+     &solverParam->periodic[2], INTVAL, FALSE, 
+     TRUE, -1.0, NULL},
+    {"Refinement error scalar:",
+     &solverParam->refErr_scalar, DBLVAL, FALSE, 
+     -1, 0.05, NULL},
+    {"Refinement error pressure (0: off):",
+     &solverParam->refErr_pressure, DBLVAL, FALSE, 
+     -1, 0.0, NULL},
+    {"Refinement error vorticity (0: off):",
+     &solverParam->refErr_vorticity, DBLVAL, FALSE, 
+     -1, 0.0, NULL},
+    {"Refinement error velocity jump (0: off):",
+     &solverParam->refErr_velocity, DBLVAL, FALSE, 
+     -1, 0.0, NULL},
+    {"Target number of quads (0: off):",
+     &solverParam->quadTarget, INTVAL, FALSE, 
+     0, -1.0, NULL},
+    {"Maximum number of quads (0: unlimited):",
+     &solverParam->quadMax, INTVAL, FALSE, 
+     0, -1.0, NULL},
+    {"Predictive refinement (0/1):",
+     &solverParam->predictRefine, INTVAL, FALSE, 
+     FALSE, -1.0, NULL},
+    {"Coarsening threshold ratio:",
+     &solverParam->coarsenRatio, DBLVAL, FALSE, 
+     -1, 0.5, NULL},
+    {"Minimum refinement age:",
+     &solverParam->minRefineAge, INTVAL, FALSE, 
+     2, -1.0, NULL},
+    {"Output time interval [s]:",
+     &solverParam->writeInterval, DBLVAL, FALSE, 
+     -1, 0.0, NULL},
+    {"Output format (0: vtk, 1: snapshot):",
+     &solverParam->io_format, INTVAL, FALSE, 
+     OUTPUT_VTK, -1.0, NULL},
+    {"Asynchronous output (0/1):",
+     &solverParam->io_async, INTVAL, FALSE, 
+     FALSE, -1.0, NULL},
+    {"Output buffer size [MB]:",
+     &solverParam->io_bufferSize, DBLVAL, FALSE, 
+     -1, 256.0, NULL},
+    {"Checkpoint period:",
+     &solverParam->checkpointPeriod, INTVAL, FALSE, 
+     0, -1.0, NULL},
+    {"Restart file:",
+     &solverParam->io_restartFile, STRVAL, FALSE, 
+     -1, -1.0, ""},
+  };
+
+  /*----------------------------------------------------------
+  | Read parameter instructions
+  ----------------------------------------------------------*/
+  octBool stopSim = FALSE;
 
+  stopSim |= octParam_readInstructions(paramFile, simParamInst);
+  stopSim |= octParam_readInstructions(paramFile, solverParamInst);
 
-  
   /*----------------------------------------------------------
-  | Read simulation parameter instructions
+  | Convert string parameters
+  ----------------------------------------------------------*/
+  simParam->tempScheme         = octParam_tempScheme(tempScheme);
+  simParam->autoSchemeExplicit = octParam_tempScheme(autoExplicit);
+  simParam->autoSchemeImplicit = octParam_tempScheme(autoImplicit);
+
+  if (simParam->tempScheme == AUTOMATIC_SCHEME)
+  {
+    simParam->autoScheme = TRUE;
+    simParam->tempScheme = simParam->autoSchemeImplicit;
+
+    if (  !IS_EXPLICIT_SCHEME(simParam->autoSchemeExplicit)
+        || simParam->autoSchemeImplicit < 0
+        || IS_EXPLICIT_SCHEME(simParam->autoSchemeImplicit) )
+    {
+      octPrint("[ERROR]: INVALID SCHEMES FOR AUTOMATIC MODE");
+      stopSim = TRUE;
+    }
+  }
+
+  if (simParam->tempScheme < 0)
+  {
+    octPrint("[ERROR]: UNKNOWN TEMPORAL DISCRETIZATION SCHEME");
+    octPrint("Valid schemes: Euler-explicit, Euler-implicit, "
+             "Crank-Nicolson, SSP-RK2, SSP-RK3, Automatic");
+    stopSim = TRUE;
+  }
+
+  bdestroy(tempScheme);
+  bdestroy(autoExplicit);
+  bdestroy(autoImplicit);
+
+  return stopSim;
+
+} /* octParam_initParameters() */
+
+/*************************************************************
+* octParam_tempScheme()
+*-------------------------------------------------------------
+* Function to convert the name of a temporal discretization 
+* scheme into its TempScheme identifier (or AUTOMATIC_SCHEME).
+* Returns -1 for unknown schemes.
+*************************************************************/
+int octParam_tempScheme(bstring name)
+{
+  if (name == NULL)
+    return -1;
+
+  bstring buf = bstrcpy(name);
+  btrimws(buf);
+
+  int scheme = -1;
+
+  if (biseqcstrcaseless(buf, "Euler-explicit"))
+    scheme = EULER_EXPLICIT;
+  else if (biseqcstrcaseless(buf, "Euler-implicit"))
+    scheme = EULER_IMPLICIT;
+  else if (biseqcstrcaseless(buf, "Crank-Nicolson"))
+    scheme = CRANK_NICOLSON;
+  else if (biseqcstrcaseless(buf, "SSP-RK2"))
+    scheme = SSP_RK2;
+  else if (biseqcstrcaseless(buf, "SSP-RK3"))
+    scheme = SSP_RK3;
+  else if (biseqcstrcaseless(buf, "Automatic"))
+    scheme = AUTOMATIC_SCHEME;
+
+  bdestroy(buf);
+
+  return scheme;
+
+} /* octParam_tempScheme() */
+
+
+/*************************************************************
+* octParam_readInstructions()
+*-------------------------------------------------------------
+* Function to read all parameters of an instruction array
+* <inst> from the parameter file. The array has 
+* OCT_MAX_PARAMETERS entries, unused entries have an empty 
+* instruction string.
+* Returns TRUE if a mandatory parameter is missing.
+*************************************************************/
+int octParam_readInstructions(octParam     *paramFile,
+                              octParamInst *inst)
+{
+  /*----------------------------------------------------------
+  | Read all parameter instructions
   ----------------------------------------------------------*/
   int i, nvals;
   octBool stopSim = FALSE;
 
   for (i = 0; i < OCT_MAX_PARAMETERS; i++)
   {
-    if (strlen(simParamInst[i].inst) == 0)
+    if (strlen(inst[i].inst) == 0)
       continue;
 
     nvals = octParam_extractParam(paramFile->txtlist,
-                                  simParamInst[i].inst,
-                                  simParamInst[i].pType,
-                                  simParamInst[i].value);
+                                  inst[i].inst,
+                                  inst[i].pType,
+                                  inst[i].value);
 
     /*--------------------------------------------------------
     | Handle missing parameters
     --------------------------------------------------------*/
-    if (nvals < 1 && simParamInst[i].mandatory == TRUE)
+    if (nvals < 1 && inst[i].mandatory == TRUE)
     {
       octPrint("[ERROR]: MISSING PARAMETER");
-      octPrint("%s <UNDEFINED>", simParamInst[i].inst);
+      octPrint("%s <UNDEFINED>", inst[i].inst);
       stopSim = TRUE;
     }
-    else if (nvals < 1 && simParamInst[i].mandatory == FALSE)
+    else if (nvals < 1 && inst[i].mandatory == FALSE)
     {
-      if (simParamInst[i].pType == INTVAL)
+      if (inst[i].pType == INTVAL)
       {
-        *(int*)simParamInst[i].value = simParamInst[i].intDefault;
+        *(int*)inst[i].value = inst[i].intDefault;
       }
-      else if (simParamInst[i].pType == DBLVAL)
+      else if (inst[i].pType == DBLVAL)
       {
-        *(octDouble*)simParamInst[i].value = simParamInst[i].dblDefault;
+        *(octDouble*)inst[i].value = inst[i].dblDefault;
       }
-      else if (simParamInst[i].pType == STRVAL)
+      else if (inst[i].pType == STRVAL)
       {
-        *(bstring*)simParamInst[i].value = bfromcstr((char*) simParamInst[i].strDefault);
+        *(bstring*)inst[i].value = bfromcstr((char*) inst[i].strDefault);
       }
     }
 
     /*--------------------------------------------------------
     | Output parameters to user
     --------------------------------------------------------*/
-    if (simParamInst[i].pType == INTVAL)
+    if (inst[i].pType == INTVAL)
     {
-      int *printVal = (int*)simParamInst[i].value;
-      octPrint("%s %d", simParamInst[i].inst, *printVal);
+      int *printVal = (int*)inst[i].value;
+      octPrint("%s %d", inst[i].inst, *printVal);
     }
-    else if (simParamInst[i].pType == DBLVAL)
+    else if (inst[i].pType == DBLVAL)
     {
-      octDouble *printVal = (octDouble*)simParamInst[i].value;
-      octPrint("%s %e", simParamInst[i].inst, *printVal);
+      octDouble *printVal = (octDouble*)inst[i].value;
+      octPrint("%s %e", inst[i].inst, *printVal);
     }
-    else if (simParamInst[i].pType == STRVAL)
+    else if (inst[i].pType == STRVAL)
     {
-      char *printVal = (char*)(*(bstring*)simParamInst[i].value)->data;
-      octPrint("%s %s", simParamInst[i].inst, printVal);
+      char *printVal = (char*)(*(bstring*)inst[i].value)->data;
+      octPrint("%s %s", inst[i].inst, printVal);
     }
 
   }
@@ -163,7 +367,7 @@ int octParam_initParameters(SimData_t *simData,
 
   return stopSim;
 
-} /* octParam_initParameters() */
+} /* octParam_readInstructions() */
 
 /*************************************************************
 * Function to create a new parameter file reader
@@ -648,3 +852,46 @@ int octParam_extractArray(struct bstrList *txtlist,
 
 } /* octParam_extractArray() */
 
+/*************************************************************
+* octParam_readValues()
+*-------------------------------------------------------------
+* Function reads up to <nvals> comma or whitespace separated
+* double values behind the specifier <fltr> in <line> and
+* stores them in <v>.
+*
+* Returns the number of values, that have been read.
+* Returns -1 if the specifier is not found in <line>.
+*************************************************************/
+int octParam_readValues(bstring     line,
+                        const char *fltr,
+                        octDouble  *v,
+                        int         nvals)
+{
+  bstring bfltr = bfromcstr( fltr );
+
+  int off = binstr(line, 0, bfltr);
+  int len = bfltr->slen;
+
+  bdestroy( bfltr );
+
+  if (off == BSTR_ERR)
+    return -1;
+
+  char *str = (char *) line->data + off + len;
+  char *end = NULL;
+  int   n;
+
+  for (n = 0; n < nvals; n++)
+  {
+    v[n] = strtod(str, &end);
+    if (end == str)
+      break;
+
+    str = end;
+    while (*str == ' ' || *str == '\t' || *str == ',')
+      str++;
+  }
+
+  return n;
+
+} /* octParam_readValues() */
@@ -0,0 +1,228 @@
+/*
+* This file is part of OctFS. 
+* OctFS is a finite-volume flow solver with adaptive
+* mesh refinement written in C, which is based on 
+* the p4est library.
+*
+* Copyright (C) 2020 Florian Setzwein 
+*
+* OctFS is free software; you can redistribute it and/or 
+* modify it under the terms of the GNU General Public 
+* License as published by the Free Software Foundation; 
+* either version 2 of the License, or (at your option) 
+* any later version.
+*
+* OctFS is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied 
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR 
+* PURPOSE.  See the GNU General Public License for more 
+* details.
+*
+* You should have received a copy of the GNU General 
+* Public License along with OctFS; if not, write to the 
+* Free Software Foundation, Inc., 51 Franklin Street, 
+* Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+#include "solver/partition.h"
+#include "solver/typedefs.h"
+#include "solver/util.h"
+#include "solver/quadData.h"
+#include "solver/simData.h"
+#include "solver/gradients.h"
+#include "aux/dbg.h"
+
+#ifndef P4_TO_P8
+#include <p4est_bits.h>
+#include <p4est_extended.h>
+#include <p4est_iterate.h>
+#include <p4est_communication.h>
+#else
+#include <p8est_bits.h>
+#include <p8est_extended.h>
+#include <p8est_iterate.h>
+#include <p8est_communication.h>
+#endif
+
+/***********************************************************
+* getLocalQuadIdx()
+*-----------------------------------------------------------
+* Returns the process-local index of the quadrant that is
+* passed to a p4est_iter_volume_t callback function
+***********************************************************/
+static p4est_locidx_t getLocalQuadIdx(p4est_iter_volume_info_t *info)
+{
+  p4est_tree_t *tree = p4est_tree_array_index(info->p4est->trees, 
+                                              info->treeid);
+
+  return info->quadid + tree->quadrants_offset;
+
+} /* getLocalQuadIdx() */
+
+/***********************************************************
+* packPartData()
+*-----------------------------------------------------------
+* Copies the persistent data of a quadrant into the 
+* partition send buffer
+*   -> p4est_iter_volume_t callback function
+***********************************************************/
+void packPartData(p4est_iter_volume_info_t *info,
+                  void *user_data)
+{
+  QuadData_t *quadData = (QuadData_t *) info->quad->p.user_data;
+  PartData_t *partData = (PartData_t *) user_data;
+
+  partData += getLocalQuadIdx(info);
+
+  int i;
+
+  for (i = 0; i < 2*P4EST_DIM; i++)
+    partData->mflux[i] = quadData->mflux[i];
+
+  for (i = OCT_SOLVER_VARS; i < OCT_MAX_VARS; i++)
+    partData->vars[i-OCT_SOLVER_VARS] = quadData->vars[i];
+
+  partData->adaptAge = quadData->adaptAge;
+
+} /* packPartData() */
+
+/***********************************************************
+* unpackPartData()
+*-----------------------------------------------------------
+* Rebuilds the geometry of a quadrant and copies its 
+* persistent data from the partition receive buffer
+*   -> p4est_iter_volume_t callback function
+***********************************************************/
+void unpackPartData(p4est_iter_volume_info_t *info,
+                    void *user_data)
+{
+  QuadData_t *quadData = (QuadData_t *) info->quad->p.user_data;
+  PartData_t *partData = (PartData_t *) user_data;
+
+  partData += getLocalQuadIdx(info);
+
+#ifdef P4_TO_P8
+  init_quadGeomData3d(info->p4est, info->treeid, 
+                      info->quad, quadData);
+#else
+  init_quadGeomData2d(info->p4est, info->treeid, 
+                      info->quad, quadData);
+#endif
+
+  init_quadFlowData(quadData);
+
+  int i;
+
+  for (i = 0; i < 2*P4EST_DIM; i++)
+    quadData->mflux[i] = partData->mflux[i];
+
+  for (i = OCT_SOLVER_VARS; i < OCT_MAX_VARS; i++)
+    quadData->vars[i] = partData->vars[i-OCT_SOLVER_VARS];
+
+  quadData->adaptAge = partData->adaptAge;
+
+} /* unpackPartData() */
+
+/***********************************************************
+* partitionGrid()
+*-----------------------------------------------------------
+* Repartitions the grid among all processes. 
+* The new partition is computed for a copy of the forest 
+* without quadrant data. If no quadrant is moved, the 
+* forest is kept as it is. Otherwise, only the persistent 
+* quad data (PartData_t) is sent, the copy replaces the 
+* forest (simData->p4est) and geometry, gradients and the
+* ghost layer are recomputed afterwards.
+*
+* Returns the global number of shipped quadrants.
+***********************************************************/
+p4est_gloidx_t partitionGrid(SimData_t *simData)
+{
+  p4est_t       *p4est       = simData->p4est;
+  SolverParam_t *solverParam = simData->solverParam;
+
+  /*--------------------------------------------------------
+  | Partition a copy of the bare forest without quadrant 
+  | data -> the forest and its data remain untouched, if 
+  | no quadrant is moved
+  --------------------------------------------------------*/
+  p4est_t *p4est_new = p4est_copy(p4est, 0);
+
+  p4est_gloidx_t nShipped = 
+    p4est_partition_ext(p4est_new, solverParam->partForCoarsen, NULL);
+
+  if (nShipped == 0)
+  {
+    p4est_destroy(p4est_new);
+    return 0;
+  }
+
+  /*--------------------------------------------------------
+  | Pack persistent data 
+  --------------------------------------------------------*/
+  PartData_t *sendData = P4EST_ALLOC(PartData_t, 
+                                     p4est->local_num_quadrants);
+
+  p4est_iterate(p4est, NULL, (void *) sendData,
+                packPartData,   // cell callback
+                NULL,           // face callback
+#ifdef P4_TO_P8
+                NULL,           // edge callback
+#endif
+                NULL);          // corner callback
+
+  /*--------------------------------------------------------
+  | Send persistent data to new owners
+  --------------------------------------------------------*/
+  PartData_t *recvData = P4EST_ALLOC(PartData_t, 
+                                     p4est_new->local_num_quadrants);
+
+  p4est_transfer_fixed(p4est_new->global_first_quadrant, 
+                       p4est->global_first_quadrant,
+                       p4est->mpicomm, 
+                       P4EST_COMM_TRANSFER,
+                       recvData, 
+                       sendData, 
+                       sizeof(PartData_t));
+
+  P4EST_FREE(sendData);
+
+  /*--------------------------------------------------------
+  | Replace the forest by the partitioned copy
+  --------------------------------------------------------*/
+  destroy_ghostData(simData);
+  p4est_destroy(p4est);
+
+  p4est_reset_data(p4est_new, sizeof(QuadData_t), NULL, 
+                   (void *) simData);
+
+  simData->p4est = p4est_new;
+  simData->meshRevision += 1;
+
+  /*--------------------------------------------------------
+  | Rebuild geometry and unpack persistent data
+  --------------------------------------------------------*/
+  p4est_iterate(p4est_new, NULL, (void *) recvData,
+                unpackPartData, // cell callback
+                NULL,           // face callback
+#ifdef P4_TO_P8
+                NULL,           // edge callback
+#endif
+                NULL);          // corner callback
+
+  P4EST_FREE(recvData);
+
+  /*--------------------------------------------------------
+  | Rebuild ghost layer 
+  --------------------------------------------------------*/
+  init_ghostData(simData);
+
+  /*--------------------------------------------------------
+  | Recompute gradients of the state variables
+  --------------------------------------------------------*/
+  int idx;
+  for (idx = OCT_SOLVER_VARS; idx < OCT_MAX_VARS; idx++)
+    computeGradients(simData, idx); 
+
+  return nShipped;
+
+} /* partitionGrid() */
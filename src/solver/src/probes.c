@@ -0,0 +1,507 @@
+/*
+* This file is part of OctFS. 
+* OctFS is a finite-volume flow solver with adaptive
+* mesh refinement written in C, which is based on 
+* the p4est library.
+*
+* Copyright (C) 2020 Florian Setzwein 
+*
+* OctFS is free software; you can redistribute it and/or 
+* modify it under the terms of the GNU General Public 
+* License as published by the Free Software Foundation; 
+* either version 2 of the License, or (at your option) 
+* any later version.
+*
+* OctFS is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied 
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR 
+* PURPOSE.  See the GNU General Public License for more 
+* details.
+*
+* You should have received a copy of the GNU General 
+* Public License along with OctFS; if not, write to the 
+* Free Software Foundation, Inc., 51 Franklin Street, 
+* Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+#include <math.h>
+
+#include "solver/probes.h"
+#include "solver/typedefs.h"
+#include "solver/util.h"
+#include "solver/quadData.h"
+#include "solver/simData.h"
+#include "solver/dataIO.h"
+#include "solver/paramfile.h"
+#include "aux/dbg.h"
+
+#ifndef P4_TO_P8
+#include <p4est_bits.h>
+#include <p4est_extended.h>
+#include <p4est_search.h>
+#else
+#include <p8est_bits.h>
+#include <p8est_extended.h>
+#include <p8est_search.h>
+#endif
+
+#define OCT_PROBE_TOL 1.0E-12
+
+/***********************************************************
+* Indices and names of the variables that are sampled 
+* by the probes
+***********************************************************/
+static const int probeVars[] = 
+{
+  IRHO, 
+  IVX, 
+  IVY, 
+#ifdef P4_TO_P8
+  IVZ, 
+#endif
+  IP, 
+  IS
+};
+
+static const char *probeNames[] =
+{
+  "density",
+  "x_velocity",
+  "y_velocity",
+#ifdef P4_TO_P8
+  "z_velocity",
+#endif
+  "pressure",
+  "passive_scalar"
+};
+
+#define OCT_PROBE_VARS ((int)(sizeof(probeVars)/sizeof(probeVars[0])))
+
+/***********************************************************
+* addProbePoint()
+*-----------------------------------------------------------
+* Appends a sample point to the probe set
+***********************************************************/
+static void addProbePoint(ProbeSet_t *probeSet,
+                          octDouble   x,
+                          octDouble   y,
+                          octDouble   z)
+{
+  ProbePoint_t *pt = (ProbePoint_t *) sc_array_push(probeSet->points);
+
+  pt->xyz[0]  = x;
+  pt->xyz[1]  = y;
+  pt->xyz[2]  = z;
+  pt->tree    = -1;
+  pt->quadIdx = -1;
+
+} /* addProbePoint() */
+
+/***********************************************************
+* readProbes()
+*-----------------------------------------------------------
+* Reads all probes of a given type from the parameter file.
+* Every line containing the instruction <fltr> defines 
+* one probe with <nvals> comma separated values.
+***********************************************************/
+static void readProbes(ProbeSet_t *probeSet,
+                       octParam   *paramFile,
+                       const char *fltr,
+                       ProbeType   type,
+                       int         nvals)
+{
+  struct bstrList *lines = octParam_getLinesWith(paramFile->txtlist,
+                                                 fltr);
+  octDouble v[11];
+  int i, j, k;
+
+  for (i = 0; i < lines->qty; i++)
+  {
+    bstring line = lines->entry[i];
+
+    if (octParam_readValues(line, fltr, v, nvals) < nvals)
+    {
+      octPrint("[WARNING]: Probe definition requires %d values:", 
+          nvals);
+      octPrint("%s", (char *) line->data);
+      continue;
+    }
+
+    if (probeSet->nProbes >= OCT_MAX_PROBES)
+    {
+      octPrint("[WARNING]: Maximum number of probes (%d) exceeded", 
+          OCT_MAX_PROBES);
+      break;
+    }
+
+    /*------------------------------------------------------
+    | Resolve probe into sample points
+    ------------------------------------------------------*/
+    Probe_t *probe = &probeSet->probes[probeSet->nProbes];
+
+    probe->type  = type;
+    probe->first = probeSet->points->elem_count;
+    probe->fptr  = NULL;
+
+    if (type == PROBE_POINT)
+    {
+      addProbePoint(probeSet, v[0], v[1], v[2]);
+    }
+    else if (type == PROBE_LINE)
+    {
+      int nl = MAX(2, (int) v[6]);
+
+      for (j = 0; j < nl; j++)
+      {
+        octDouble s = (octDouble) j / (octDouble) (nl-1);
+        addProbePoint(probeSet, 
+                      v[0] + s * (v[3] - v[0]),
+                      v[1] + s * (v[4] - v[1]),
+                      v[2] + s * (v[5] - v[2]));
+      }
+    }
+    else if (type == PROBE_PLANE)
+    {
+      int nu = MAX(2, (int) v[9]);
+      int nv = MAX(2, (int) v[10]);
+
+      for (k = 0; k < nv; k++)
+      {
+        octDouble t = (octDouble) k / (octDouble) (nv-1);
+
+        for (j = 0; j < nu; j++)
+        {
+          octDouble s = (octDouble) j / (octDouble) (nu-1);
+          addProbePoint(probeSet, 
+                        v[0] + s * v[3] + t * v[6],
+                        v[1] + s * v[4] + t * v[7],
+                        v[2] + s * v[5] + t * v[8]);
+        }
+      }
+    }
+
+    probe->nPoints = probeSet->points->elem_count - probe->first;
+    probeSet->nProbes += 1;
+
+    octPrint("%s %d sample point(s)", fltr, probe->nPoints);
+  }
+
+  bstrListDestroy(lines);
+
+} /* readProbes() */
+
+/***********************************************************
+* init_probes()
+*-----------------------------------------------------------
+* Reads all probe definitions from the parameter file.
+* Returns NULL if no probes are defined.
+***********************************************************/
+ProbeSet_t *init_probes(octParam *paramFile)
+{
+  ProbeSet_t *probeSet = malloc(sizeof(ProbeSet_t));
+
+  probeSet->nProbes   = 0;
+  probeSet->points    = sc_array_new(sizeof(ProbePoint_t));
+  probeSet->revision  = -1;
+  probeSet->period    = 1;
+  probeSet->sampleBuf = NULL;
+  probeSet->sumBuf    = NULL;
+
+  readProbes(probeSet, paramFile, "Probe point:", PROBE_POINT, 3);
+  readProbes(probeSet, paramFile, "Probe line:",  PROBE_LINE,  7);
+  readProbes(probeSet, paramFile, "Probe plane:", PROBE_PLANE, 11);
+
+  if (probeSet->nProbes < 1)
+  {
+    destroy_probes(probeSet);
+    return NULL;
+  }
+
+  if (octParam_extractParam(paramFile->txtlist, "Probe period:",
+                            INTVAL, &probeSet->period) > 0)
+    octPrint("Probe period: %d", probeSet->period);
+
+  /*--------------------------------------------------------
+  | Sample buffers: values and number of hits per point
+  --------------------------------------------------------*/
+  size_t nBuf = probeSet->points->elem_count * (OCT_PROBE_VARS + 1);
+
+  probeSet->sampleBuf = malloc(nBuf * sizeof(octDouble));
+  probeSet->sumBuf    = malloc(nBuf * sizeof(octDouble));
+
+  return probeSet;
+
+} /* init_probes() */
+
+/***********************************************************
+* destroy_probes()
+*-----------------------------------------------------------
+* Closes all probe files and frees the probe set
+***********************************************************/
+void destroy_probes(ProbeSet_t *probeSet)
+{
+  int i;
+
+  for (i = 0; i < probeSet->nProbes; i++)
+    if (probeSet->probes[i].fptr != NULL)
+      fclose(probeSet->probes[i].fptr);
+
+  sc_array_destroy(probeSet->points);
+
+  if (probeSet->sampleBuf != NULL)
+    free(probeSet->sampleBuf);
+  if (probeSet->sumBuf != NULL)
+    free(probeSet->sumBuf);
+
+  free(probeSet);
+
+} /* destroy_probes() */
+
+/***********************************************************
+* searchProbePoint()
+*-----------------------------------------------------------
+* Checks if a sample point lies within a quadrant and 
+* stores the quadrant, if it is a local leaf.
+*   -> p4est_search_local_t callback function
+***********************************************************/
+int searchProbePoint(p4est_t          *p4est,
+                     p4est_topidx_t    which_tree,
+                     p4est_quadrant_t *q,
+                     p4est_locidx_t    local_num,
+                     void             *point)
+{
+  ProbePoint_t  *pt  = (ProbePoint_t *) point;
+  p4est_qcoord_t len = P4EST_QUADRANT_LEN(q->level);
+
+  octDouble lo[3], hi[3];
+  int i;
+
+  /*--------------------------------------------------------
+  | Bounding box of the quadrant
+  --------------------------------------------------------*/
+#ifdef P4_TO_P8
+  p4est_qcoord_to_vertex(p4est->connectivity, which_tree,
+                         q->x, q->y, q->z, lo);
+  p4est_qcoord_to_vertex(p4est->connectivity, which_tree,
+                         q->x+len, q->y+len, q->z+len, hi);
+#else
+  p4est_qcoord_to_vertex(p4est->connectivity, which_tree,
+                         q->x, q->y, lo);
+  p4est_qcoord_to_vertex(p4est->connectivity, which_tree,
+                         q->x+len, q->y+len, hi);
+#endif
+
+  for (i = 0; i < P4EST_DIM; i++)
+  {
+    if (  pt->xyz[i] < MIN(lo[i], hi[i]) - OCT_PROBE_TOL
+       || pt->xyz[i] > MAX(lo[i], hi[i]) + OCT_PROBE_TOL )
+      return 0;
+  }
+
+  /*--------------------------------------------------------
+  | Leaf quadrant -> first hit owns the point
+  --------------------------------------------------------*/
+  if (local_num >= 0 && pt->quadIdx < 0)
+  {
+    pt->tree    = which_tree;
+    pt->quadIdx = local_num;
+  }
+
+  return 1;
+
+} /* searchProbePoint() */
+
+/***********************************************************
+* locateProbes()
+*-----------------------------------------------------------
+* Locates the quadrants of all sample points.
+* This is only done, if the mesh has changed since the 
+* last call (simData->meshRevision, the p4est revision is
+* reset, if the forest is replaced on repartitioning).
+***********************************************************/
+void locateProbes(SimData_t *simData)
+{
+  ProbeSet_t *probeSet = simData->probes;
+  p4est_t    *p4est    = simData->p4est;
+
+  if (probeSet->revision == simData->meshRevision)
+    return;
+
+  size_t i;
+
+  for (i = 0; i < probeSet->points->elem_count; i++)
+  {
+    ProbePoint_t *pt = (ProbePoint_t *) 
+                         sc_array_index(probeSet->points, i);
+    pt->tree    = -1;
+    pt->quadIdx = -1;
+  }
+
+  p4est_search_local(p4est, 0, NULL, searchProbePoint, 
+                     probeSet->points);
+
+  probeSet->revision = simData->meshRevision;
+
+} /* locateProbes() */
+
+/***********************************************************
+* openProbeFile()
+*-----------------------------------------------------------
+* Opens the time-series file of a probe and writes its 
+* header. Files are appended on a restart.
+***********************************************************/
+static void openProbeFile(SimData_t *simData, int iProbe)
+{
+  SolverParam_t *solverParam = simData->solverParam;
+  ProbeSet_t    *probeSet    = simData->probes;
+  Probe_t       *probe       = &probeSet->probes[iProbe];
+
+  char filename[BUFSIZ] = "";
+  int  i;
+
+  char *filePrefix = concat_string(solverParam->io_exportDir,
+                                   solverParam->io_exportPrefix);
+  snprintf(filename, BUFSIZ, "%s_probe_%02d.dat", filePrefix, iProbe);
+  free(filePrefix);
+
+  if (simData->simParam->step > 0)
+  {
+    probe->fptr = fopen(filename, "a");
+    check(probe->fptr, "Failed to open %s.", filename);
+    return;
+  }
+
+  probe->fptr = fopen(filename, "w");
+  check(probe->fptr, "Failed to open %s.", filename);
+
+  fprintf(probe->fptr, "# OctFS probe %d: %d sample point(s)\n", 
+      iProbe, probe->nPoints);
+
+  for (i = 0; i < probe->nPoints; i++)
+  {
+    ProbePoint_t *pt = (ProbePoint_t *) 
+      sc_array_index(probeSet->points, probe->first + i);
+    fprintf(probe->fptr, "# point %d: %e %e %e\n", 
+        i, pt->xyz[0], pt->xyz[1], pt->xyz[2]);
+  }
+
+  fprintf(probe->fptr, "# columns: step, time");
+  for (i = 0; i < OCT_PROBE_VARS; i++)
+    fprintf(probe->fptr, ", %s", probeNames[i]);
+  fprintf(probe->fptr, " (for every point)\n");
+
+  return;
+
+error:
+  probe->fptr = NULL;
+
+} /* openProbeFile() */
+
+/***********************************************************
+* sampleProbes()
+*-----------------------------------------------------------
+* Interpolates the flow variables at all sample points,
+* reduces them to the first process and appends them to 
+* the probe files
+***********************************************************/
+void sampleProbes(SimData_t *simData, int step)
+{
+  ProbeSet_t *probeSet = simData->probes;
+  p4est_t    *p4est    = simData->p4est;
+
+  if (probeSet->period < 1 || (step % probeSet->period))
+    return;
+
+  locateProbes(simData);
+
+  const int stride  = OCT_PROBE_VARS + 1;
+  size_t    nPoints = probeSet->points->elem_count;
+  size_t    i;
+  int       j, d;
+
+  /*--------------------------------------------------------
+  | Interpolate variables at all local sample points
+  | using the cell gradients
+  --------------------------------------------------------*/
+  for (i = 0; i < nPoints * stride; i++)
+    probeSet->sampleBuf[i] = 0.0;
+
+  for (i = 0; i < nPoints; i++)
+  {
+    ProbePoint_t *pt = (ProbePoint_t *) 
+                         sc_array_index(probeSet->points, i);
+
+    if (pt->quadIdx < 0)
+      continue;
+
+    p4est_tree_t     *tree = p4est_tree_array_index(p4est->trees, 
+                                                    pt->tree);
+    p4est_quadrant_t *q    = p4est_quadrant_array_index(
+                               &tree->quadrants,
+                               pt->quadIdx - tree->quadrants_offset);
+    QuadData_t       *qDat = (QuadData_t *) q->p.user_data;
+
+    octDouble *buf = &probeSet->sampleBuf[i * stride];
+
+    for (j = 0; j < OCT_PROBE_VARS; j++)
+    {
+      int       xId = probeVars[j];
+      octDouble val = qDat->vars[xId];
+
+      for (d = 0; d < P4EST_DIM; d++)
+        val += qDat->grad_vars[xId][d] 
+             * (pt->xyz[d] - qDat->centroid[d]);
+
+      buf[j] = val;
+    }
+
+    buf[OCT_PROBE_VARS] = 1.0;
+  }
+
+  /*--------------------------------------------------------
+  | Reduce to first process. Points on process boundaries
+  | are averaged over all processes that found them.
+  --------------------------------------------------------*/
+  sc_MPI_Reduce(probeSet->sampleBuf,
+                probeSet->sumBuf,
+                nPoints * stride,
+                sc_MPI_DOUBLE,
+                sc_MPI_SUM,
+                0,
+                simData->mpiParam->mpiComm);
+
+  if (p4est->mpirank != 0)
+    return;
+
+  /*--------------------------------------------------------
+  | Append samples to the probe files
+  --------------------------------------------------------*/
+  int iProbe;
+
+  for (iProbe = 0; iProbe < probeSet->nProbes; iProbe++)
+  {
+    Probe_t *probe = &probeSet->probes[iProbe];
+
+    if (probe->fptr == NULL)
+      openProbeFile(simData, iProbe);
+
+    if (probe->fptr == NULL)
+      continue;
+
+    fprintf(probe->fptr, "%8d %14.7e", 
+        step, simData->simParam->simTime);
+
+    for (i = probe->first; i < probe->first + probe->nPoints; i++)
+    {
+      octDouble *sum = &probeSet->sumBuf[i * stride];
+      octDouble  cnt = sum[OCT_PROBE_VARS];
+
+      for (j = 0; j < OCT_PROBE_VARS; j++)
+        fprintf(probe->fptr, " %14.7e", 
+            (cnt > 0.0) ? sum[j] / cnt : NAN);
+    }
+
+    fprintf(probe->fptr, "\n");
+    fflush(probe->fptr);
+  }
+
+} /* sampleProbes() */
@@ -32,6 +32,9 @@
 #include "solver/util.h"
 #include "solver/solveTranEq.h"
 #include "solver/massflux.h"
+#include "solver/timeIntegral.h"
+#include "solver/subcycling.h"
+#include "solver/blockSolver.h"
 #include "aux/dbg.h"
 
 #ifndef P4_TO_P8
@@ -52,13 +55,55 @@
 ***********************************************************/
 void doProjectionStep(SimData_t *simData)
 {
+  /*--------------------------------------------------------
+  | Refinement levels and level lists for local time 
+  | stepping -> only rebuilt after mesh changes
+  --------------------------------------------------------*/
+  if (simData->simParam->subcycling == TRUE)
+    update_subcycleLists(simData);
+
   /*--------------------------------------------------------
   | Initialize massfluxes
   --------------------------------------------------------*/
   initMassfluxes(simData);
 
+  /*--------------------------------------------------------
+  | Global CFL rates and solver costs
+  --------------------------------------------------------*/
+  if (  simData->simParam->adaptTimestep == TRUE
+     || simData->simParam->autoScheme    == TRUE )
+    exchangeCourantRate(simData);
+
+  /*--------------------------------------------------------
+  | Choose explicit or implicit scheme for this step
+  | -> prior to the timestep, which depends on the scheme
+  --------------------------------------------------------*/
+  if (simData->simParam->autoScheme == TRUE)
+    chooseTempScheme(simData);
+
+  /*--------------------------------------------------------
+  | Adapt timestep to the current CFL number
+  --------------------------------------------------------*/
+  if (simData->simParam->adaptTimestep == TRUE)
+    adaptTimestep(simData);
+
   /*--------------------------------------------------------
   | Solve momentum equation
+  | -> all velocity components share the same operator
+  |    and are solved together
+  --------------------------------------------------------*/
+  if (simData->simParam->solveMomentum == TRUE)
+  {
+#ifdef P4_TO_P8
+    const int velIds[P4EST_DIM] = { IVX, IVY, IVZ };
+#else
+    const int velIds[P4EST_DIM] = { IVX, IVY };
+#endif
+    solveTranEqBlock(simData, velIds, P4EST_DIM);
+  }
+
+  /*--------------------------------------------------------
+  | Solve scalar transport equation
   --------------------------------------------------------*/
   solveTranEq(simData, IS);
 
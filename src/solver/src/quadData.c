@@ -25,6 +25,8 @@
 */
 #include "solver/simData.h"
 #include "solver/quadData.h"
+#include "solver/geometry.h"
+#include "solver/adapt.h"
 
 #ifndef P4_TO_P8
 #include <p4est_vtk.h>
@@ -59,6 +61,8 @@ void init_quadData(p4est_t *p4est,
 
   init_quadFlowData(quadData);
 
+  quadData->adaptAge = OCT_ADAPT_AGE_MAX;
+
   /*--------------------------------------------------------
   | Apply user-defined initialization function as 
   | initialization. Otherwise, interpolate solution
@@ -94,13 +98,256 @@ void init_quadFlowData(QuadData_t *quadData)
   for (i = 0; i < 2*P4EST_DIM; i++)
     quadData->mflux[i] = 0.0;
 
+  for (i = 0; i < OCT_MAX_VARS-OCT_SOLVER_VARS; i++)
+    quadData->prolongLim[i] = 0.0;
+
+  quadData->adaptFlag = ADAPT_UNSET;
+  quadData->adaptReach = -1.0;
+
 } /* init_quadFlowData() */
 
 
+#ifndef OCT_MAPPED_GEOMETRY
 /***********************************************************
 * init_quadGeomData()
 *-----------------------------------------------------------
-* Initializes the quad geometry data structure
+* Initializes the quad geometry data structure for 
+* axis-aligned trees. 
+* The centroid is computed from the quad coordinates and
+* the volume is taken from the per-level geometry table.
+* Face normals are evaluated on the fly by 
+* geom_faceNormal().
+***********************************************************/
+static void init_quadGeomData(p4est_t          *p4est,
+                              p4est_topidx_t    which_tree,
+                              p4est_quadrant_t *q, 
+                              QuadData_t       *quadData)
+{
+  SimData_t *simData = (SimData_t *) p4est->user_pointer;
+
+  geom_centroid(p4est, which_tree, q, quadData->centroid);
+
+  quadData->volume = simData->geomTable->volume[q->level];
+
+} /* init_quadGeomData() */
+
+#ifdef P4_TO_P8
+/***********************************************************
+* init_quadGeomData3d()
+*-----------------------------------------------------------
+* Initializes the 3D quad geometry data structure
+***********************************************************/
+void init_quadGeomData3d(p4est_t          *p4est,
+                         p4est_topidx_t    which_tree,
+                         p4est_quadrant_t *q, 
+                         QuadData_t       *quadData)
+{
+  init_quadGeomData(p4est, which_tree, q, quadData);
+
+} /* init_quadGeomData3d() */
+#else
+/***********************************************************
+* init_quadGeomData2d()
+*-----------------------------------------------------------
+* Initializes the 2D quad geometry data structure
+***********************************************************/
+void init_quadGeomData2d(p4est_t          *p4est,
+                         p4est_topidx_t    which_tree,
+                         p4est_quadrant_t *q, 
+                         QuadData_t       *quadData)
+{
+  init_quadGeomData(p4est, which_tree, q, quadData);
+
+} /* init_quadGeomData2d() */
+#endif
+
+#else /* OCT_MAPPED_GEOMETRY */
+
+#ifdef P4_TO_P8
+/***********************************************************
+* geomFromVertices3d()
+*-----------------------------------------------------------
+* Computes centroid, face normals, face centroids and 
+* volume of a 3D quad from its vertices.
+* Vertices are in z-order, face normals are computed from
+* the face diagonals and oriented outwards. 
+* The volume follows from the divergence theorem.
+***********************************************************/
+static void geomFromVertices3d(QuadData_t *quadData)
+{
+  /*--------------------------------------------------------
+  | Corners of every face in z-order (see p8est_face_corners)
+  --------------------------------------------------------*/
+  static const int faceCorners[6][4] = { {0, 2, 4, 6}, 
+                                         {1, 3, 5, 7}, 
+                                         {0, 1, 4, 5}, 
+                                         {2, 3, 6, 7}, 
+                                         {0, 1, 2, 3}, 
+                                         {4, 5, 6, 7} };
+
+  octDouble (*xyz)[3] = quadData->xyz;
+
+  int i, j, k;
+
+  /*--------------------------------------------------------
+  | Compute quadrant centroid
+  --------------------------------------------------------*/
+  for (j = 0; j < 3; j++)
+  {
+    quadData->centroid[j] = 0.0;
+
+    for (i = 0; i < 8; i++)
+      quadData->centroid[j] += 0.125 * xyz[i][j];
+  }
+
+  /*--------------------------------------------------------
+  | Compute face centroids, normals and volume
+  --------------------------------------------------------*/
+  quadData->volume = 0.0;
+
+  for (i = 0; i < 6; i++)
+  {
+    const octDouble *a = xyz[faceCorners[i][0]];
+    const octDouble *b = xyz[faceCorners[i][1]];
+    const octDouble *c = xyz[faceCorners[i][2]];
+    const octDouble *d = xyz[faceCorners[i][3]];
+
+    octDouble *fc = quadData->face_centroids[i];
+    octDouble *n  = quadData->normals[i];
+
+    octDouble d0[3], d1[3];
+    octDouble orient = 0.0;
+
+    for (j = 0; j < 3; j++)
+    {
+      fc[j] = 0.25 * (a[j] + b[j] + c[j] + d[j]);
+      d0[j] = d[j] - a[j];
+      d1[j] = c[j] - b[j];
+    }
+
+    n[0] = 0.5 * (d0[1] * d1[2] - d0[2] * d1[1]);
+    n[1] = 0.5 * (d0[2] * d1[0] - d0[0] * d1[2]);
+    n[2] = 0.5 * (d0[0] * d1[1] - d0[1] * d1[0]);
+
+    for (j = 0; j < 3; j++)
+      orient += n[j] * (fc[j] - quadData->centroid[j]);
+
+    if (orient < 0.0)
+    {
+      for (j = 0; j < 3; j++)
+        n[j] = -n[j];
+    }
+
+    for (k = 0; k < 3; k++)
+      quadData->volume += fc[k] * n[k] / 3.0;
+  }
+
+} /* geomFromVertices3d() */
+
+/***********************************************************
+* init_quadGeomData3d()
+*-----------------------------------------------------------
+* Initializes the 3D quad geometry data structure from
+* the quad vertices (mapped geometry).
+***********************************************************/
+void init_quadGeomData3d(p4est_t          *p4est,
+                         p4est_topidx_t    which_tree,
+                         p4est_quadrant_t *q, 
+                         QuadData_t       *quadData)
+{
+  p4est_qcoord_t length = P4EST_QUADRANT_LEN(q->level);
+
+  octDouble (*xyz)[3] = quadData->xyz;
+
+  int i;
+
+  /*--------------------------------------------------------
+  | Get 3D vertex coordinates 
+  --------------------------------------------------------*/
+  for (i = 0; i < 8; i++)
+  {
+    p4est_qcoord_to_vertex(p4est->connectivity,
+                           which_tree,
+                           q->x + ((i & 1) ? length : 0),
+                           q->y + ((i & 2) ? length : 0),
+                           q->z + ((i & 4) ? length : 0),
+                           xyz[i]);
+  }
+
+  geomFromVertices3d(quadData);
+
+} /* init_quadGeomData3d() */
+#else
+/***********************************************************
+* geomFromVertices2d()
+*-----------------------------------------------------------
+* Computes centroid, face normals, face centroids and 
+* area of a 2D quad from its vertices 
+* (see init_quadGeomData2d())
+***********************************************************/
+static void geomFromVertices2d(QuadData_t *quadData)
+{
+  octDouble (*xyz)[2] = quadData->xyz;
+
+  /*--------------------------------------------------------
+  | Compute quadrant area
+  --------------------------------------------------------*/
+  octDouble vol = ( xyz[0][0] * xyz[1][1]
+                  + xyz[1][0] * xyz[3][1]
+                  + xyz[3][0] * xyz[2][1]
+                  + xyz[2][0] * xyz[0][1] )
+                 -( xyz[0][1] * xyz[1][0]
+                  + xyz[1][1] * xyz[3][0]
+                  + xyz[3][1] * xyz[2][0]
+                  + xyz[2][1] * xyz[0][0] );
+  quadData->volume = 0.5 * vol;
+
+  /*--------------------------------------------------------
+  | Compute quadrant centroid
+  --------------------------------------------------------*/
+  quadData->centroid[0] = 0.25 * ( xyz[0][0] + xyz[1][0]
+                                 + xyz[2][0] + xyz[3][0] );
+  quadData->centroid[1] = 0.25 * ( xyz[0][1] + xyz[1][1]
+                                 + xyz[2][1] + xyz[3][1] );
+
+  /*--------------------------------------------------------
+  | Compute quadrant normals
+  --------------------------------------------------------*/
+  quadData->normals[0][0] = xyz[0][1] - xyz[2][1];
+  quadData->normals[0][1] = xyz[2][0] - xyz[0][0];
+
+  quadData->normals[1][0] = xyz[3][1] - xyz[1][1];
+  quadData->normals[1][1] = xyz[1][0] - xyz[3][0];
+
+  quadData->normals[2][0] = xyz[1][1] - xyz[0][1];
+  quadData->normals[2][1] = xyz[0][0] - xyz[1][0];
+
+  quadData->normals[3][0] = xyz[2][1] - xyz[3][1];
+  quadData->normals[3][1] = xyz[3][0] - xyz[2][0];
+
+  /*--------------------------------------------------------
+  | Compute quadrant normal centroids
+  --------------------------------------------------------*/
+  quadData->face_centroids[0][0] = 0.5*(xyz[0][0]+xyz[2][0]);
+  quadData->face_centroids[0][1] = 0.5*(xyz[0][1]+xyz[2][1]);
+
+  quadData->face_centroids[1][0] = 0.5*(xyz[3][0]+xyz[1][0]);
+  quadData->face_centroids[1][1] = 0.5*(xyz[3][1]+xyz[1][1]);
+
+  quadData->face_centroids[2][0] = 0.5*(xyz[1][0]+xyz[0][0]);
+  quadData->face_centroids[2][1] = 0.5*(xyz[1][1]+xyz[0][1]);
+
+  quadData->face_centroids[3][0] = 0.5*(xyz[2][0]+xyz[3][0]);
+  quadData->face_centroids[3][1] = 0.5*(xyz[2][1]+xyz[3][1]);
+
+
+} /* geomFromVertices2d() */
+
+/***********************************************************
+* init_quadGeomData2d()
+*-----------------------------------------------------------
+* Initializes the 2D quad geometry data structure from
+* the quad vertices (mapped geometry)
 *
 *                 n[3]
 *        V[2]<-------------V[3]
@@ -158,59 +405,177 @@ void init_quadGeomData2d(p4est_t          *p4est,
                          xyz[3]);
 
 
-  /*--------------------------------------------------------
-  | Compute quadrant area
-  --------------------------------------------------------*/
-  octDouble vol = ( xyz[0][0] * xyz[1][1]
-                  + xyz[1][0] * xyz[3][1]
-                  + xyz[3][0] * xyz[2][1]
-                  + xyz[2][0] * xyz[0][1] )
-                 -( xyz[0][1] * xyz[1][0]
-                  + xyz[1][1] * xyz[3][0]
-                  + xyz[3][1] * xyz[2][0]
-                  + xyz[2][1] * xyz[0][0] );
-  quadData->volume = 0.5 * vol;
+  geomFromVertices2d(quadData);
 
-  /*--------------------------------------------------------
-  | Compute quadrant centroid
-  --------------------------------------------------------*/
-  quadData->centroid[0] = 0.25 * ( xyz[0][0] + xyz[1][0]
-                                 + xyz[2][0] + xyz[3][0] );
-  quadData->centroid[1] = 0.25 * ( xyz[0][1] + xyz[1][1]
-                                 + xyz[2][1] + xyz[3][1] );
+} /* init_quadGeomData2d() */
+#endif
+
+#endif /* OCT_MAPPED_GEOMETRY */
+
+#ifndef OCT_MAPPED_GEOMETRY
+/***********************************************************
+* refineQuadGeom()
+*-----------------------------------------------------------
+* Initializes the geometry of the children of a refined 
+* quad from the geometry of the parent: 
+* The child centroids are shifted by half a child edge 
+* length from the parent centroid, the volume is taken 
+* from the per-level geometry table.
+***********************************************************/
+static void refineQuadGeom(SimData_t        *simData,
+                           QuadData_t       *parentData,
+                           p4est_quadrant_t *incoming[],
+                           QuadData_t       *childData[])
+{
+  const int        lvl = incoming[0]->level;
+  const octDouble *h   = simData->geomTable->h[lvl];
+  const octDouble *pxx = parentData->centroid;
+
+  int i, k;
+
+  for (i = 0; i < P4EST_CHILDREN; i++)
+  {
+    const int cid = p4est_quadrant_child_id(incoming[i]);
+
+    for (k = 0; k < P4EST_DIM; k++)
+      childData[i]->centroid[k] = pxx[k] 
+        + ( ((cid >> k) & 1) ? 0.5 : -0.5 ) * h[k];
+
+    childData[i]->volume = simData->geomTable->volume[lvl];
+  }
+
+} /* refineQuadGeom() */
+
+/***********************************************************
+* coarsenQuadGeom()
+*-----------------------------------------------------------
+* Initializes the geometry of a coarsened quad from the 
+* geometry of its children
+***********************************************************/
+static void coarsenQuadGeom(SimData_t        *simData,
+                            p4est_quadrant_t *parent,
+                            QuadData_t       *parentData,
+                            QuadData_t       *childData[])
+{
+  int i, k;
+
+  for (k = 0; k < P4EST_DIM; k++)
+  {
+    parentData->centroid[k] = 0.0;
+
+    for (i = 0; i < P4EST_CHILDREN; i++)
+      parentData->centroid[k] += childData[i]->centroid[k];
+
+    parentData->centroid[k] /= P4EST_CHILDREN;
+  }
+
+  parentData->volume = simData->geomTable->volume[parent->level];
+
+} /* coarsenQuadGeom() */
+
+#else /* OCT_MAPPED_GEOMETRY */
+
+#ifdef P4_TO_P8
+#define OCT_LATTICE_PTS 27
+#else
+#define OCT_LATTICE_PTS 9
+#endif
+
+/***********************************************************
+* refineQuadGeom()
+*-----------------------------------------------------------
+* Initializes the geometry of the children of a refined 
+* quad from the vertices of the parent. 
+* The vertices of a quad are a multilinear map of its 
+* tree coordinates, hence the child vertices follow 
+* exactly from a multilinear interpolation of the parent 
+* vertices at the 3^d lattice points (0, 1/2, 1).
+***********************************************************/
+static void refineQuadGeom(SimData_t        *simData,
+                           QuadData_t       *parentData,
+                           p4est_quadrant_t *incoming[],
+                           QuadData_t       *childData[])
+{
+  octDouble lattice[OCT_LATTICE_PTS][P4EST_DIM];
+
+  int i, j, k, d;
 
   /*--------------------------------------------------------
-  | Compute quadrant normals
+  | Lattice points (index a + 3*b + 9*c)
   --------------------------------------------------------*/
-  quadData->normals[0][0] = xyz[0][1] - xyz[2][1];
-  quadData->normals[0][1] = xyz[2][0] - xyz[0][0];
+  for (i = 0; i < OCT_LATTICE_PTS; i++)
+  {
+    int       idx[3] = { i % 3, (i / 3) % 3, i / 9 };
 
-  quadData->normals[1][0] = xyz[3][1] - xyz[1][1];
-  quadData->normals[1][1] = xyz[1][0] - xyz[3][0];
+    for (d = 0; d < P4EST_DIM; d++)
+      lattice[i][d] = 0.0;
 
-  quadData->normals[2][0] = xyz[1][1] - xyz[0][1];
-  quadData->normals[2][1] = xyz[0][0] - xyz[1][0];
+    for (j = 0; j < P4EST_CHILDREN; j++)
+    {
+      octDouble w = 1.0;
 
-  quadData->normals[3][0] = xyz[2][1] - xyz[3][1];
-  quadData->normals[3][1] = xyz[3][0] - xyz[2][0];
+      for (d = 0; d < P4EST_DIM; d++)
+        w *= ((j >> d) & 1) ? 0.5 * idx[d] : 1.0 - 0.5 * idx[d];
+
+      for (d = 0; d < P4EST_DIM; d++)
+        lattice[i][d] += w * parentData->xyz[j][d];
+    }
+  }
 
   /*--------------------------------------------------------
-  | Compute quadrant normal centroids
+  | Child vertices and geometry
   --------------------------------------------------------*/
-  quadData->face_centroids[0][0] = 0.5*(xyz[0][0]+xyz[2][0]);
-  quadData->face_centroids[0][1] = 0.5*(xyz[0][1]+xyz[2][1]);
+  for (i = 0; i < P4EST_CHILDREN; i++)
+  {
+    const int cid = p4est_quadrant_child_id(incoming[i]);
 
-  quadData->face_centroids[1][0] = 0.5*(xyz[3][0]+xyz[1][0]);
-  quadData->face_centroids[1][1] = 0.5*(xyz[3][1]+xyz[1][1]);
+    for (j = 0; j < P4EST_CHILDREN; j++)
+    {
+      int l = 0, f = 1;
 
-  quadData->face_centroids[2][0] = 0.5*(xyz[1][0]+xyz[0][0]);
-  quadData->face_centroids[2][1] = 0.5*(xyz[1][1]+xyz[0][1]);
+      for (d = 0; d < P4EST_DIM; d++, f *= 3)
+        l += f * ( ((cid >> d) & 1) + ((j >> d) & 1) );
 
-  quadData->face_centroids[3][0] = 0.5*(xyz[2][0]+xyz[3][0]);
-  quadData->face_centroids[3][1] = 0.5*(xyz[2][1]+xyz[3][1]);
+      for (k = 0; k < P4EST_DIM; k++)
+        childData[i]->xyz[j][k] = lattice[l][k];
+    }
 
+#ifdef P4_TO_P8
+    geomFromVertices3d(childData[i]);
+#else
+    geomFromVertices2d(childData[i]);
+#endif
+  }
 
-} /* init_quadGeomData() */
+} /* refineQuadGeom() */
+
+/***********************************************************
+* coarsenQuadGeom()
+*-----------------------------------------------------------
+* Initializes the geometry of a coarsened quad from the 
+* vertices of its children: Vertex i of the parent is 
+* vertex i of child i.
+***********************************************************/
+static void coarsenQuadGeom(SimData_t        *simData,
+                            p4est_quadrant_t *parent,
+                            QuadData_t       *parentData,
+                            QuadData_t       *childData[])
+{
+  int i, k;
+
+  for (i = 0; i < P4EST_CHILDREN; i++)
+    for (k = 0; k < P4EST_DIM; k++)
+      parentData->xyz[i][k] = childData[i]->xyz[i][k];
+
+#ifdef P4_TO_P8
+  geomFromVertices3d(parentData);
+#else
+  geomFromVertices2d(parentData);
+#endif
+
+} /* coarsenQuadGeom() */
+
+#endif /* OCT_MAPPED_GEOMETRY */
 
 /***********************************************************
 * interpQuadData()
@@ -226,10 +591,17 @@ void init_quadGeomData2d(p4est_t          *p4est,
 * before the outgoing data is destroyed.
 * This function matches the p4est_replace_t prototype.
 *
-* In this example, we linearly interpolate the state 
-* variable of a quadrant that is refined to its children
-* and we average the children midpoints that are being 
-* coarsened to the paren
+* The state of a coarsened family is restricted to the 
+* parent by a volume-weighted average. The state of a 
+* refined quad is prolongated linearly to its children 
+* with the gradient, that has been limited by 
+* prolongLim (see limitProlongation()). The children 
+* inherit the limited gradient, such that grandchildren 
+* of a recursive refinement are bounded as well. 
+* Quads, that are refined after coarsening within the 
+* same adaptation, are prolongated without gradient.
+* Both operators conserve the volume integral of the 
+* state.
 *-----------------------------------------------------------
 * Arguments:
 * *p4est        : the forest
@@ -256,7 +628,17 @@ void interpQuadData(p4est_t          *p4est,
                     int               num_incoming, 
                     p4est_quadrant_t *incoming[])
 {
-  QuadData_t *parentData, *childData;
+  SimData_t  *simData = (SimData_t *) p4est->user_pointer;
+  QuadData_t *parentData;
+  QuadData_t *childData[P4EST_CHILDREN];
+
+  int i, j, k;
+
+  /*--------------------------------------------------------
+  | Count changed quadrants -> ghost layer is only rebuilt
+  | if the grid has been modified
+  --------------------------------------------------------*/
+  simData->nAdaptedQuads += num_incoming;
 
   /*--------------------------------------------------------
   | Coarsening -> Initialize new coarser quad from its
@@ -264,51 +646,63 @@ void interpQuadData(p4est_t          *p4est,
   --------------------------------------------------------*/
   if (num_outgoing > 1)
   {
-    int i, j, k;
-
     parentData = (QuadData_t *) incoming[0]->p.user_data;
 
+    for (i = 0; i < P4EST_CHILDREN; i++) 
+      childData[i] = (QuadData_t *) outgoing[i]->p.user_data;
+
     /*------------------------------------------------------
     | Init geometry and flow data for new quad
     ------------------------------------------------------*/
-#ifdef P4_TO_P8
-    init_quadGeomData3d(p4est, which_tree, 
-                        incoming[0], parentData);
-#else
-    init_quadGeomData2d(p4est, which_tree, 
-                        incoming[0], parentData);
-#endif
+    coarsenQuadGeom(simData, incoming[0], parentData, childData);
 
     init_quadFlowData(parentData);
 
+    parentData->adaptAge = 0;
+
     /*------------------------------------------------------
-    | Interpolate data from children
+    | No limiter is known for the averaged gradient 
+    | -> piecewise constant prolongation by the balance
     ------------------------------------------------------*/
+    for (j = 0; j < OCT_MAX_VARS-OCT_SOLVER_VARS; j++)
+      parentData->prolongLim[j] = 0.0;
+
+    /*------------------------------------------------------
+    | Volume-weighted restriction of the children data
+    | -> V_p * v_p = sum_i V_i * v_i
+    ------------------------------------------------------*/
+    octDouble volSum = 0.0;
+
     for (i = 0; i < P4EST_CHILDREN; i++) 
     {
-      childData = (QuadData_t *) outgoing[i]->p.user_data;
+      const octDouble vol = childData[i]->volume;
+
+      parentData->adaptAge = MAX(parentData->adaptAge, 
+                                 childData[i]->adaptAge);
+
+      volSum += vol;
 
       for (j = OCT_SOLVER_VARS; j < OCT_MAX_VARS; j++)
       {
-        parentData->vars[j] += childData->vars[j];
+        parentData->vars[j] += vol * childData[i]->vars[j];
 
         for (k = 0; k < P4EST_DIM; k++)
         {
-          parentData->grad_vars[j][k] += childData->grad_vars[j][k];
+          parentData->grad_vars[j][k] += vol * childData[i]->grad_vars[j][k];
         }
       }
     }
 
     /*------------------------------------------------------
-    | Normalize with number of children
+    | Normalize with volume 
     ------------------------------------------------------*/
     for (j = OCT_SOLVER_VARS; j < OCT_MAX_VARS; j++)
     {
-      parentData->vars[j] /= P4EST_CHILDREN;
+      parentData->vars[j] /= parentData->volume;
 
       for (k = 0; k < P4EST_DIM; k++)
       {
-        parentData->grad_vars[j][k] /= P4EST_CHILDREN;
+        parentData->grad_vars[j][k] /= volSum;
       }
     }
 
@@ -316,53 +710,87 @@ void interpQuadData(p4est_t          *p4est,
   /*--------------------------------------------------------
   | Refinement -> Initialize new finer quads from their 
   |               parent
+  |               The solver buffers (vars[0 .. 
+  |               OCT_SOLVER_VARS-1]) are not cleared: 
+  |               every solver writes a buffer of all quads
+  |               before it is read or its gradient is 
+  |               computed (gradients of the state 
+  |               variables only in solverRun(), 
+  |               init_simData() and partitionGrid()).
   --------------------------------------------------------*/
   else
   {
     parentData = (QuadData_t *) outgoing[0]->p.user_data;
 
-    // Quad centroids
-    octDouble *pxx = parentData->centroid;
+    for (i = 0; i < P4EST_CHILDREN; i++) 
+      childData[i] = (QuadData_t *) incoming[i]->p.user_data;
+
+    /*------------------------------------------------------
+    | Init geometry of all children from the parent
+    ------------------------------------------------------*/
+    refineQuadGeom(simData, parentData, incoming, childData);
 
-    int i, j, k;
+    /*------------------------------------------------------
+    | Interpolate flow field data with the limited gradient
+    | -> The children carry the limited gradient, i.e. 
+    |    the unlimited gradient and the parent limiter
+    ------------------------------------------------------*/
+    const octDouble *pxx = parentData->centroid;
 
     for (i = 0; i < P4EST_CHILDREN; i++)
     {
-      childData = (QuadData_t *) incoming[i]->p.user_data;
+      QuadData_t      *cData = childData[i];
+      const octDouble *cxx   = cData->centroid;
 
-      /*----------------------------------------------------
-      | Init geometry and flow data for new quad
-      ----------------------------------------------------*/
-#ifdef P4_TO_P8
-      init_quadGeomData3d(p4est, which_tree, 
-                          incoming[i], childData);
-#else
-      init_quadGeomData2d(p4est, which_tree, 
-                          incoming[i], childData);
-#endif
+      octDouble dx[P4EST_DIM];
+
+      for (k = 0; k < P4EST_DIM; k++)
+        dx[k] = cxx[k] - pxx[k];
 
-      init_quadFlowData(childData);
+      for (k = 0; k < 2*P4EST_DIM; k++)
+        cData->mflux[k] = 0.0;
 
-      /*----------------------------------------------------
-      | Inpterpolate flow field data
-      ----------------------------------------------------*/
       for (j = OCT_SOLVER_VARS; j < OCT_MAX_VARS; j++)
       {
-        childData->vars[j] = parentData->vars[j];
-      }
+        const octDouble phi = parentData->prolongLim[j-OCT_SOLVER_VARS];
 
-      octDouble *cxx = childData->centroid;
+        octDouble var = parentData->vars[j];
 
-      for (k = 0; k < P4EST_DIM; k++)
-      {
-        const octDouble  dx = cxx[k] - pxx[k];
-
-        for (j = OCT_SOLVER_VARS; j < OCT_MAX_VARS; j++)
+        for (k = 0; k < P4EST_DIM; k++)
         {
-          childData->vars[j] += dx * parentData->grad_vars[j][k];
-          childData->grad_vars[j][k] = parentData->grad_vars[j][k];
+          var += phi * dx[k] * parentData->grad_vars[j][k];
+          cData->grad_vars[j][k] = parentData->grad_vars[j][k];
         }
+
+        cData->vars[j] = var;
+        cData->prolongLim[j-OCT_SOLVER_VARS] = phi;
       }
+
+      cData->adaptFlag  = ADAPT_UNSET;
+      cData->adaptReach = -1.0;
+      cData->adaptAge   = 0;
+    }
+
+    /*------------------------------------------------------
+    | Correct the children state, such that 
+    |   sum_i V_i * v_i = V_p * v_p 
+    | holds exactly (the gradient terms only cancel for 
+    | symmetric children geometries)
+    ------------------------------------------------------*/
+    octDouble volSum = 0.0;
+
+    for (i = 0; i < P4EST_CHILDREN; i++)
+      volSum += childData[i]->volume;
+
+    for (j = OCT_SOLVER_VARS; j < OCT_MAX_VARS; j++)
+    {
+      octDouble dMass = parentData->volume * parentData->vars[j];
+
+      for (i = 0; i < P4EST_CHILDREN; i++)
+        dMass -= childData[i]->volume * childData[i]->vars[j];
+
+      for (i = 0; i < P4EST_CHILDREN; i++)
+        childData[i]->vars[j] += dMass / volSum;
     }
   }
 
@@ -28,6 +28,8 @@
 #include "solver/coarsen.h"
 #include "solver/quadData.h"
 #include "solver/simData.h"
+#include "solver/adapt.h"
+#include "solver/zones.h"
 
 /***********************************************************
 * calcSqrErr()
@@ -107,6 +109,12 @@ int refinement_scalarError(p4est_t          *p4est,
 *-----------------------------------------------------------
 * This is the general function to control the refinement
 * of trees.
+* The flag of the indicator pass computeAdaptFlags() is
+* used if available. Otherwise, the refinement criteria 
+* are evaluated directly with the refinement threshold of
+* the last indicator pass (simData->refThresh), as long 
+* as the refinement budget (simData->refineBudget) of 
+* this process is not exhausted.
 ***********************************************************/
 int globalRefinement(p4est_t          *p4est,
                      p4est_topidx_t    which_tree,
@@ -114,16 +122,29 @@ int globalRefinement(p4est_t          *p4est,
 {
   SimData_t  *simData  = (SimData_t*) p4est->user_pointer;
   SimParam_t *simParam = simData->simParam;
+  QuadData_t *quadData = (QuadData_t *) q->p.user_data;
+
+  if (quadData->adaptFlag != ADAPT_UNSET)
+    return (quadData->adaptFlag == ADAPT_REFINE);
+
+  if (simData->refineBudget == 0)
+    return 0;
 
   int refine = 0;
 
-  refine |= refinement_scalarError(p4est, which_tree, q);
+  refine |= ( adaptIndicator(simData->solverParam, q) 
+            > simData->refThresh );
+
+  refine |= (zoneRefineLevel(p4est, which_tree, q) > q->level);
 
   if (simParam->usrRefineFun != NULL)
   {
     refine |= simParam->usrRefineFun(p4est, which_tree, q);
   }
 
+  if (refine && simData->refineBudget > 0)
+    simData->refineBudget -= 1;
+
   return refine;
 
 } /* globalRefinement() */
@@ -25,10 +25,18 @@
 */
 #include "solver/simData.h"
 #include "solver/quadData.h"
+#include "solver/geometry.h"
 #include "solver/refine.h"
 #include "solver/coarsen.h"
 #include "solver/gradients.h"
+#include "solver/massflux.h"
+#include "solver/fluxConvection.h"
 #include "solver/paramfile.h"
+#include "solver/checkpoint.h"
+#include "solver/dataIO.h"
+#include "solver/probes.h"
+#include "solver/zones.h"
+#include "solver/subcycling.h"
 #include "aux/dbg.h"
 
 #ifndef P4_TO_P8
@@ -44,6 +52,66 @@
 #endif
 
 
+/***********************************************************
+* init_connectivity()
+*-----------------------------------------------------------
+* Creates the mesh connectivity:
+*   - from an Abaqus mesh file (solverParam->meshFile), 
+*     which requires OCT_MAPPED_GEOMETRY, since the trees
+*     are not axis-aligned in general
+*   - otherwise a brick of nTrees[0] x nTrees[1] (x 
+*     nTrees[2]) unit trees, which is periodic along the
+*     axes with periodic[i] == TRUE
+* Every tree is a root of the space-filling curve, such 
+* that the domain is partitioned at a finer granularity.
+***********************************************************/
+static p4est_connectivity_t *init_connectivity(
+                                SolverParam_t *solverParam)
+{
+  p4est_connectivity_t *conn = NULL;
+
+  if (  solverParam->meshFile != NULL 
+     && blength(solverParam->meshFile) > 0 )
+  {
+#ifndef OCT_MAPPED_GEOMETRY
+    check(FALSE, "Mesh files require OCT_MAPPED_GEOMETRY.");
+#endif
+
+#ifndef P4_TO_P8
+    conn = p4est_connectivity_read_inp(
+                          (char*) solverParam->meshFile->data);
+#else
+    conn = p8est_connectivity_read_inp(
+                          (char*) solverParam->meshFile->data);
+#endif
+    check(conn, "Failed to read mesh file %s.", 
+          (char*) solverParam->meshFile->data);
+  }
+  else
+  {
+    int *n = solverParam->nTrees;
+    int *p = solverParam->periodic;
+
+#ifndef P4_TO_P8
+    check(n[0] > 0 && n[1] > 0, 
+          "Invalid number of trees.");
+    conn = p4est_connectivity_new_brick(n[0], n[1], 
+                                        p[0], p[1]);
+#else
+    check(n[0] > 0 && n[1] > 0 && n[2] > 0, 
+          "Invalid number of trees.");
+    conn = p8est_connectivity_new_brick(n[0], n[1], n[2],
+                                        p[0], p[1], p[2]);
+#endif
+  }
+
+  return conn;
+
+error:
+  return NULL;
+
+} /* init_connectivity() */
+
 /***********************************************************
 * init_simData()
 *-----------------------------------------------------------
@@ -72,6 +140,20 @@ SimData_t *init_simData(int          argc,
   simData->mpiParam    = NULL;
   simData->conn        = NULL;
   simData->p4est       = NULL;
+  simData->geomTable   = NULL;
+  simData->writer      = NULL;
+  simData->probes      = NULL;
+  simData->zones       = NULL;
+  simData->subcycle    = NULL;
+  simData->ghost       = NULL;
+  simData->ghostData   = NULL;
+  simData->indicator   = NULL;
+
+  simData->nAdaptedQuads = 0;
+  simData->ghostConnect  = P4EST_CONNECT_FACE;
+  simData->refThresh     = 1.0;
+  simData->refineBudget  = -1;
+  simData->meshRevision  = 0;
 
   /*--------------------------------------------------------
   | Init parameter structures 
@@ -87,32 +169,62 @@ SimData_t *init_simData(int          argc,
   --------------------------------------------------------*/
   octParam_readParamfile(simData, paramFilePath);
 
-  /*--------------------------------------------------------
-  | Load p4est mesh connectivity
-  --------------------------------------------------------*/
-#ifndef P4_TO_P8
-  simData->conn = p4est_connectivity_new_periodic();
-#else
-  simData->conn = p8est_connectivity_new_periodic();
-#endif
-
-  /*--------------------------------------------------------
-  | create p4est structure
-  --------------------------------------------------------*/
   SolverParam_t *solverParam = simData->solverParam;
 
-  p4est_init(NULL, SC_LP_PRODUCTION);
+  octBool restart = (  solverParam->io_restartFile != NULL
+                    && blength(solverParam->io_restartFile) > 0 );
+
+  if (p4est_package_id < 0)
+    p4est_init(NULL, SC_LP_PRODUCTION);
+
   P4EST_GLOBAL_PRODUCTIONF(
       "\n\nOctFS - Octree based flow solver. Compiled for %dD.\n\n",
       P4EST_DIM);
-  simData->p4est = p4est_new_ext(simData->mpiParam->mpiComm,
-                                 simData->conn,
-                                 solverParam->nQuadMPU,
-                                 solverParam->minRefLvl,
-                                 solverParam->fillUniform,
-                                 sizeof(QuadData_t),
-                                 init_quadData,
-                                 (void *) (simData));
+
+  if (restart == TRUE)
+  {
+    /*------------------------------------------------------
+    | Load p4est structure and connectivity from checkpoint
+    ------------------------------------------------------*/
+    simData->p4est = loadCheckpoint(simData, 
+                       (char*) solverParam->io_restartFile->data,
+                       &simData->conn);
+    check(simData->p4est, "Failed to restart from checkpoint.");
+
+    simData->meshRevision += 1;
+  }
+  else
+  {
+    /*------------------------------------------------------
+    | Load p4est mesh connectivity
+    ------------------------------------------------------*/
+    simData->conn = init_connectivity(solverParam);
+    check(simData->conn, "Failed to create mesh connectivity.");
+
+    /*------------------------------------------------------
+    | create p4est structure
+    ------------------------------------------------------*/
+    simData->p4est = p4est_new_ext(simData->mpiParam->mpiComm,
+                                   simData->conn,
+                                   solverParam->nQuadMPU,
+                                   solverParam->minRefLvl,
+                                   solverParam->fillUniform,
+                                   sizeof(QuadData_t),
+                                   init_quadData,
+                                   (void *) (simData));
+  }
+
+  simData->geomTable = init_geomTable(simData->conn);
+
+  /*--------------------------------------------------------
+  | Init asynchronous snapshot writer
+  --------------------------------------------------------*/
+  if (  solverParam->io_async == TRUE 
+     && solverParam->io_format == OUTPUT_SNAPSHOT )
+  {
+    simData->writer = 
+      init_asyncWriter((long) (solverParam->io_bufferSize * 1.0E+06));
+  }
 
   /*--------------------------------------------------------
   | Estimate global mesh attributes
@@ -130,29 +242,44 @@ SimData_t *init_simData(int          argc,
   --------------------------------------------------------*/
   exchangeGlobMeshAttrib(simData);
 
+  /*--------------------------------------------------------
+  | Register stencils of all kernels that are evaluated
+  | on the ghost layer
+  --------------------------------------------------------*/
+  registerStencil(simData, GRADIENTS_STENCIL);
+  registerStencil(simData, MASSFLUX_STENCIL);
+  registerStencil(simData, FLUXCONV_STENCIL);
+
   /*--------------------------------------------------------
   | Init p4est ghost data structure
   --------------------------------------------------------*/
-  simData->ghost = p4est_ghost_new(simData->p4est, 
-                                   P4EST_CONNECT_FULL);
-  simData->ghostData = P4EST_ALLOC(QuadData_t, 
-                          simData->ghost->ghosts.elem_count);
-  p4est_ghost_exchange_data(simData->p4est, 
-                            simData->ghost, 
-                            simData->ghostData);
+  init_ghostData(simData);
 
   /*--------------------------------------------------------
-  | Initial calculation of gradients
+  | Initial calculation of gradients of the state 
+  | variables -> gradients of the solver buffers are 
+  |              computed by the solvers when needed
   --------------------------------------------------------*/
   int idx;
-  for (idx = 0; idx < OCT_MAX_VARS; idx++)
+  for (idx = OCT_SOLVER_VARS; idx < OCT_MAX_VARS; idx++)
     computeGradients(simData, idx); 
 
-  if (solverParam->adaptGrid == TRUE)
+  if (solverParam->adaptGrid == TRUE && restart == FALSE)
   {
     /*------------------------------------------------------
     | Initial refinement 
+    | -> limited by the maximum number of quads
     ------------------------------------------------------*/
+    if (solverParam->quadMax > 0)
+    {
+      long nFree = (long) solverParam->quadMax 
+                 - (long) simData->p4est->global_num_quadrants;
+
+      simData->refineBudget = (p4est_locidx_t) 
+        ( MAX(0, nFree) / (P4EST_CHILDREN - 1) 
+                        / simData->p4est->mpisize );
+    }
+
     p4est_refine(simData->p4est,
                  solverParam->recursive,
                  globalRefinement,
@@ -167,21 +294,15 @@ SimData_t *init_simData(int          argc,
                   P4EST_CONNECT_FACE,
                   init_quadData);
 
-    p4est_ghost_destroy(simData->ghost);
-    P4EST_FREE(simData->ghostData);
-    simData->ghost = NULL;
-    simData->ghostData = NULL;
+    destroy_ghostData(simData);
+
+    simData->meshRevision += 1;
   }
 
-  simData->ghost = p4est_ghost_new(simData->p4est, 
-                                   P4EST_CONNECT_FULL);
-  simData->ghostData = P4EST_ALLOC(QuadData_t, 
-                          simData->ghost->ghosts.elem_count);
-  p4est_ghost_exchange_data(simData->p4est, 
-                            simData->ghost, 
-                            simData->ghostData);
+  if (!simData->ghost)
+    init_ghostData(simData);
 
-  for (idx = 0; idx < OCT_MAX_VARS; idx++)
+  for (idx = OCT_SOLVER_VARS; idx < OCT_MAX_VARS; idx++)
     computeGradients(simData, idx); 
 
   return simData;
@@ -200,21 +321,42 @@ SimParam_t *init_simParam(octInitFun   usrInitFun,
                           octRefineFun usrRefineFun,
                           octCoarseFun usrCoarseFun)
 {
-  int i;
-
   SimParam_t *simParam = malloc(sizeof(SimParam_t));
 
   simParam->volume_glob     = 0.0;
   simParam->volume_loc      = 0.0;
 
   simParam->timestep      = 5e-3;
+  simParam->adaptTimestep = FALSE;
+  simParam->cflTarget     = 1.0;
+  simParam->cflTargetExplicit = 0.5;
+  simParam->timestepMin   = 1.0E-08;
+  simParam->timestepMax   = 1.0;
+  simParam->courantRate   = 0.0;
+  simParam->courantRateSub = 0.0;
+  simParam->timeLanding   = 0.0;
+  simParam->subcycling    = FALSE;
+  simParam->solveMomentum = FALSE;
+  simParam->lvlMin        = 0;
+  simParam->lvlMax        = 0;
   simParam->simTimeTot    = 1.0; //1.0; //5e-3;
   simParam->simTime       = 0.0;
+  simParam->step          = 0;
 
   simParam->tempScheme     = CRANK_NICOLSON;
+  simParam->autoScheme         = FALSE;
+  simParam->autoSchemeExplicit = SSP_RK2;
+  simParam->autoSchemeImplicit = CRANK_NICOLSON;
+  simParam->nExplicitSteps     = 1;
+  simParam->avgKrylovIter      = 0.0;
+  simParam->timeFluxEval       = 0.0;
+  simParam->timeKrylovIter     = 0.0;
+
   simParam->tempFluxFac[0] = 0.0;
   simParam->tempFluxFac[1] = 1.0;
   simParam->tempFluxFac[2] = 0.5;
+  simParam->tempFluxFac[3] = 0.0;
+  simParam->tempFluxFac[4] = 0.0;
   
 
   simParam->viscosity     = 1e-5;
@@ -226,24 +368,35 @@ SimParam_t *init_simParam(octInitFun   usrInitFun,
   simParam->usrRefineFun = usrRefineFun;
   simParam->usrCoarseFun = usrCoarseFun;
 
-  /*--------------------------------------------------------
-  | Temporary values
-  --------------------------------------------------------*/
-  simParam->tmp_xId  = -1;
-  simParam->tmp_AxId = -1;
+  return simParam;
 
-  simParam->tmp_fluxFac = 0.0;
+} /* init_simParam() */
 
-  simParam->tmp_sbufVec0 = -1;
-  simParam->tmp_sbufVec1 = -1;
-  simParam->tmp_sbufProd = -1;
+/***********************************************************
+* init_kernelCtx()
+*-----------------------------------------------------------
+* Initializes a kernel context for variable <xId> and 
+* solver buffer <AxId>
+***********************************************************/
+void init_kernelCtx(KernelCtx_t *ctx,
+                    SimData_t   *simData,
+                    int          xId,
+                    int          AxId)
+{
+  ctx->ghostData = simData->ghostData;
 
-  for (i = 0; i < PARAM_BUF_VARS; i++)
-    simParam->sbuf[i] = 0.0;
+  ctx->xId       = xId;
+  ctx->AxId      = AxId;
 
-  return simParam;
+  ctx->fluxFac   = 0.0;
+  ctx->dt        = simData->simParam->timestep;
 
-} /* init_simParam() */
+  ctx->rkFac     = 0.0;
+
+  ctx->courantRate    = 0.0;
+  ctx->courantRateSub = 0.0;
+
+} /* init_kernelCtx() */
 
 /***********************************************************
 * init_solverParam()
@@ -261,6 +414,25 @@ SolverParam_t *init_solverParam(void)
   solverParam->io_exportDir = "./";
   // Prefix for export files
   solverParam->io_exportPrefix = "TestRun";
+  // Format of solution files
+  solverParam->io_format = OUTPUT_VTK;
+  // Write snapshots asynchronously
+  solverParam->io_async = FALSE;
+  // Staging memory budget for asynchronous output [MB]
+  solverParam->io_bufferSize = 256.0;
+  // Checkpoint file to restart from
+  solverParam->io_restartFile = NULL;
+
+  // Abaqus mesh file for the connectivity
+  solverParam->meshFile = NULL;
+  // Number of trees of the brick connectivity per axis
+  solverParam->nTrees[0] = 1;
+  solverParam->nTrees[1] = 1;
+  solverParam->nTrees[2] = 1;
+  // Periodicity of the brick connectivity per axis
+  solverParam->periodic[0] = TRUE;
+  solverParam->periodic[1] = TRUE;
+  solverParam->periodic[2] = TRUE;
 
 
   // Number of quadrants per MPU
@@ -281,7 +453,22 @@ SolverParam_t *init_solverParam(void)
   // Global refinement error for passive scalar 
   solverParam->refErr_scalar    = 0.05;
   // Global refinement error for pressure  
-  solverParam->refErr_pressure  = 1.0E-03;
+  solverParam->refErr_pressure  = 0.0;
+  // Global refinement error for vorticity
+  solverParam->refErr_vorticity = 0.0;
+  // Global refinement error for velocity jumps
+  solverParam->refErr_velocity  = 0.0;
+
+  // Target global number of quads
+  solverParam->quadTarget = 0;
+  // Maximum global number of quads
+  solverParam->quadMax    = 0;
+  // Refine ahead of advected features
+  solverParam->predictRefine = FALSE;
+  // Ratio of coarsening to refinement threshold 
+  solverParam->coarsenRatio  = 0.5;
+  // Number of adaptations before coarsening 
+  solverParam->minRefineAge  = 2;
 
 
   // Number of timesteps between refinement periods
@@ -290,6 +477,10 @@ SolverParam_t *init_solverParam(void)
   solverParam->repartitionPeriod = 1;
   // Number of timesteps between solution writes
   solverParam->writePeriod = 10;
+  // Simulation time between solution writes
+  solverParam->writeInterval = 0.0;
+  // Number of timesteps between checkpoints
+  solverParam->checkpointPeriod = 0;
 
   return solverParam;
 
@@ -299,6 +490,8 @@ SolverParam_t *init_solverParam(void)
 * init_mpiParam()
 *-----------------------------------------------------------
 * Initializes the solver parameter structure
+* MPI is only initialized, if this has not been done 
+* before (e.g. by a test driver).
 ***********************************************************/
 MPIParam_t *init_mpiParam(int argc, char *argv[])
 {
@@ -306,12 +499,32 @@ MPIParam_t *init_mpiParam(int argc, char *argv[])
   mpiParam             = malloc(sizeof(MPIParam_t));
 
   int mpi_return;
-  
-  mpi_return = sc_MPI_Init(&argc, &argv);
+  int initialized;
+
+  mpi_return = sc_MPI_Initialized(&initialized);
+  SC_CHECK_MPI(mpi_return);
+
+  mpiParam->ownMPI = initialized ? FALSE : TRUE;
+
+  /*--------------------------------------------------------
+  | Kernels may be executed by several threads, while MPI 
+  | is only called by one thread at a time
+  --------------------------------------------------------*/
+  if (mpiParam->ownMPI == TRUE)
+    mpi_return = sc_MPI_Init_thread(&argc, &argv, 
+                                    sc_MPI_THREAD_SERIALIZED,
+                                    &mpiParam->threadLevel);
+  else
+    mpi_return = sc_MPI_Query_thread(&mpiParam->threadLevel);
+
   SC_CHECK_MPI(mpi_return);
 
   mpiParam->mpiComm = sc_MPI_COMM_WORLD;
 
+  if (mpiParam->threadLevel < sc_MPI_THREAD_SERIALIZED)
+    octPrint("WARNING: MPI library provides thread level %d only.",
+             mpiParam->threadLevel);
+
   return mpiParam;
 
 } /* init_mpiParam() */
@@ -326,6 +539,20 @@ MPIParam_t *init_mpiParam(int argc, char *argv[])
 ***********************************************************/
 void destroy_simData(SimData_t *simData)
 {
+  if (simData->writer != NULL)
+    destroy_asyncWriter(simData->writer);
+
+  if (simData->probes != NULL)
+    destroy_probes(simData->probes);
+
+  if (simData->zones != NULL)
+    destroy_zones(simData->zones);
+
+  if (simData->subcycle != NULL)
+    destroy_subcycleLists(simData->subcycle);
+
+  if (simData->indicator != NULL)
+    sc_array_destroy(simData->indicator);
 
   destroy_simParam(simData->simParam);
   destroy_solverParam(simData->solverParam);
@@ -333,6 +560,9 @@ void destroy_simData(SimData_t *simData)
   if (simData->p4est != NULL)
     p4est_destroy(simData->p4est);
 
+  if (simData->geomTable != NULL)
+    destroy_geomTable(simData->geomTable);
+
   if (simData->conn != NULL)
     p4est_connectivity_destroy(simData->conn);
 
@@ -362,6 +592,12 @@ void destroy_simParam(SimParam_t *simParam)
 ***********************************************************/
 void destroy_solverParam(SolverParam_t *solverParam)
 {
+  if (solverParam->io_restartFile != NULL)
+    bdestroy(solverParam->io_restartFile);
+
+  if (solverParam->meshFile != NULL)
+    bdestroy(solverParam->meshFile);
+
   free (solverParam);
 
 } /* destroy_solverParam() */
@@ -373,13 +609,102 @@ void destroy_solverParam(SolverParam_t *solverParam)
 ***********************************************************/
 void destroy_mpiParam(MPIParam_t *mpiParam)
 {
-  int mpi_return = sc_MPI_Finalize();
-  SC_CHECK_MPI(mpi_return);
+  if (mpiParam->ownMPI == TRUE)
+  {
+    int mpi_return = sc_MPI_Finalize();
+    SC_CHECK_MPI(mpi_return);
+  }
 
   free(mpiParam);
   
 } /* destroy_mpiParam() */
 
+/***********************************************************
+* registerStencil()
+*-----------------------------------------------------------
+* Registers the neighbour connectivity of a stencil that 
+* is evaluated with p4est_iterate() on the ghost layer.
+* The ghost layer is built with the widest connectivity 
+* of all registered stencils.
+***********************************************************/
+void registerStencil(SimData_t           *simData,
+                     p4est_connect_type_t stencilType)
+{
+  if (  p4est_connect_type_int(stencilType) 
+      > p4est_connect_type_int(simData->ghostConnect) )
+  {
+    simData->ghostConnect = stencilType;
+  }
+
+} /* registerStencil() */
+
+/***********************************************************
+* init_ghostData()
+*-----------------------------------------------------------
+* Creates the p4est ghost layer and the ghost data buffer
+* and fills the buffer with the data of the neighbouring
+* processes
+***********************************************************/
+void init_ghostData(SimData_t *simData)
+{
+  simData->ghost = p4est_ghost_new(simData->p4est, 
+                                   simData->ghostConnect);
+  simData->ghostData = P4EST_ALLOC(QuadData_t, 
+                          simData->ghost->ghosts.elem_count);
+  p4est_ghost_exchange_data(simData->p4est, 
+                            simData->ghost, 
+                            simData->ghostData);
+
+} /* init_ghostData() */
+
+/***********************************************************
+* destroy_ghostData()
+*-----------------------------------------------------------
+* Frees the p4est ghost layer and the ghost data buffer
+***********************************************************/
+void destroy_ghostData(SimData_t *simData)
+{
+  if (simData->ghost != NULL)
+    p4est_ghost_destroy(simData->ghost);
+
+  if (simData->ghostData != NULL)
+    P4EST_FREE(simData->ghostData);
+
+  simData->ghost     = NULL;
+  simData->ghostData = NULL;
+
+} /* destroy_ghostData() */
+
+/***********************************************************
+* exchangeMeshChanges()
+*-----------------------------------------------------------
+* Function to determine the global number of quadrants, 
+* that have been created by the last grid adaptation
+* (0 if no quadrant has been changed on any process).
+* Resets the local counter of adapted quadrants and 
+* increments the mesh revision, if the mesh has changed.
+***********************************************************/
+p4est_gloidx_t exchangeMeshChanges(SimData_t *simData)
+{
+  long changed_loc  = (long) simData->nAdaptedQuads;
+  long changed_glob = 0;
+
+  sc_MPI_Allreduce(&changed_loc,
+                   &changed_glob,
+                   1,
+                   sc_MPI_LONG,
+                   sc_MPI_SUM,
+                   simData->mpiParam->mpiComm);
+
+  simData->nAdaptedQuads = 0;
+
+  if (changed_glob > 0)
+    simData->meshRevision += 1;
+
+  return (p4est_gloidx_t) changed_glob;
+
+} /* exchangeMeshChanges() */
+
 /***********************************************************
 * estimateMeshAttributes()
 *-----------------------------------------------------------
@@ -30,6 +30,7 @@
 #include "solver/fluxConvection.h"
 #include "solver/timeIntegral.h"
 #include "solver/linearSolver.h"
+#include "solver/subcycling.h"
 
 #ifndef P4_TO_P8
 #include <p4est_bits.h>
@@ -69,11 +70,10 @@ void resetSolverBuffers_b(p4est_iter_volume_info_t *info,
 void resetSolverBuffers_Ax(p4est_iter_volume_info_t *info,
                            void *user_data)
 {
-  QuadData_t *quadData = (QuadData_t*)info->quad->p.user_data;
-  SimData_t  *simData  = (SimData_t*)info->p4est->user_pointer;
+  QuadData_t  *quadData = (QuadData_t*)info->quad->p.user_data;
+  KernelCtx_t *ctx      = (KernelCtx_t*)user_data;
 
-  int AxId = simData->simParam->tmp_AxId;
-  quadData->vars[AxId] = 0.0;
+  quadData->vars[ctx->AxId] = 0.0;
 
 } /* resetSolverBuffers_Ax() */
 
@@ -83,18 +83,22 @@ void resetSolverBuffers_Ax(p4est_iter_volume_info_t *info,
 * This function sums up the right hand side of the equation
 * system
 *   Ax = b 
-* that underlies a discretized transport equation.
+* that underlies a discretized transport equation for 
+* the timestep <dt>.
 ***********************************************************/
-void compute_b_tranEq(SimData_t *simData, int xId)
+void compute_b_tranEq(SimData_t *simData, int xId, octDouble dt)
 {
   /*--------------------------------------------------------
   | Compute flux factors for chosen discretization scheme
   --------------------------------------------------------*/
   SimParam_t *simParam  = simData->simParam;
   int         scheme    = simParam->tempScheme;
-  simParam->tmp_fluxFac = simParam->tempFluxFac[scheme]-1.0;
-  simParam->tmp_xId     = xId;
-  simParam->tmp_AxId    = SB;
+  octDouble   wtime     = sc_MPI_Wtime();
+
+  KernelCtx_t ctx;
+  init_kernelCtx(&ctx, simData, xId, SB);
+  ctx.fluxFac = simParam->tempFluxFac[scheme]-1.0;
+  ctx.dt      = dt;
 
   /*--------------------------------------------------------
   | Exchange data
@@ -113,7 +117,7 @@ void compute_b_tranEq(SimData_t *simData, int xId)
   --------------------------------------------------------*/
   p4est_iterate(simData->p4est,      
                 simData->ghost,      
-                (void *) simData->ghostData, 
+                (void *) &ctx, 
                 resetSolverBuffers_b, // quad callback
                 addFlux_conv_imp,     // face callback
 #ifdef P4_TO_P8
@@ -133,7 +137,7 @@ void compute_b_tranEq(SimData_t *simData, int xId)
   | Add temporal derivative terms
   --------------------------------------------------------*/
   p4est_iterate(simData->p4est, simData->ghost, 
-                (void *) simData->ghostData,
+                (void *) &ctx,
                 addTimeDerivative,     // cell callback
                 NULL,                  // face callback
 #ifdef P4_TO_P8
@@ -141,6 +145,7 @@ void compute_b_tranEq(SimData_t *simData, int xId)
 #endif
                 NULL);                 // corner callback
 
+  UPDATE_RUNNING_AVG(simParam->timeFluxEval, sc_MPI_Wtime() - wtime);
 
 } /* compute_b_tranEq() */
 
@@ -160,11 +165,11 @@ void compute_Ax_tranEq(SimData_t *simData,
   | Compute flux factors for chosen discretization scheme
   --------------------------------------------------------*/
   SimParam_t *simParam = simData->simParam;
+  int         scheme   = simParam->tempScheme;
 
-  int scheme            = simParam->tempScheme;
-  simParam->tmp_fluxFac = simParam->tempFluxFac[scheme];
-  simParam->tmp_xId     = xId;
-  simParam->tmp_AxId    = sbufIdx;
+  KernelCtx_t ctx;
+  init_kernelCtx(&ctx, simData, xId, sbufIdx);
+  ctx.fluxFac = simParam->tempFluxFac[scheme];
 
   /*--------------------------------------------------------
   | Exchange data
@@ -183,7 +188,7 @@ void compute_Ax_tranEq(SimData_t *simData,
   --------------------------------------------------------*/
   p4est_iterate(simData->p4est,      
                 simData->ghost,      
-                (void *) simData->ghostData, 
+                (void *) &ctx, 
                 resetSolverBuffers_Ax,// quad callback
                 addFlux_conv_imp,     // face callback
 #ifdef P4_TO_P8
@@ -203,7 +208,7 @@ void compute_Ax_tranEq(SimData_t *simData,
   | Add temporal derivative terms
   --------------------------------------------------------*/
   p4est_iterate(simData->p4est, simData->ghost, 
-                (void *) simData->ghostData,
+                (void *) &ctx,
                 addTimeDerivative,     // cell callback
                 NULL,                  // face callback
 #ifdef P4_TO_P8
@@ -214,27 +219,142 @@ void compute_Ax_tranEq(SimData_t *simData,
 } /* compute_Ax_tranEq() */
 
 /***********************************************************
-* solveTranEq()
+* solve_explicit_ssprk()
 *-----------------------------------------------------------
-* Function to solve a transport equation for a specified
-* variable <xId>.
+* Function to advance a transport equation for variable 
+* <xId> by the timestep <dt> with a strong stability 
+* preserving Runge-Kutta scheme (SSP-RK2 / SSP-RK3) in 
+* Shu-Osher form. 
+* Every stage is a forward Euler step, that is combined 
+* with the state u^n:
+*
+*   SSP-RK2: u1  = u^n + dt L(u^n)
+*            u^n+1 = 1/2 u^n + 1/2 (u1 + dt L(u1))
+*
+*   SSP-RK3: u1  = u^n + dt L(u^n)
+*            u2  = 3/4 u^n + 1/4 (u1 + dt L(u1))
+*            u^n+1 = 1/3 u^n + 2/3 (u2 + dt L(u2))
+*
+* u^n is kept in QuadData_t.rk_vn, such that no solver 
+* buffers are used besides the right hand side.
+* With local time stepping, every forward Euler stage is
+* a subcycled step (see solve_explicit_subcycled()).
 ***********************************************************/
-void solveTranEq(SimData_t *simData, int xId)
+void solve_explicit_ssprk(SimData_t *simData, int xId, octDouble dt)
+{
+  SimParam_t *simParam = simData->simParam;
+
+  static const octDouble rk2Fac[2] = { 0.0, 1.0/2.0 };
+  static const octDouble rk3Fac[3] = { 0.0, 3.0/4.0, 1.0/3.0 };
+
+  const octDouble *rkFac   = rk2Fac;
+  int              nStages = 2;
+
+  if (simParam->tempScheme == SSP_RK3)
+  {
+    rkFac   = rk3Fac;
+    nStages = 3;
+  }
+
+  int stage;
+
+  KernelCtx_t ctx;
+  init_kernelCtx(&ctx, simData, xId, SB);
+
+  /*--------------------------------------------------------
+  | Store state u^n
+  --------------------------------------------------------*/
+  p4est_iterate(simData->p4est, NULL, (void *) &ctx,
+                storeStageState,       // cell callback
+                NULL,                  // face callback
+#ifdef P4_TO_P8
+                NULL,                  // edge callback
+#endif
+                NULL);                 // corner callback
+
+  for (stage = 0; stage < nStages; stage++)
+  {
+    /*------------------------------------------------------
+    | Forward Euler stage
+    ------------------------------------------------------*/
+    if (simParam->subcycling == TRUE)
+    {
+      solve_explicit_subcycled(simData, xId, dt);
+    }
+    else
+    {
+      compute_b_tranEq(simData, xId, dt);
+      solve_explicit_sequential(simData, xId, dt);
+    }
+
+    /*------------------------------------------------------
+    | Combine with state u^n 
+    ------------------------------------------------------*/
+    if (rkFac[stage] > 0.0)
+    {
+      ctx.rkFac = rkFac[stage];
+
+      p4est_iterate(simData->p4est, NULL, (void *) &ctx,
+                    combineStageState,     // cell callback
+                    NULL,                  // face callback
+#ifdef P4_TO_P8
+                    NULL,                  // edge callback
+#endif
+                    NULL);                 // corner callback
+    }
+  }
+
+} /* solve_explicit_ssprk() */
+
+/***********************************************************
+* advanceTranEq()
+*-----------------------------------------------------------
+* Function to advance a transport equation for a specified
+* variable <xId> by a single timestep <dt>.
+***********************************************************/
+static void advanceTranEq(SimData_t *simData, int xId, octDouble dt)
 {
   SimParam_t *simParam = simData->simParam;
   int         scheme   = simParam->tempScheme;
 
+  /*--------------------------------------------------------
+  | Explicit scheme with local time stepping 
+  --------------------------------------------------------*/
+  if (scheme == EULER_EXPLICIT && simParam->subcycling == TRUE)
+  {
+    solve_explicit_subcycled(simData, xId, dt);
+
+    p4est_ghost_exchange_data(simData->p4est, 
+                              simData->ghost, 
+                              simData->ghostData);
+    return;
+  }
+
+  /*--------------------------------------------------------
+  | Explicit Runge-Kutta schemes 
+  | -> with or without local time stepping
+  --------------------------------------------------------*/
+  if (scheme == SSP_RK2 || scheme == SSP_RK3)
+  {
+    solve_explicit_ssprk(simData, xId, dt);
+
+    p4est_ghost_exchange_data(simData->p4est, 
+                              simData->ghost, 
+                              simData->ghostData);
+    return;
+  }
+
   /*--------------------------------------------------------
   | Compute right hand side b
   --------------------------------------------------------*/
-  compute_b_tranEq(simData, xId);
+  compute_b_tranEq(simData, xId, dt);
 
   /*--------------------------------------------------------
   | Solve transport equation using explicit solver
   --------------------------------------------------------*/
   if (scheme == EULER_EXPLICIT)
   {
-    solve_explicit_sequential(simData, xId);
+    solve_explicit_sequential(simData, xId, dt);
   }
   /*--------------------------------------------------------
   | Solve transport equation using Krylov solver
@@ -255,4 +375,29 @@ void solveTranEq(SimData_t *simData, int xId)
                             simData->ghostData);
 
 
+} /* advanceTranEq() */
+
+/***********************************************************
+* solveTranEq()
+*-----------------------------------------------------------
+* Function to solve a transport equation for a specified
+* variable <xId>.
+* Explicit schemes are split into simParam->nExplicitSteps
+* substeps (see chooseTempScheme()).
+***********************************************************/
+void solveTranEq(SimData_t *simData, int xId)
+{
+  SimParam_t *simParam = simData->simParam;
+
+  int nSteps = 1;
+
+  if (IS_EXPLICIT_SCHEME(simParam->tempScheme))
+    nSteps = MAX(1, simParam->nExplicitSteps);
+
+  octDouble dt = simParam->timestep / (octDouble) nSteps;
+  int i;
+
+  for (i = 0; i < nSteps; i++)
+    advanceTranEq(simData, xId, dt);
+
 } /* solveTranEq() */
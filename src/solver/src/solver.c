@@ -23,6 +23,8 @@
 * Free Software Foundation, Inc., 51 Franklin Street, 
 * Fifth Floor, Boston, MA 02110-1301, USA.
 */
+#include <math.h>
+
 #include "solver/solver.h"
 #include "solver/simData.h"
 #include "solver/quadData.h"
@@ -32,6 +34,10 @@
 #include "solver/gradients.h"
 #include "solver/projection.h"
 #include "solver/massflux.h"
+#include "solver/partition.h"
+#include "solver/checkpoint.h"
+#include "solver/probes.h"
+#include "solver/adapt.h"
 
 #ifndef P4_TO_P8
 #include <p4est_vtk.h>
@@ -58,31 +64,42 @@ void solverRun(SimData_t *simData)
   SolverParam_t *solverParam  = simData->solverParam;
 
   int step;
-  octDouble time;
 
   int refinePeriod      = solverParam->refinePeriod;
   int repartitionPeriod = solverParam->repartitionPeriod;
   int writePeriod       = solverParam->writePeriod;
+  int checkpointPeriod  = solverParam->checkpointPeriod;
 
   octBool adaptGrid     = solverParam->adaptGrid;
+  octBool meshChanged   = TRUE;
 
-  octDouble dt         = simParam->timestep;
-  octDouble simTimeTot = simParam->simTimeTot;
+  octDouble simTimeTot    = simParam->simTimeTot;
+  octDouble writeInterval = solverParam->writeInterval;
+  octDouble timeEps       = OCT_TIME_EPS * simTimeTot;
 
   /*--------------------------------------------------------
-  | Initialize gradients
+  | Next output time for time based output
+  --------------------------------------------------------*/
+  octDouble writeTime = simTimeTot;
+
+  if (writeInterval > 0.0)
+    writeTime = writeInterval 
+      * (floor((simParam->simTime + timeEps) / writeInterval) + 1.0);
+
+  /*--------------------------------------------------------
+  | Initialize gradients of the state variables
   --------------------------------------------------------*/
   int idx;
-  for (idx = 0; idx < OCT_MAX_VARS; idx++)
+  for (idx = OCT_SOLVER_VARS; idx < OCT_MAX_VARS; idx++)
     computeGradients(simData, idx); 
 
   /*--------------------------------------------------------
-  | The main loop
+  | The main loop 
+  | -> starts at the restored time and step on a restart
   --------------------------------------------------------*/
-  for (time = 0.0, step = 0; 
-       time < simTimeTot; time += dt, step += 1)
+  for (step = simParam->step; 
+       simParam->simTime < simTimeTot - timeEps; step += 1)
   {
-    simParam->simTime += dt;
 
     /*------------------------------------------------------
     | Perform a refinement of the domain
@@ -91,98 +108,103 @@ void solverRun(SimData_t *simData)
         && (step > 0) 
         && (adaptGrid == TRUE) )
     {
-      p4est_refine_ext(simData->p4est,
-                       solverParam->recursive,
-                       solverParam->maxRefLvl,
-                       globalRefinement,
-                       NULL,
-                       interpQuadData);
-
-      p4est_coarsen_ext(simData->p4est, 
-                        solverParam->recursive, 
-                        0,
-                        globalCoarsening, 
-                        NULL,
-                        interpQuadData);
-
-      p4est_balance_ext(simData->p4est, 
-                        P4EST_CONNECT_FACE, 
-                        NULL,
-                        interpQuadData);
-
-      p4est_ghost_destroy(simData->ghost);
-      P4EST_FREE(simData->ghostData);
-      simData->ghost = NULL;
-      simData->ghostData = NULL;
+      p4est_gloidx_t nChanged = adaptMesh(simData);
+
+      octPrint("GRID ADAPTATION: %ld NEW QUADS", (long) nChanged);
+
+      /*----------------------------------------------------
+      | Keep the ghost layer if no quadrant has been 
+      | refined, coarsened or balanced on any process
+      ----------------------------------------------------*/
+      if (nChanged > 0)
+      {
+        destroy_ghostData(simData);
+        meshChanged = TRUE;
+      }
     }
 
     /*------------------------------------------------------
     | Repartition domain
+    | -> only if the grid has changed since the last 
+    |    repartitioning
     |-----------------------------------------------------*/
     if (    (step > 0)
         && !(step % repartitionPeriod) 
-        &&  (adaptGrid == TRUE) ) 
+        &&  (adaptGrid == TRUE) 
+        &&  (meshChanged == TRUE) ) 
     {
-      p4est_partition(simData->p4est, 
-                      solverParam->partForCoarsen, 
-                      NULL);
-
-      if (simData->ghost) 
-      {
-        p4est_ghost_destroy(simData->ghost);
-        P4EST_FREE(simData->ghostData);
-        simData->ghost = NULL;
-        simData->ghostData = NULL;
-      }
+      partitionGrid(simData);
+      meshChanged = FALSE;
     }
 
     /*------------------------------------------------------
     | Synchronize ghost data
     |-----------------------------------------------------*/
-    if (!simData->ghost) {
-      simData->ghost = p4est_ghost_new(simData->p4est, 
-                                       P4EST_CONNECT_FULL);
-      simData->ghostData = P4EST_ALLOC(QuadData_t, 
-                          simData->ghost->ghosts.elem_count);
-      p4est_ghost_exchange_data(simData->p4est, 
-                                simData->ghost, 
-                                simData->ghostData);
-    }
+    if (!simData->ghost) 
+      init_ghostData(simData);
 
     /*------------------------------------------------------
     | Solve projection step
     |-----------------------------------------------------*/
     octPrint("");
-    octPrint("Step %6d | t=%10.3e", step+1, time);
+    octPrint("Step %6d | t=%10.3e", step+1, simParam->simTime);
     octPrint("--------------------------------------------------------------");
+    simParam->timeLanding = MIN(writeTime, simTimeTot);
     doProjectionStep(simData);
+    simParam->simTime += simParam->timestep;
     octPrint("--------------------------------------------------------------");
     octPrint("");
 
+    /*------------------------------------------------------
+    | Sample probes
+    |-----------------------------------------------------*/
+    if (simData->probes != NULL)
+      sampleProbes(simData, step+1);
+
     /*------------------------------------------------------
     | Write solution
     |-----------------------------------------------------*/
-    if (!(step % writePeriod)) 
+    octBool writeStep = !(step % writePeriod);
+
+    if (writeInterval > 0.0)
+    {
+      writeStep = (simParam->simTime >= writeTime - timeEps);
+
+      while (writeTime <= simParam->simTime + timeEps)
+        writeTime += writeInterval;
+    }
+
+    if (writeStep) 
     {
       octPrint("WRITE SOLUTION FILE FOR STEP %d", step+1);
-      writeSolutionVtk(simData, step+1);
+      writeSolution(simData, step+1);
       octPrint("");
     }
 
+    /*------------------------------------------------------
+    | Write checkpoint
+    |-----------------------------------------------------*/
+    simParam->step = step+1;
+
+    if (checkpointPeriod > 0 && !((step+1) % checkpointPeriod))
+      writeCheckpoint(simData, step+1);
+
 
-  } /* for (time, step ...) */
+  } /* for (step ...) */
 
   /*------------------------------------------------------
   | Write final solution
   |-----------------------------------------------------*/
   octPrint("WRITE SOLUTION FILE FOR STEP %d", step+1);
-  writeSolutionVtk(simData, step+1);
+  writeSolution(simData, step+1);
+
+  if (simData->writer != NULL)
+    flushAsyncWriter(simData->writer);
 
   /*--------------------------------------------------------
   | Release ghost data
   |-------------------------------------------------------*/
-  P4EST_FREE(simData->ghostData);
-  p4est_ghost_destroy(simData->ghost);
+  destroy_ghostData(simData);
 
 
 } /* solverRun() */
@@ -0,0 +1,516 @@
+/*
+* This file is part of OctFS. 
+* OctFS is a finite-volume flow solver with adaptive
+* mesh refinement written in C, which is based on 
+* the p4est library.
+*
+* Copyright (C) 2020 Florian Setzwein 
+*
+* OctFS is free software; you can redistribute it and/or 
+* modify it under the terms of the GNU General Public 
+* License as published by the Free Software Foundation; 
+* either version 2 of the License, or (at your option) 
+* any later version.
+*
+* OctFS is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied 
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR 
+* PURPOSE.  See the GNU General Public License for more 
+* details.
+*
+* You should have received a copy of the GNU General 
+* Public License along with OctFS; if not, write to the 
+* Free Software Foundation, Inc., 51 Franklin Street, 
+* Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+#include "solver/subcycling.h"
+#include "solver/fluxConvection.h"
+#include "solver/typedefs.h"
+#include "solver/util.h"
+#include "solver/quadData.h"
+#include "solver/simData.h"
+#include "aux/dbg.h"
+
+#ifndef P4_TO_P8
+#include <p4est_bits.h>
+#include <p4est_extended.h>
+#include <p4est_iterate.h>
+#else
+#include <p8est_bits.h>
+#include <p8est_extended.h>
+#include <p8est_iterate.h>
+#endif
+
+/***********************************************************
+* findLevelRange()
+*-----------------------------------------------------------
+* Function to find the minimum and maximum refinement 
+* level of all local quads.
+*
+*   -> p4est_iter_volume_t callback function
+***********************************************************/
+void findLevelRange(p4est_iter_volume_info_t *info,
+                    void                     *user_data)
+{
+  int *lvlRange = (int *) user_data;
+  int  lvl      = info->quad->level;
+
+  lvlRange[0] = MAX(lvlRange[0], -lvl);
+  lvlRange[1] = MAX(lvlRange[1],  lvl);
+
+} /* findLevelRange() */
+
+/***********************************************************
+* exchangeLevelRange()
+*-----------------------------------------------------------
+* Function to determine the global minimum and maximum 
+* refinement level (simParam->lvlMin, simParam->lvlMax)
+***********************************************************/
+void exchangeLevelRange(SimData_t *simData)
+{
+  SimParam_t *simParam = simData->simParam;
+
+  /*--------------------------------------------------------
+  | Minimum is stored negated -> single reduction
+  --------------------------------------------------------*/
+  int lvlRange_loc[2]  = { -P4EST_QMAXLEVEL, 0 };
+  int lvlRange_glob[2] = { 0, 0 };
+
+  p4est_iterate(simData->p4est, 
+                NULL, 
+                (void *) lvlRange_loc,
+                findLevelRange,  // cell callback
+                NULL,            // face callback
+#ifdef P4_TO_P8
+                NULL,            // edge callback
+#endif
+                NULL);           // corner callback
+
+  sc_MPI_Allreduce(lvlRange_loc,
+                   lvlRange_glob,
+                   2,
+                   sc_MPI_INT,
+                   sc_MPI_MAX,
+                   simData->mpiParam->mpiComm);
+
+  simParam->lvlMin = -lvlRange_glob[0];
+  simParam->lvlMax =  lvlRange_glob[1];
+
+} /* exchangeLevelRange() */
+
+/***********************************************************
+* localQuadIndex()
+*-----------------------------------------------------------
+* Returns the local index of a quad, given by its index 
+* <quadid> within the tree <treeid>
+***********************************************************/
+static p4est_locidx_t localQuadIndex(p4est_t        *p4est,
+                                     p4est_topidx_t  treeid,
+                                     p4est_locidx_t  quadid)
+{
+  p4est_tree_t *tree = p4est_tree_array_index(p4est->trees, treeid);
+
+  return tree->quadrants_offset + quadid;
+
+} /* localQuadIndex() */
+
+/***********************************************************
+* listQuad()
+*-----------------------------------------------------------
+* Function to add a local quad to the list of its 
+* refinement level.
+*
+*   -> p4est_iter_volume_t callback function
+***********************************************************/
+static void listQuad(p4est_iter_volume_info_t *info,
+                     void                     *user_data)
+{
+  SubcycleLists_t *lists = (SubcycleLists_t *) user_data;
+
+  p4est_locidx_t q = localQuadIndex(info->p4est, 
+                                    info->treeid, 
+                                    info->quadid);
+
+  lists->quadData[q] = (QuadData_t *) info->quad->p.user_data;
+
+  *(p4est_locidx_t *) sc_array_push(lists->quads[info->quad->level]) 
+    = q;
+
+} /* listQuad() */
+
+/***********************************************************
+* listFaceSide()
+*-----------------------------------------------------------
+* Returns the index of a quad of a face side and its 
+* ghost flag. <i> is the subface of a hanging side.
+***********************************************************/
+static p4est_locidx_t listFaceSide(p4est_t                *p4est,
+                                   p4est_iter_face_side_t *side,
+                                   int                     i,
+                                   int8_t                 *isGhost)
+{
+  if (side->is_hanging)
+  {
+    *isGhost = side->is.hanging.is_ghost[i];
+
+    if (*isGhost)
+      return side->is.hanging.quadid[i];
+
+    return localQuadIndex(p4est, side->treeid, 
+                          side->is.hanging.quadid[i]);
+  }
+
+  *isGhost = side->is.full.is_ghost;
+
+  if (*isGhost)
+    return side->is.full.quadid;
+
+  return localQuadIndex(p4est, side->treeid, side->is.full.quadid);
+
+} /* listFaceSide() */
+
+/***********************************************************
+* listFace()
+*-----------------------------------------------------------
+* Function to add a face to the list of the refinement 
+* level of its finer side. Hanging faces are split into 
+* their 2^(d-1) (P4EST_HALF) subfaces.
+*
+*   -> p4est_iter_face_t callback function
+***********************************************************/
+static void listFace(p4est_iter_face_info_t *info,
+                     void                   *user_data)
+{
+  SubcycleLists_t *lists = (SubcycleLists_t *) user_data;
+  sc_array_t      *sides = &(info->sides);
+
+  if (sides->elem_count < 2)
+    return;
+
+  p4est_iter_face_side_t *side[2];
+  side[0] = p4est_iter_fside_array_index_int(sides, 0);
+  side[1] = p4est_iter_fside_array_index_int(sides, 1);
+
+  /*-------------------------------------------------------
+  | Side <a> is the hanging side, or side 0 for 
+  | conforming faces
+  |------------------------------------------------------*/
+  const int ia = (side[1]->is_hanging) ? 1 : 0;
+  const int ib = 1 - ia;
+
+  const int nSub = (side[ia]->is_hanging) ? P4EST_HALF : 1;
+  int i;
+
+  for (i = 0; i < nSub; i++)
+  {
+    int lvl = (side[ia]->is_hanging) 
+            ? side[ia]->is.hanging.quad[i]->level
+            : side[ia]->is.full.quad->level;
+
+    SubcycleFace_t *face = 
+      (SubcycleFace_t *) sc_array_push(lists->faces[lvl]);
+
+    face->a     = listFaceSide(info->p4est, side[ia], i, &face->aGhost);
+    face->b     = listFaceSide(info->p4est, side[ib], 0, &face->bGhost);
+    face->iface = side[ia]->face;
+  }
+
+} /* listFace() */
+
+/***********************************************************
+* destroy_subcycleLists()
+*-----------------------------------------------------------
+* Destroys the subcycling lists
+***********************************************************/
+void destroy_subcycleLists(SubcycleLists_t *lists)
+{
+  int lvl;
+
+  for (lvl = 0; lvl <= P4EST_QMAXLEVEL; lvl++)
+  {
+    sc_array_destroy(lists->quads[lvl]);
+    sc_array_destroy(lists->faces[lvl]);
+  }
+
+  P4EST_FREE(lists->quadData);
+  P4EST_FREE(lists->ghostBuf);
+  P4EST_FREE(lists->mirrorBuf);
+  P4EST_FREE(lists);
+
+} /* destroy_subcycleLists() */
+
+/***********************************************************
+* update_subcycleLists()
+*-----------------------------------------------------------
+* Function to (re-)build the subcycling lists and the 
+* global level range (see exchangeLevelRange()), if the 
+* mesh has changed since they were built.
+* Requires a valid ghost layer.
+***********************************************************/
+void update_subcycleLists(SimData_t *simData)
+{
+  p4est_t         *p4est = simData->p4est;
+  p4est_ghost_t   *ghost = simData->ghost;
+  SubcycleLists_t *lists = simData->subcycle;
+
+  if (  lists != NULL 
+     && lists->meshRevision == simData->meshRevision )
+    return;
+
+  if (lists != NULL)
+    destroy_subcycleLists(lists);
+
+  exchangeLevelRange(simData);
+
+  const size_t nGhosts  = ghost->ghosts.elem_count;
+  const size_t nMirrors = ghost->mirrors.elem_count;
+
+  int    mirrorLevel_loc[P4EST_QMAXLEVEL + 1];
+  int    lvl;
+  size_t m;
+
+  lists = P4EST_ALLOC(SubcycleLists_t, 1);
+
+  lists->meshRevision = simData->meshRevision;
+  lists->nQuads       = p4est->local_num_quadrants;
+  lists->quadData     = P4EST_ALLOC(QuadData_t *, 
+                                    MAX(lists->nQuads, 1));
+  lists->nGhosts      = (p4est_locidx_t) nGhosts;
+  lists->ghostBuf     = P4EST_ALLOC(octDouble, MAX(nGhosts, 1));
+  lists->mirrorBuf    = P4EST_ALLOC(void *, MAX(nMirrors, 1));
+
+  for (lvl = 0; lvl <= P4EST_QMAXLEVEL; lvl++)
+  {
+    lists->quads[lvl]    = sc_array_new(sizeof(p4est_locidx_t));
+    lists->faces[lvl]    = sc_array_new(sizeof(SubcycleFace_t));
+    mirrorLevel_loc[lvl] = FALSE;
+  }
+
+  /*--------------------------------------------------------
+  | Sort quads and faces by level
+  --------------------------------------------------------*/
+  p4est_iterate(p4est, 
+                ghost, 
+                (void *) lists,
+                listQuad,  // cell callback
+                listFace,  // face callback
+#ifdef P4_TO_P8
+                NULL,      // edge callback
+#endif
+                NULL);     // corner callback
+
+  /*--------------------------------------------------------
+  | Levels, whose update must be sent to other processes
+  --------------------------------------------------------*/
+  for (m = 0; m < nMirrors; m++)
+  {
+    p4est_quadrant_t *mirror = 
+      p4est_quadrant_array_index(&ghost->mirrors, m);
+
+    mirrorLevel_loc[mirror->level] = TRUE;
+  }
+
+  sc_MPI_Allreduce(mirrorLevel_loc,
+                   lists->mirrorLevel,
+                   P4EST_QMAXLEVEL + 1,
+                   sc_MPI_INT,
+                   sc_MPI_MAX,
+                   simData->mpiParam->mpiComm);
+
+  simData->subcycle = lists;
+
+} /* update_subcycleLists() */
+
+/***********************************************************
+* exchangeSubcycleVar()
+*-----------------------------------------------------------
+* Exchanges the variable <xId> of the mirror quads with 
+* the neighbouring processes and stores it in the 
+* ghost data
+***********************************************************/
+static void exchangeSubcycleVar(SimData_t *simData, int xId)
+{
+  SubcycleLists_t *lists     = simData->subcycle;
+  p4est_ghost_t   *ghost     = simData->ghost;
+  QuadData_t      *ghostData = simData->ghostData;
+
+  p4est_locidx_t g;
+  size_t         m;
+
+  for (m = 0; m < ghost->mirrors.elem_count; m++)
+  {
+    p4est_quadrant_t *mirror = 
+      p4est_quadrant_array_index(&ghost->mirrors, m);
+
+    lists->mirrorBuf[m] = 
+      (void *) &lists->quadData[mirror->p.piggy3.local_num]->vars[xId];
+  }
+
+  p4est_ghost_exchange_custom(simData->p4est, 
+                              ghost, 
+                              sizeof(octDouble),
+                              lists->mirrorBuf,
+                              lists->ghostBuf);
+
+  for (g = 0; g < lists->nGhosts; g++)
+    ghostData[g].vars[xId] = lists->ghostBuf[g];
+
+} /* exchangeSubcycleVar() */
+
+/***********************************************************
+* addFlux_conv_sub()
+*-----------------------------------------------------------
+* Function to add the convective fluxes of all faces of 
+* level <lvl> to the flux registers <AxId> of the adjacent 
+* quads. <dtFace> is the timestep of the level.
+***********************************************************/
+static void addFlux_conv_sub(SimData_t *simData, 
+                             int xId, int AxId, int lvl,
+                             octDouble dtFace)
+{
+  SubcycleLists_t *lists     = simData->subcycle;
+  QuadData_t      *ghostData = simData->ghostData;
+  sc_array_t      *faces     = lists->faces[lvl];
+
+  size_t i;
+
+  for (i = 0; i < faces->elem_count; i++)
+  {
+    SubcycleFace_t *face = 
+      (SubcycleFace_t *) sc_array_index(faces, i);
+
+    QuadData_t *qDatA = (face->aGhost) 
+                      ? &ghostData[face->a] 
+                      : lists->quadData[face->a];
+    QuadData_t *qDatB = (face->bGhost) 
+                      ? &ghostData[face->b] 
+                      : lists->quadData[face->b];
+
+    const octDouble mflux = qDatA->mflux[face->iface];
+    const octDouble var_u = UPWIND_DIR(mflux,
+                                       qDatA->vars[xId],
+                                       qDatB->vars[xId]);
+    const octDouble flux  = dtFace * var_u * mflux;
+
+    qDatA->vars[AxId] += flux;
+    qDatB->vars[AxId] -= flux;
+  }
+
+} /* addFlux_conv_sub() */
+
+/***********************************************************
+* updateSubcycle()
+*-----------------------------------------------------------
+* Function to apply the flux register <AxId> to all quads 
+* of level <lvl>, whose timestep ends with the current 
+* substep.
+***********************************************************/
+static void updateSubcycle(SimData_t *simData, 
+                           int xId, int AxId, int lvl)
+{
+  SubcycleLists_t *lists = simData->subcycle;
+  sc_array_t      *quads = lists->quads[lvl];
+
+  size_t i;
+
+  for (i = 0; i < quads->elem_count; i++)
+  {
+    p4est_locidx_t q = *(p4est_locidx_t *) sc_array_index(quads, i);
+    QuadData_t *quadData = lists->quadData[q];
+
+    const octDouble vol = quadData->volume;
+    const octDouble rho = quadData->vars[IRHO];
+
+    quadData->vars[xId] -= quadData->vars[AxId] / vol / rho;
+    quadData->vars[AxId] = 0.0;
+  }
+
+} /* updateSubcycle() */
+
+/***********************************************************
+* solve_explicit_subcycled()
+*-----------------------------------------------------------
+* Function to advance a transport equation for variable 
+* <xId> by one global timestep <dt> with the explicit 
+* Euler scheme and local time stepping.
+* The ghost values of <xId> are not exchanged after the
+* last substep.
+***********************************************************/
+void solve_explicit_subcycled(SimData_t *simData, int xId, 
+                              octDouble dt)
+{
+  SimParam_t *simParam = simData->simParam;
+
+  update_subcycleLists(simData);
+
+  SubcycleLists_t *lists = simData->subcycle;
+
+  const int       lvlMin    = simParam->lvlMin;
+  const int       lvlMax    = simParam->lvlMax;
+  const int       nSubSteps = SUBCYCLE_PERIOD(simParam, lvlMin);
+  const octDouble subDt     = dt / (octDouble) nSubSteps;
+
+  p4est_locidx_t q;
+  int subStep, lvl, period, exchange;
+
+  /*--------------------------------------------------------
+  | Ghost massfluxes and states
+  --------------------------------------------------------*/
+  p4est_ghost_exchange_data(simData->p4est, 
+                            simData->ghost, 
+                            simData->ghostData);
+
+  /*--------------------------------------------------------
+  | Reset flux registers
+  --------------------------------------------------------*/
+  for (q = 0; q < lists->nQuads; q++)
+    lists->quadData[q]->vars[SB] = 0.0;
+
+  for (subStep = 0; subStep < nSubSteps; subStep++)
+  {
+    /*------------------------------------------------------
+    | Exchange <xId>, if a level with mirror quads has 
+    | been updated in the previous substep
+    | -> the decision is the same on every process
+    ------------------------------------------------------*/
+    exchange = FALSE;
+
+    for (lvl = lvlMin; subStep > 0 && lvl <= lvlMax; lvl++)
+    {
+      period = SUBCYCLE_PERIOD(simParam, lvl);
+
+      if (lists->mirrorLevel[lvl] && !(subStep % period))
+        exchange = TRUE;
+    }
+
+    if (exchange == TRUE)
+      exchangeSubcycleVar(simData, xId);
+
+    /*------------------------------------------------------
+    | Accumulate fluxes of active faces
+    ------------------------------------------------------*/
+    for (lvl = lvlMin; lvl <= lvlMax; lvl++)
+    {
+      period = SUBCYCLE_PERIOD(simParam, lvl);
+
+      if (subStep % period)
+        continue;
+
+      addFlux_conv_sub(simData, xId, SB, lvl, subDt * period);
+    }
+
+    /*------------------------------------------------------
+    | Update quads at the end of their timestep
+    ------------------------------------------------------*/
+    for (lvl = lvlMin; lvl <= lvlMax; lvl++)
+    {
+      period = SUBCYCLE_PERIOD(simParam, lvl);
+
+      if ((subStep + 1) % period)
+        continue;
+
+      updateSubcycle(simData, xId, SB, lvl);
+    }
+  }
+
+} /* solve_explicit_subcycled() */
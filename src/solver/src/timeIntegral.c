@@ -29,8 +29,11 @@
 #include "solver/quadData.h"
 #include "solver/simData.h"
 #include "solver/util.h"
+#include "solver/subcycling.h"
 #include "aux/dbg.h"
 
+#include <math.h>
+
 #ifndef P4_TO_P8
 #include <p4est_bits.h>
 #include <p4est_extended.h>
@@ -51,17 +54,261 @@
 void addTimeDerivative(p4est_iter_volume_info_t *info,
                        void *user_data)
 {
-  SimData_t  *simData  = (SimData_t*)info->p4est->user_pointer;
-  QuadData_t *quadData = (QuadData_t*)info->quad->p.user_data;
-  SimParam_t *simParam = simData->simParam;
+  QuadData_t  *quadData = (QuadData_t*)info->quad->p.user_data;
+  KernelCtx_t *ctx      = (KernelCtx_t*)user_data;
 
-  int       xId  = simParam->tmp_xId;
-  int       AxId = simParam->tmp_AxId;
+  int       xId  = ctx->xId;
+  int       AxId = ctx->AxId;
   octDouble vol  = quadData->volume;
-  octDouble dt   = simParam->timestep;
+  octDouble dt   = ctx->dt;
   octDouble rho  = quadData->vars[IRHO];
   octDouble var  = quadData->vars[xId];
 
   quadData->vars[AxId] += vol * var * rho / dt; 
 
 } /* addTimeDerivative() */
+
+/***********************************************************
+* storeStageState()
+*-----------------------------------------------------------
+* Function to store the state u^n of the current variable
+* at the beginning of a Runge-Kutta step.
+* 
+*   -> p4est_iter_volume_t callback function
+***********************************************************/
+void storeStageState(p4est_iter_volume_info_t *info,
+                     void *user_data)
+{
+  QuadData_t  *quadData = (QuadData_t*)info->quad->p.user_data;
+  KernelCtx_t *ctx      = (KernelCtx_t*)user_data;
+
+  quadData->rk_vn = quadData->vars[ctx->xId];
+
+} /* storeStageState() */
+
+/***********************************************************
+* combineStageState()
+*-----------------------------------------------------------
+* Function to combine the result of a forward Euler stage 
+* with the state u^n (Shu-Osher form):
+*   u = a * u^n + (1 - a) * u
+* where a is given by the kernel context (ctx->rkFac).
+* 
+*   -> p4est_iter_volume_t callback function
+***********************************************************/
+void combineStageState(p4est_iter_volume_info_t *info,
+                       void *user_data)
+{
+  QuadData_t  *quadData = (QuadData_t*)info->quad->p.user_data;
+  KernelCtx_t *ctx      = (KernelCtx_t*)user_data;
+
+  int       xId = ctx->xId;
+  octDouble a   = ctx->rkFac;
+
+  quadData->vars[xId] = a * quadData->rk_vn 
+                      + (1.0 - a) * quadData->vars[xId];
+
+} /* combineStageState() */
+
+/***********************************************************
+* schemeCourantRate()
+*-----------------------------------------------------------
+* Returns the maximum CFL number for a unit timestep of 
+* the temporal scheme <scheme>, i.e. the level-scaled rate
+* if the scheme uses local time stepping
+***********************************************************/
+static octDouble schemeCourantRate(SimParam_t *simParam, 
+                                   int         scheme)
+{
+  if (IS_SUBCYCLED(simParam, scheme))
+    return simParam->courantRateSub;
+
+  return simParam->courantRate;
+
+} /* schemeCourantRate() */
+
+/***********************************************************
+* exchangeCourantRate()
+*-----------------------------------------------------------
+* Function to reduce the maximum CFL rates of all quads 
+* (simParam->courantRate, simParam->courantRateSub) 
+* together with the measured solver costs over all 
+* processes in a single reduction.
+***********************************************************/
+void exchangeCourantRate(SimData_t *simData)
+{
+  SimParam_t *simParam = simData->simParam;
+
+  octDouble buf_loc[4] = { simParam->courantRate,
+                           simParam->courantRateSub,
+                           simParam->timeFluxEval,
+                           simParam->timeKrylovIter };
+  octDouble buf_glob[4];
+
+  sc_MPI_Allreduce(buf_loc,
+                   buf_glob,
+                   4,
+                   sc_MPI_DOUBLE,
+                   sc_MPI_MAX,
+                   simData->mpiParam->mpiComm);
+
+  simParam->courantRate    = buf_glob[0];
+  simParam->courantRateSub = buf_glob[1];
+  simParam->timeFluxEval   = buf_glob[2];
+  simParam->timeKrylovIter = buf_glob[3];
+
+} /* exchangeCourantRate() */
+
+/***********************************************************
+* targetTimestep()
+*-----------------------------------------------------------
+* Returns the timestep of the temporal scheme <scheme> for
+* the next step: 
+* With an adaptive timestep, the maximum CFL number of all
+* quads matches the target CFL number of the scheme. 
+* The timestep is bounded by the minimum/maximum timestep 
+* and reduced to land exactly on simParam->timeLanding.
+* Otherwise, the fixed timestep is returned.
+***********************************************************/
+static octDouble targetTimestep(SimParam_t *simParam, int scheme)
+{
+  if (simParam->adaptTimestep == FALSE)
+    return simParam->timestep;
+
+  octDouble rate = schemeCourantRate(simParam, scheme);
+
+  octDouble cfl = IS_EXPLICIT_SCHEME(scheme)
+                ? simParam->cflTargetExplicit
+                : simParam->cflTarget;
+
+  octDouble dt = simParam->timestepMax;
+
+  if (rate > 0.0)
+    dt = cfl / rate;
+
+  dt = MIN(dt, simParam->timestepMax);
+  dt = MAX(dt, simParam->timestepMin);
+
+  /*--------------------------------------------------------
+  | Land exactly on output / end time
+  --------------------------------------------------------*/
+  octDouble remaining = simParam->timeLanding - simParam->simTime;
+
+  if (remaining > 0.0 && dt > remaining)
+    dt = remaining;
+
+  return dt;
+
+} /* targetTimestep() */
+
+/***********************************************************
+* chooseTempScheme()
+*-----------------------------------------------------------
+* Function to choose the cheaper of the explicit and the
+* implicit scheme for the next timestep (automatic mode).
+*
+* Both schemes are compared by their costs per unit of 
+* simulated time, each with its own timestep (see 
+* targetTimestep()), i.e. with an adaptive timestep the 
+* explicit scheme runs at cflTargetExplicit and the 
+* implicit scheme at cflTarget:
+*
+* Explicit: n substeps to stay below the explicit target 
+*           CFL number, each with one flux evaluation per 
+*           Runge-Kutta stage.
+* Implicit: one flux evaluation for the right hand side 
+*           and the recent average number of BiCGSTAB 
+*           iterations (each with several cmpAx() calls 
+*           and global reductions).
+*
+* As long as no implicit solve has been measured, the 
+* implicit scheme is chosen to obtain its costs.
+* All costs are measured wall times, that have been 
+* reduced over all processes, such that every process 
+* takes the same decision.
+* The scheme must be chosen before the timestep is set
+* by adaptTimestep().
+* Requires the global CFL rates of exchangeCourantRate().
+***********************************************************/
+void chooseTempScheme(SimData_t *simData)
+{
+  SimParam_t *simParam = simData->simParam;
+
+  int explicitScheme = simParam->autoSchemeExplicit;
+  int implicitScheme = simParam->autoSchemeImplicit;
+
+  /*--------------------------------------------------------
+  | Timesteps of both schemes and number of explicit 
+  | substeps to stay below the explicit target CFL number
+  --------------------------------------------------------*/
+  octDouble dtExplicit = targetTimestep(simParam, explicitScheme);
+  octDouble dtImplicit = targetTimestep(simParam, implicitScheme);
+
+  octDouble cfl    = schemeCourantRate(simParam, explicitScheme) 
+                   * dtExplicit;
+  int       nSteps = (int) ceil(cfl / simParam->cflTargetExplicit);
+
+  nSteps = MAX(1, nSteps);
+
+  int nStages = 1;
+  if (explicitScheme == SSP_RK2)
+    nStages = 2;
+  else if (explicitScheme == SSP_RK3)
+    nStages = 3;
+
+  /*--------------------------------------------------------
+  | Estimate costs per unit of simulated time
+  --------------------------------------------------------*/
+  octDouble tFlux = simParam->timeFluxEval;
+  octDouble tIter = simParam->timeKrylovIter;
+
+  octDouble costExplicit = nSteps * nStages * tFlux / dtExplicit;
+  octDouble costImplicit = ( tFlux + simParam->avgKrylovIter * tIter )
+                         / dtImplicit;
+
+  octBool useExplicit;
+
+  if (tIter <= 0.0 || tFlux <= 0.0)
+    // No implicit solve so far -> measure its costs first
+    useExplicit = FALSE;
+  else
+    useExplicit = (costExplicit <= costImplicit);
+
+  if (useExplicit == TRUE)
+  {
+    simParam->tempScheme     = explicitScheme;
+    simParam->nExplicitSteps = nSteps;
+  }
+  else
+  {
+    simParam->tempScheme     = implicitScheme;
+    simParam->nExplicitSteps = 1;
+  }
+
+  octPrint("Automatic scheme: %s (CFL=%10.3e, substeps=%d, "
+           "cost/time explicit=%10.3e, implicit=%10.3e)",
+           useExplicit ? "explicit" : "implicit", 
+           cfl, nSteps, costExplicit, costImplicit);
+
+} /* chooseTempScheme() */
+
+/***********************************************************
+* adaptTimestep()
+*-----------------------------------------------------------
+* Function to set the timestep, such that the maximum CFL 
+* number of all quads matches the target CFL number of 
+* the chosen temporal scheme (see targetTimestep()). 
+* Requires the global CFL rates of exchangeCourantRate().
+***********************************************************/
+void adaptTimestep(SimData_t *simData)
+{
+  SimParam_t *simParam = simData->simParam;
+
+  octDouble dt = targetTimestep(simParam, simParam->tempScheme);
+
+  simParam->timestep = dt;
+
+  octPrint("Adaptive timestep: dt=%10.3e, CFL=%10.3e", 
+      dt, dt * schemeCourantRate(simParam, simParam->tempScheme));
+
+} /* adaptTimestep() */
@@ -0,0 +1,327 @@
+/*
+* This file is part of OctFS. 
+* OctFS is a finite-volume flow solver with adaptive
+* mesh refinement written in C, which is based on 
+* the p4est library.
+*
+* Copyright (C) 2020 Florian Setzwein 
+*
+* OctFS is free software; you can redistribute it and/or 
+* modify it under the terms of the GNU General Public 
+* License as published by the Free Software Foundation; 
+* either version 2 of the License, or (at your option) 
+* any later version.
+*
+* OctFS is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied 
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR 
+* PURPOSE.  See the GNU General Public License for more 
+* details.
+*
+* You should have received a copy of the GNU General 
+* Public License along with OctFS; if not, write to the 
+* Free Software Foundation, Inc., 51 Franklin Street, 
+* Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+#include <math.h>
+
+#include "solver/zones.h"
+#include "solver/typedefs.h"
+#include "solver/util.h"
+#include "solver/quadData.h"
+#include "solver/simData.h"
+#include "solver/paramfile.h"
+
+#ifndef P4_TO_P8
+#include <p4est_bits.h>
+#include <p4est_extended.h>
+#include <p4est_search.h>
+#else
+#include <p8est_bits.h>
+#include <p8est_extended.h>
+#include <p8est_search.h>
+#endif
+
+/***********************************************************
+* readZones()
+*-----------------------------------------------------------
+* Reads all zones of a given type from the parameter file.
+* Every line containing the instruction <fltr> defines 
+* one zone with <nvals> comma separated values, the last
+* value is the refinement level.
+***********************************************************/
+static void readZones(ZoneSet_t  *zoneSet,
+                      octParam   *paramFile,
+                      const char *fltr,
+                      ZoneType    type,
+                      int         nvals)
+{
+  struct bstrList *lines = octParam_getLinesWith(paramFile->txtlist,
+                                                 fltr);
+  octDouble v[8];
+  int i, n;
+
+  for (i = 0; i < lines->qty; i++)
+  {
+    bstring line = lines->entry[i];
+
+    if (octParam_readValues(line, fltr, v, nvals) < nvals)
+    {
+      octPrint("[WARNING]: Zone definition requires %d values:", 
+          nvals);
+      octPrint("%s", (char *) line->data);
+      continue;
+    }
+
+    if (zoneSet->nZones >= OCT_MAX_ZONES)
+    {
+      octPrint("[WARNING]: Maximum number of zones (%d) exceeded", 
+          OCT_MAX_ZONES);
+      break;
+    }
+
+    RefineZone_t *zone = &zoneSet->zones[zoneSet->nZones];
+
+    zone->type  = type;
+    zone->level = (int) v[nvals-1];
+
+    for (n = 0; n < nvals-1; n++)
+      zone->v[n] = v[n];
+
+    zoneSet->nZones += 1;
+
+    octPrint("%s level %d", fltr, zone->level);
+  }
+
+  bstrListDestroy(lines);
+
+} /* readZones() */
+
+/***********************************************************
+* init_zones()
+*-----------------------------------------------------------
+* Reads all refinement zones from the parameter file.
+* Returns NULL if no zones are defined.
+***********************************************************/
+ZoneSet_t *init_zones(octParam *paramFile)
+{
+  ZoneSet_t *zoneSet = malloc(sizeof(ZoneSet_t));
+
+  zoneSet->nZones = 0;
+
+  readZones(zoneSet, paramFile, "Refinement box:",      ZONE_BOX,      7);
+  readZones(zoneSet, paramFile, "Refinement sphere:",   ZONE_SPHERE,   5);
+  readZones(zoneSet, paramFile, "Refinement cylinder:", ZONE_CYLINDER, 8);
+
+  if (zoneSet->nZones < 1)
+  {
+    destroy_zones(zoneSet);
+    return NULL;
+  }
+
+  return zoneSet;
+
+} /* init_zones() */
+
+/***********************************************************
+* destroy_zones()
+*-----------------------------------------------------------
+* Frees the zone set
+***********************************************************/
+void destroy_zones(ZoneSet_t *zoneSet)
+{
+  free(zoneSet);
+
+} /* destroy_zones() */
+
+/***********************************************************
+* zoneIntersects()
+*-----------------------------------------------------------
+* Checks if a refinement zone intersects the bounding box 
+* [lo, hi] of a quadrant.
+* For cylinders, the bounding sphere of the box is tested
+* against the cylinder, which is a conservative estimate.
+***********************************************************/
+int zoneIntersects(const RefineZone_t *zone,
+                   const octDouble    *lo,
+                   const octDouble    *hi)
+{
+  const octDouble *v = zone->v;
+  int i;
+
+  if (zone->type == ZONE_BOX)
+  {
+    for (i = 0; i < P4EST_DIM; i++)
+    {
+      if (  hi[i] < MIN(v[i], v[i+3]) 
+         || lo[i] > MAX(v[i], v[i+3]) )
+        return 0;
+    }
+    return 1;
+  }
+
+  if (zone->type == ZONE_SPHERE)
+  {
+    octDouble d2 = 0.0;
+
+    for (i = 0; i < P4EST_DIM; i++)
+    {
+      const octDouble d = v[i] - MAX(lo[i], MIN(v[i], hi[i]));
+      d2 += d * d;
+    }
+    return (d2 <= v[3] * v[3]);
+  }
+
+  /*--------------------------------------------------------
+  | Cylinder: distance of box center to the axis segment
+  --------------------------------------------------------*/
+  octDouble c[3]    = { 0.0, 0.0, 0.0 };
+  octDouble axis[3] = { 0.0, 0.0, 0.0 };
+  octDouble rad2    = 0.0;
+  octDouble len2    = 0.0;
+  octDouble t       = 0.0;
+
+  for (i = 0; i < P4EST_DIM; i++)
+  {
+    c[i]    = 0.5 * (lo[i] + hi[i]);
+    axis[i] = v[i+3] - v[i];
+    rad2   += 0.25 * (hi[i] - lo[i]) * (hi[i] - lo[i]);
+    len2   += axis[i] * axis[i];
+    t      += (c[i] - v[i]) * axis[i];
+  }
+
+  t = (len2 > 0.0) ? MAX(0.0, MIN(1.0, t / len2)) : 0.0;
+
+  octDouble d2 = 0.0;
+
+  for (i = 0; i < P4EST_DIM; i++)
+  {
+    const octDouble d = c[i] - (v[i] + t * axis[i]);
+    d2 += d * d;
+  }
+
+  const octDouble r = v[6] + sqrt(rad2);
+
+  return (d2 <= r * r);
+
+} /* zoneIntersects() */
+
+/***********************************************************
+* zoneRefineLevel()
+*-----------------------------------------------------------
+* Returns the highest level of all zones that intersect
+* a quadrant and whose level is not below the level of 
+* the quadrant (-1 if there is no such zone)
+***********************************************************/
+int zoneRefineLevel(p4est_t          *p4est,
+                    p4est_topidx_t    which_tree,
+                    p4est_quadrant_t *q)
+{
+  SimData_t *simData = (SimData_t *) p4est->user_pointer;
+  ZoneSet_t *zoneSet = simData->zones;
+
+  if (zoneSet == NULL)
+    return -1;
+
+  p4est_qcoord_t len = P4EST_QUADRANT_LEN(q->level);
+
+  octDouble lo[3], hi[3];
+  int i, level = -1;
+
+  /*--------------------------------------------------------
+  | Bounding box of the quadrant
+  --------------------------------------------------------*/
+#ifdef P4_TO_P8
+  p4est_qcoord_to_vertex(p4est->connectivity, which_tree,
+                         q->x, q->y, q->z, lo);
+  p4est_qcoord_to_vertex(p4est->connectivity, which_tree,
+                         q->x+len, q->y+len, q->z+len, hi);
+#else
+  p4est_qcoord_to_vertex(p4est->connectivity, which_tree,
+                         q->x, q->y, lo);
+  p4est_qcoord_to_vertex(p4est->connectivity, which_tree,
+                         q->x+len, q->y+len, hi);
+#endif
+
+  for (i = 0; i < P4EST_DIM; i++)
+  {
+    const octDouble l = MIN(lo[i], hi[i]);
+    hi[i] = MAX(lo[i], hi[i]);
+    lo[i] = l;
+  }
+
+  for (i = 0; i < zoneSet->nZones; i++)
+  {
+    const RefineZone_t *zone = &zoneSet->zones[i];
+
+    if (zone->level < q->level || zone->level <= level)
+      continue;
+
+    if (zoneIntersects(zone, lo, hi))
+      level = zone->level;
+  }
+
+  return level;
+
+} /* zoneRefineLevel() */
+
+/***********************************************************
+* searchZones()
+*-----------------------------------------------------------
+* Flags local leaves inside refinement zones.
+* Branches outside of all zones are pruned.
+*   -> p4est_search_local_t callback function
+***********************************************************/
+int searchZones(p4est_t          *p4est,
+                p4est_topidx_t    which_tree,
+                p4est_quadrant_t *q,
+                p4est_locidx_t    local_num,
+                void             *point)
+{
+  SimData_t *simData = (SimData_t *) p4est->user_pointer;
+
+  int level = zoneRefineLevel(p4est, which_tree, q);
+
+  if (level < 0)
+    return 0;
+
+  if (local_num < 0)
+    return 1;
+
+  /*--------------------------------------------------------
+  | Local leaf -> refine up to zone level, 
+  |               do not coarsen below it
+  --------------------------------------------------------*/
+  p4est_tree_t     *tree = p4est_tree_array_index(p4est->trees, 
+                                                  which_tree);
+  p4est_quadrant_t *quad = p4est_quadrant_array_index(
+                             &tree->quadrants, 
+                             local_num - tree->quadrants_offset);
+  QuadData_t   *quadData = (QuadData_t *) quad->p.user_data;
+
+  level = MIN(level, simData->solverParam->maxRefLvl);
+
+  if (quad->level < level)
+    quadData->adaptFlag = ADAPT_REFINE;
+  else if (quadData->adaptFlag != ADAPT_REFINE)
+    quadData->adaptFlag = ADAPT_HOLD;
+
+  return 1;
+
+} /* searchZones() */
+
+/***********************************************************
+* markZones()
+*-----------------------------------------------------------
+* Sets the adaptation flags of all local quads inside 
+* refinement zones. 
+* Only the subtrees that intersect a zone are traversed.
+***********************************************************/
+void markZones(SimData_t *simData)
+{
+  if (simData->zones == NULL)
+    return;
+
+  p4est_search_local(simData->p4est, 0, searchZones, NULL, NULL);
+
+} /* markZones() */
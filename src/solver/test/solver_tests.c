@@ -10,11 +10,17 @@
 #include "solver/typedefs.h"
 #include "solver/dataIO.h"
 #include "solver/gradients.h"
+#include "solver/adapt.h"
+#include "solver/partition.h"
+#include "solver/paramfile.h"
+#include "solver/zones.h"
 
 #include "solver_tests.h"
 
 #define CUR_TEST_NAME "solver_tests"
 
+#define EQ_REL(a, b) ( fabs((a) - (b)) <= 1.0e-12 * fabs(b) )
+
 
 /************************************************************
 * User-defined flow variable initialization
@@ -209,6 +215,7 @@ char *test_solver_init_destroy(int argc, char *argv[])
   solverRun(simData);
   */
 
+  destroy_ghostData(simData);
   destroy_simData(simData);
 
   return NULL;
@@ -217,3 +224,522 @@ char *test_solver_init_destroy(int argc, char *argv[])
 
 
 
+/************************************************************
+* Function to test the histogram bins and thresholds of
+* the quad budget
+************************************************************/
+char *test_adapt_histogram(int argc, char *argv[])
+{
+  const octDouble lRange[2] = { -2.0, 2.0 };
+  const int       nBins     = OCT_BUDGET_BINS;
+
+  long hist[OCT_BUDGET_BINS];
+  int  b;
+
+  /*--------------------------------------------------------
+  | Bins: zero indicators have their own bin
+  --------------------------------------------------------*/
+  mu_assert(indicatorBin( 0.0,    lRange) == 0, 
+      "Zero indicator not in bin 0");
+  mu_assert(indicatorBin(-1.0,    lRange) == 0, 
+      "Negative indicator not in bin 0");
+  mu_assert(indicatorBin( 1.0e-2, lRange) == 1, 
+      "Minimum indicator not in bin 1");
+  mu_assert(indicatorBin( 1.0e-5, lRange) == 1, 
+      "Small indicator not clamped to bin 1");
+  mu_assert(indicatorBin( 1.0e+2, lRange) == nBins-1, 
+      "Maximum indicator not in last bin");
+  mu_assert(indicatorBin( 1.0e+5, lRange) == nBins-1, 
+      "Large indicator not clamped to last bin");
+
+  mu_assert(binEdge(0, lRange) == 0.0, 
+      "Wrong edge of bin 0");
+  mu_assert(EQ_REL(binEdge(1, lRange), 1.0e-2), 
+      "Wrong edge of bin 1");
+  mu_assert(EQ_REL(binEdge(nBins, lRange), 1.0e+2), 
+      "Wrong upper edge of last bin");
+
+  for (b = 1; b < nBins; b++)
+  {
+    octDouble ind = sqrt( binEdge(b, lRange) 
+                        * binEdge(b+1, lRange) );
+
+    mu_assert(indicatorBin(ind, lRange) == b, 
+        "Indicator not in bin of its edges");
+  }
+
+  /*--------------------------------------------------------
+  | Known histogram: 
+  | 10 zeros, 5 in bin 1, 4 in bin 100, 3 in last bin
+  --------------------------------------------------------*/
+  for (b = 0; b < nBins; b++)
+    hist[b] = 0;
+
+  hist[0]       = 10;
+  hist[1]       =  5;
+  hist[100]     =  4;
+  hist[nBins-1] =  3;
+
+  mu_assert(EQ_REL(histRefineThresh(hist, 0, lRange), 1.0e+2),
+      "Refinement threshold for n=0 refines quads");
+  mu_assert(EQ_REL(histRefineThresh(hist, 3, lRange), 
+                   binEdge(101, lRange)),
+      "Wrong refinement threshold for n=3");
+  mu_assert(EQ_REL(histRefineThresh(hist, 6, lRange), 
+                   binEdge(101, lRange)),
+      "Wrong refinement threshold for n=6");
+  mu_assert(EQ_REL(histRefineThresh(hist, 7, lRange), 
+                   binEdge(2, lRange)),
+      "Wrong refinement threshold for n=7");
+  mu_assert(histRefineThresh(hist, 12, lRange) == 0.0,
+      "Wrong refinement threshold for n=12");
+
+  mu_assert(histCoarsenThresh(hist, 5, lRange) == 0.0,
+      "Zero indicator families coarsened beyond budget");
+  mu_assert(EQ_REL(histCoarsenThresh(hist, 15, lRange), 
+                   binEdge(100, lRange)),
+      "Wrong coarsening threshold for n=15");
+  mu_assert(histCoarsenThresh(hist, 22, lRange) == DBL_MAX,
+      "Wrong coarsening threshold for n=22");
+
+  return NULL;
+
+} /* test_adapt_histogram() */
+
+
+
+/************************************************************
+* Function to test the hysteresis between refinement and
+* coarsening
+************************************************************/
+char *test_adapt_hysteresis(int argc, char *argv[])
+{
+  const octDouble refThresh = 2.0;
+  const octDouble ratio     = 0.5;
+  const octDouble famLim    = ratio * refThresh 
+                            / OCT_COARSEN_ERR_FAC;
+
+  mu_assert(coarsenByHysteresis(0.0, refThresh, ratio) == 1,
+      "Family without error is not coarsened");
+  mu_assert(coarsenByHysteresis(0.99*famLim, refThresh, ratio) == 1,
+      "Family below hysteresis limit is not coarsened");
+  mu_assert(coarsenByHysteresis(1.01*famLim, refThresh, ratio) == 0,
+      "Family above hysteresis limit is coarsened");
+  mu_assert(coarsenByHysteresis(1.0e-12, refThresh, 0.0) == 0,
+      "Family is coarsened for coarsenRatio = 0");
+
+  /*--------------------------------------------------------
+  | Coarsened quads are not flagged for refinement by the
+  | next adaptation
+  --------------------------------------------------------*/
+  octDouble famInd;
+
+  for (famInd = 1.0e-6; famInd < 1.0e+6; famInd *= 1.1)
+  {
+    if (coarsenByHysteresis(famInd, refThresh, ratio))
+      mu_assert(OCT_COARSEN_ERR_FAC * famInd <= refThresh,
+          "Coarsened family is refined again");
+  }
+
+  return NULL;
+
+} /* test_adapt_hysteresis() */
+
+
+/************************************************************
+* Refinement of all quads on the first process
+************************************************************/
+static int refine_onRoot(p4est_t          *p4est,
+                         p4est_topidx_t    which_tree,
+                         p4est_quadrant_t *q)
+{
+  return (p4est->mpirank == 0);
+
+} /* refine_onRoot() */
+
+/************************************************************
+* Adaptation age of a quad, that is defined by its position
+************************************************************/
+static int quadAge(p4est_topidx_t which_tree, p4est_quadrant_t *q)
+{
+  p4est_qcoord_t len = P4EST_QUADRANT_LEN(q->level);
+
+  int age = 7 * (int) which_tree + 3 * q->level
+          +     (int) (q->x / len) 
+          + 5 * (int) (q->y / len);
+#ifdef P4_TO_P8
+  age += 11 * (int) (q->z / len);
+#endif
+
+  return age;
+
+} /* quadAge() */
+
+static void setQuadAge(p4est_iter_volume_info_t *info,
+                       void *user_data)
+{
+  QuadData_t *quadData = (QuadData_t *) info->quad->p.user_data;
+
+  quadData->adaptAge = quadAge(info->treeid, info->quad);
+
+} /* setQuadAge() */
+
+static void checkQuadAge(p4est_iter_volume_info_t *info,
+                         void *user_data)
+{
+  QuadData_t *quadData = (QuadData_t *) info->quad->p.user_data;
+  int        *nWrong   = (int *) user_data;
+
+  if (quadData->adaptAge != quadAge(info->treeid, info->quad))
+    *nWrong += 1;
+
+} /* checkQuadAge() */
+
+/************************************************************
+* Function to test, that the adaptation age of the quads
+* survives a repartitioning of the grid
+************************************************************/
+char *test_solver_partition(int argc, char *argv[])
+{
+  SimData_t *simData = init_simData(argc, argv, 
+                                    init_function,
+                                    refine_fn,
+                                    coarse_fn);
+
+  mu_assert(simData != NULL, "Failed to init simulation data");
+
+  p4est_t *p4est = simData->p4est;
+
+  /*--------------------------------------------------------
+  | Adapt the grid only on the first process
+  --------------------------------------------------------*/
+  p4est_refine(p4est, 0, refine_onRoot, init_quadData);
+  p4est_balance(p4est, P4EST_CONNECT_FACE, init_quadData);
+
+  destroy_ghostData(simData);
+  init_ghostData(simData);
+
+  p4est_iterate(p4est, NULL, NULL,
+                setQuadAge,     // cell callback
+                NULL,           // face callback
+#ifdef P4_TO_P8
+                NULL,           // edge callback
+#endif
+                NULL);          // corner callback
+
+  /*--------------------------------------------------------
+  | Repartition and check the age of all local quads
+  --------------------------------------------------------*/
+  p4est_gloidx_t nShipped = partitionGrid(simData);
+
+  int nWrong = 0;
+
+  p4est_iterate(simData->p4est, NULL, (void *) &nWrong,
+                checkQuadAge,   // cell callback
+                NULL,           // face callback
+#ifdef P4_TO_P8
+                NULL,           // edge callback
+#endif
+                NULL);          // corner callback
+
+  int mpisize = simData->p4est->mpisize;
+
+  destroy_ghostData(simData);
+  destroy_simData(simData);
+
+  mu_assert(mpisize == 1 || nShipped > 0, 
+      "No quads shipped by repartitioning");
+  mu_assert(nWrong == 0, 
+      "Wrong adaptation age after repartitioning");
+
+  return NULL;
+
+} /* test_solver_partition() */
+
+
+
+/************************************************************
+* Function to test the parsing of value lists from the 
+* parameter file
+************************************************************/
+char *test_param_readValues(int argc, char *argv[])
+{
+  bstring   line = bfromcstr("Refinement sphere: 0.5, -1.0,2e-1  0.1, 4");
+  octDouble v[6];
+
+  int n5 = octParam_readValues(line, "Refinement sphere:", v, 5);
+
+  mu_assert(n5 == 5, "Wrong number of values read");
+  mu_assert(v[0] == 0.5 && v[1] == -1.0 && v[2] == 0.2, 
+      "Wrong coordinates read");
+  mu_assert(v[3] == 0.1 && v[4] == 4.0, 
+      "Wrong radius or level read");
+
+  int n6 = octParam_readValues(line, "Refinement sphere:", v, 6);
+  int nx = octParam_readValues(line, "Refinement box:", v, 7);
+
+  bdestroy(line);
+
+  mu_assert(n6 == 5, "Missing value not detected");
+  mu_assert(nx == -1, "Missing instruction not detected");
+
+  return NULL;
+
+} /* test_param_readValues() */
+
+
+/************************************************************
+* Function to test the intersection of refinement zones 
+* with the bounding boxes of quads
+************************************************************/
+char *test_zones_intersect(int argc, char *argv[])
+{
+  /*--------------------------------------------------------
+  | Box with corners in arbitrary order
+  --------------------------------------------------------*/
+  RefineZone_t box = { ZONE_BOX, 
+    { 0.4, 0.2, 0.4, 0.2, 0.4, 0.2, 0.0 }, 3 };
+
+  octDouble lo0[3] = { 0.3, 0.3, 0.3 }, hi0[3] = { 0.5, 0.5, 0.5 };
+  octDouble lo1[3] = { 0.5, 0.3, 0.3 }, hi1[3] = { 0.6, 0.5, 0.5 };
+  octDouble lo2[3] = { 0.1, 0.1, 0.1 }, hi2[3] = { 0.9, 0.9, 0.9 };
+
+  mu_assert(zoneIntersects(&box, lo0, hi0) == 1, 
+      "Overlapping quad not in box");
+  mu_assert(zoneIntersects(&box, lo1, hi1) == 0, 
+      "Quad beside box in box");
+  mu_assert(zoneIntersects(&box, lo2, hi2) == 1, 
+      "Quad containing box not in box");
+
+  /*--------------------------------------------------------
+  | Sphere
+  --------------------------------------------------------*/
+  RefineZone_t sphere = { ZONE_SPHERE, 
+    { 0.5, 0.5, 0.5, 0.1, 0.0, 0.0, 0.0 }, 3 };
+
+  octDouble lo3[3] = { 0.55, 0.55, 0.55 }, hi3[3] = { 0.7, 0.7, 0.7 };
+  octDouble lo4[3] = { 0.58, 0.58, 0.58 }, hi4[3] = { 0.8, 0.8, 0.8 };
+  octDouble lo5[3] = { 0.4,  0.4,  0.4  }, hi5[3] = { 0.6, 0.6, 0.6 };
+
+  mu_assert(zoneIntersects(&sphere, lo3, hi3) == 1, 
+      "Overlapping quad not in sphere");
+  mu_assert(zoneIntersects(&sphere, lo4, hi4) == 0, 
+      "Quad beside sphere in sphere");
+  mu_assert(zoneIntersects(&sphere, lo5, hi5) == 1, 
+      "Quad containing sphere not in sphere");
+
+  /*--------------------------------------------------------
+  | Cylinder along the x-axis
+  --------------------------------------------------------*/
+  RefineZone_t cyl = { ZONE_CYLINDER, 
+    { 0.0, 0.5, 0.5, 1.0, 0.5, 0.5, 0.05 }, 3 };
+
+  octDouble lo6[3] = { 0.45, 0.45, 0.45 }, hi6[3] = { 0.55, 0.55, 0.55 };
+  octDouble lo7[3] = { 0.45, 0.8,  0.45 }, hi7[3] = { 0.55, 0.9,  0.55 };
+  octDouble lo8[3] = { 1.5,  0.45, 0.45 }, hi8[3] = { 1.6,  0.55, 0.55 };
+  octDouble lo9[3] = { 0.95, 0.45, 0.45 }, hi9[3] = { 1.05, 0.55, 0.55 };
+
+  mu_assert(zoneIntersects(&cyl, lo6, hi6) == 1, 
+      "Quad on cylinder axis not in cylinder");
+  mu_assert(zoneIntersects(&cyl, lo7, hi7) == 0, 
+      "Quad beside cylinder in cylinder");
+  mu_assert(zoneIntersects(&cyl, lo8, hi8) == 0, 
+      "Quad behind cylinder end in cylinder");
+  mu_assert(zoneIntersects(&cyl, lo9, hi9) == 1, 
+      "Quad at cylinder end not in cylinder");
+
+  return NULL;
+
+} /* test_zones_intersect() */
+
+
+
+/************************************************************
+* Refinement level for the conservation test 
+************************************************************/
+static int testRefineLevel = 0;
+
+/************************************************************
+* Recursive refinement of the lower half of every tree
+************************************************************/
+static int refine_lowerHalf(p4est_t          *p4est,
+                            p4est_topidx_t    which_tree,
+                            p4est_quadrant_t *q)
+{
+  return ( q->level < testRefineLevel 
+        && q->x < P4EST_ROOT_LEN / 2 );
+
+} /* refine_lowerHalf() */
+
+/************************************************************
+* Coarsening of all families
+************************************************************/
+static int coarsen_all(p4est_t          *p4est,
+                       p4est_topidx_t    which_tree,
+                       p4est_quadrant_t *children[])
+{
+  return 1;
+
+} /* coarsen_all() */
+
+/************************************************************
+* Global volume integrals and extrema of the state 
+* variables, the total volume is stored behind the 
+* integrals in <mass>
+************************************************************/
+static void stateIntegrals(SimData_t *simData,
+                           octDouble  mass[OCT_STATE_VARS+1],
+                           octDouble  vMin[OCT_STATE_VARS],
+                           octDouble  vMax[OCT_STATE_VARS])
+{
+  p4est_t *p4est = simData->p4est;
+
+  octDouble mass_loc[OCT_STATE_VARS+1];
+  octDouble ext_loc[2*OCT_STATE_VARS];
+  octDouble ext[2*OCT_STATE_VARS];
+
+  p4est_topidx_t which_tree;
+  size_t         i;
+  int            j;
+
+  for (j = 0; j < OCT_STATE_VARS; j++)
+  {
+    mass_loc[j]                 = 0.0;
+    ext_loc[j]                  = -DBL_MAX;
+    ext_loc[OCT_STATE_VARS + j] = -DBL_MAX;
+  }
+
+  mass_loc[OCT_STATE_VARS] = 0.0;
+
+  for (which_tree  = p4est->first_local_tree; 
+       which_tree <= p4est->last_local_tree; 
+       which_tree++)
+  {
+    p4est_tree_t     *tree  = p4est_tree_array_index(p4est->trees, 
+                                                     which_tree);
+    p4est_quadrant_t *quads = (p4est_quadrant_t *) 
+                              tree->quadrants.array;
+
+    for (i = 0; i < tree->quadrants.elem_count; i++)
+    {
+      QuadData_t *quadData = (QuadData_t *) quads[i].p.user_data;
+
+      mass_loc[OCT_STATE_VARS] += quadData->volume;
+
+      for (j = 0; j < OCT_STATE_VARS; j++)
+      {
+        const octDouble v = quadData->vars[OCT_SOLVER_VARS + j];
+
+        mass_loc[j] += quadData->volume * v;
+        ext_loc[j]   = MAX(ext_loc[j], -v);
+        ext_loc[OCT_STATE_VARS + j] = 
+          MAX(ext_loc[OCT_STATE_VARS + j], v);
+      }
+    }
+  }
+
+  sc_MPI_Allreduce(mass_loc, mass, OCT_STATE_VARS+1, 
+                   sc_MPI_DOUBLE, sc_MPI_SUM, 
+                   simData->mpiParam->mpiComm);
+
+  sc_MPI_Allreduce(ext_loc, ext, 2*OCT_STATE_VARS, 
+                   sc_MPI_DOUBLE, sc_MPI_MAX, 
+                   simData->mpiParam->mpiComm);
+
+  for (j = 0; j < OCT_STATE_VARS; j++)
+  {
+    vMin[j] = -ext[j];
+    vMax[j] =  ext[OCT_STATE_VARS + j];
+  }
+
+} /* stateIntegrals() */
+
+/************************************************************
+* Function to test, that the transfer of the state between
+* grid levels conserves its volume integral and creates 
+* no new extrema
+************************************************************/
+char *test_adapt_conservation(int argc, char *argv[])
+{
+  SimData_t *simData = init_simData(argc, argv, 
+                                    init_function,
+                                    refine_fn,
+                                    coarse_fn);
+
+  mu_assert(simData != NULL, "Failed to init simulation data");
+
+  p4est_t *p4est = simData->p4est;
+
+  octDouble mass0[OCT_STATE_VARS+1], mass1[OCT_STATE_VARS+1];
+  octDouble vMin0[OCT_STATE_VARS], vMin1[OCT_STATE_VARS];
+  octDouble vMax0[OCT_STATE_VARS], vMax1[OCT_STATE_VARS];
+  octDouble tol = 1.0e-11;
+
+  int nLost    = 0;
+  int nExtrema = 0;
+  int j;
+
+  /*--------------------------------------------------------
+  | Two levels of recursive refinement and 2:1 balance
+  --------------------------------------------------------*/
+  p4est_topidx_t which_tree;
+
+  for (which_tree  = p4est->first_local_tree; 
+       which_tree <= p4est->last_local_tree; 
+       which_tree++)
+  {
+    p4est_tree_t *tree = p4est_tree_array_index(p4est->trees, 
+                                                which_tree);
+    testRefineLevel = MAX(testRefineLevel, tree->maxlevel + 2);
+  }
+
+  stateIntegrals(simData, mass0, vMin0, vMax0);
+
+  limitProlongation(simData);
+
+  p4est_refine_ext(p4est, 1, -1, refine_lowerHalf, 
+                   NULL, interpQuadData);
+  p4est_balance_ext(p4est, P4EST_CONNECT_FACE, 
+                    NULL, interpQuadData);
+
+  stateIntegrals(simData, mass1, vMin1, vMax1);
+
+  for (j = 0; j < OCT_STATE_VARS; j++)
+  {
+    const octDouble scale = MAX(fabs(vMin0[j]), fabs(vMax0[j])) 
+                          + 1.0;
+
+    nLost += ( fabs(mass1[j] - mass0[j]) 
+             > tol * scale * mass0[OCT_STATE_VARS] );
+    nExtrema += ( vMin1[j] < vMin0[j] - tol * scale );
+    nExtrema += ( vMax1[j] > vMax0[j] + tol * scale );
+  }
+
+  /*--------------------------------------------------------
+  | Coarsening of all families
+  --------------------------------------------------------*/
+  p4est_coarsen_ext(p4est, 0, 0, coarsen_all, 
+                    NULL, interpQuadData);
+
+  stateIntegrals(simData, mass1, vMin1, vMax1);
+
+  for (j = 0; j < OCT_STATE_VARS; j++)
+  {
+    const octDouble scale = MAX(fabs(vMin0[j]), fabs(vMax0[j])) 
+                          + 1.0;
+
+    nLost += ( fabs(mass1[j] - mass0[j]) 
+             > tol * scale * mass0[OCT_STATE_VARS] );
+  }
+
+  destroy_ghostData(simData);
+  destroy_simData(simData);
+
+  mu_assert(nLost == 0, 
+      "Volume integral of the state is not conserved");
+  mu_assert(nExtrema == 0, 
+      "Prolongation creates new extrema");
+
+  return NULL;
+
+} /* test_adapt_conservation() */
@@ -8,5 +8,17 @@ char *test_solver_p4est(int argc, char *argv[]);
 
 char *test_solver_init_destroy(int argc, char *argv[]);
 
+char *test_adapt_histogram(int argc, char *argv[]);
+
+char *test_adapt_hysteresis(int argc, char *argv[]);
+
+char *test_solver_partition(int argc, char *argv[]);
+
+char *test_param_readValues(int argc, char *argv[]);
+
+char *test_zones_intersect(int argc, char *argv[]);
+
+char *test_adapt_conservation(int argc, char *argv[]);
+
 
 #endif /* SOLVER_SOLVER_TESTS_H */
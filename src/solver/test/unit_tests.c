@@ -2,6 +2,7 @@
 
 #include "aux/dbg.h"
 #include "aux/minunit.h"
+#include "solver/simData.h"
 
 #include "solver_tests.h"
 
@@ -13,7 +14,13 @@ char *all_tests(int argc, char *argv[])
 {
   mu_suite_start();
 
+  mu_run_test(test_adapt_histogram, argc, argv);
+  mu_run_test(test_adapt_hysteresis, argc, argv);
+  mu_run_test(test_param_readValues, argc, argv);
+  mu_run_test(test_zones_intersect, argc, argv);
   mu_run_test(test_solver_init_destroy, argc, argv);
+  mu_run_test(test_solver_partition, argc, argv);
+  mu_run_test(test_adapt_conservation, argc, argv);
 
   return NULL;
 }
@@ -25,6 +32,16 @@ int main(int argc, char *argv[])
 {
   debug("----- RUNNING %s\n", argv[0]);
 
+  /*--------------------------------------------------------
+  | MPI is initialized once for all tests, such that 
+  | several simulations can be created and destroyed
+  --------------------------------------------------------*/
+  int threadLevel;
+  int mpi_return = sc_MPI_Init_thread(&argc, &argv, 
+                                      sc_MPI_THREAD_SERIALIZED,
+                                      &threadLevel);
+  SC_CHECK_MPI(mpi_return);
+
   char *result;
   result = all_tests(argc, argv);
 
@@ -39,6 +56,9 @@ int main(int argc, char *argv[])
 
   mu_print_tests_run();
 
+  mpi_return = sc_MPI_Finalize();
+  SC_CHECK_MPI(mpi_return);
+
   return 0;
 
 }